@@ -0,0 +1,639 @@
+/*
+Name : app_adv
+
+Description :
+    Advertising and reconnect engine for the BLE HID keyboard. With a bond
+    present, advertising escalates from high duty cycle directed
+    advertising to the bonded host, to connectable advertising filtered on
+    the accept list, and only then to general undirected advertising, so a
+    bonded host reconnects as fast as possible after wake. General
+    advertising then backs off from fast to slow to very slow (or stops),
+    each stage with its own interval and TX power, all on one extended
+    advertising set that is reconfigured between stages. A key press
+    restarts fast advertising.
+
+Date : 2026-10-14
+
+Developer : Engineer Akbar Shah
+*/
+
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/bluetooth/gap.h>
+#include <zephyr/bluetooth/hci.h>
+#include <zephyr/bluetooth/uuid.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#if CONFIG_BT_CTLR_TX_PWR_DYNAMIC_CONTROL
+#include <zephyr/bluetooth/hci_vs.h>
+#include <zephyr/net_buf.h>
+#include <zephyr/sys/byteorder.h>
+#endif
+
+#include "app_adv.h"
+#include "app_ble.h"
+#include "app_energy.h"
+#include "app_events.h"
+#include "app_hosts.h"
+#include "app_sleep.h"
+#include "app_wake.h"
+
+LOG_MODULE_REGISTER(APP_ADV);
+
+#define DEVICE_NAME CONFIG_BT_DEVICE_NAME
+#define DEVICE_NAME_LEN (sizeof(DEVICE_NAME) - 1)
+
+static const struct bt_data ad[] = {
+    BT_DATA_BYTES(BT_DATA_GAP_APPEARANCE,
+                  (CONFIG_BT_DEVICE_APPEARANCE >> 0) & 0xff,
+                  (CONFIG_BT_DEVICE_APPEARANCE >> 8) & 0xff),
+    BT_DATA_BYTES(BT_DATA_FLAGS, (BT_LE_AD_GENERAL | BT_LE_AD_NO_BREDR)),
+    BT_DATA_BYTES(BT_DATA_UUID16_ALL, BT_UUID_16_ENCODE(BT_UUID_HIDS_VAL),
+                  BT_UUID_16_ENCODE(BT_UUID_BAS_VAL)),
+};
+
+static const struct bt_data sd[] = {
+    BT_DATA(BT_DATA_NAME_COMPLETE, DEVICE_NAME, DEVICE_NAME_LEN),
+};
+
+enum adv_stage
+{
+    ADV_STAGE_DIRECTED = 0, /* High duty directed to the bond, 1.28 s     */
+    ADV_STAGE_ALLOW_LIST,   /* Accept-list filtered, APP_ADV_ALLOW_LIST_MS */
+    ADV_STAGE_FAST,         /* General, fast interval, APP_ADV_FAST_S      */
+    ADV_STAGE_SLOW,         /* General, slow interval, APP_ADV_SLOW_S      */
+    ADV_STAGE_VERY_SLOW,    /* General, APP_ADV_VERY_SLOW_S (0: forever)   */
+    ADV_STAGE_STOPPED,      /* Backed off completely until a key press     */
+    ADV_STAGE_NONE,         /* Connected, or stopped before power off      */
+};
+
+/* Advertising interval in 0.625 ms units from milliseconds */
+#define ADV_INTERVAL_MS(ms) ((ms) * 8 / 5)
+
+#define ADV_DIRECTED_PERIOD_US 3750U /* high duty cycle directed advertising, at most */
+#define ADV_DELAY_MEAN_US 5000U      /* mean of the 0..10 ms random advDelay per event */
+
+struct adv_stage_cfg
+{
+    const char *name;
+    uint16_t interval_min; /* 0.625 ms units */
+    uint16_t interval_max;
+    uint32_t duration_ms; /* 0: stage skipped (forever for the very slow stage) */
+    int8_t tx_power;      /* dBm */
+};
+
+static const struct adv_stage_cfg stage_cfg[] = {
+    [ADV_STAGE_DIRECTED] = {"directed", 0, 0, 1280, CONFIG_APP_ADV_FAST_TX_POWER},
+    [ADV_STAGE_ALLOW_LIST] = {"allow-list", BT_GAP_ADV_FAST_INT_MIN_1, BT_GAP_ADV_FAST_INT_MAX_1,
+                              CONFIG_APP_ADV_ALLOW_LIST_MS, CONFIG_APP_ADV_FAST_TX_POWER},
+    [ADV_STAGE_FAST] = {"fast", BT_GAP_ADV_FAST_INT_MIN_2, BT_GAP_ADV_FAST_INT_MAX_2,
+                        CONFIG_APP_ADV_FAST_S * 1000U, CONFIG_APP_ADV_FAST_TX_POWER},
+    [ADV_STAGE_SLOW] = {"slow", ADV_INTERVAL_MS(CONFIG_APP_ADV_SLOW_INTERVAL_MS),
+                        ADV_INTERVAL_MS(CONFIG_APP_ADV_SLOW_INTERVAL_MS * 11 / 10),
+                        CONFIG_APP_ADV_SLOW_S * 1000U, CONFIG_APP_ADV_SLOW_TX_POWER},
+    [ADV_STAGE_VERY_SLOW] = {"very slow", ADV_INTERVAL_MS(CONFIG_APP_ADV_VERY_SLOW_INTERVAL_MS),
+                             ADV_INTERVAL_MS(CONFIG_APP_ADV_VERY_SLOW_INTERVAL_MS * 11 / 10),
+                             CONFIG_APP_ADV_VERY_SLOW_S * 1000U, CONFIG_APP_ADV_VERY_SLOW_TX_POWER},
+};
+
+BUILD_ASSERT(ARRAY_SIZE(stage_cfg) == ADV_STAGE_STOPPED);
+
+static struct bt_le_ext_adv *adv_set;
+static bt_addr_le_t adv_peer;
+static bool adv_has_peer;
+static bool adv_peer_rpa; /* adv_peer uses a resolvable private address: no directed stage */
+
+/* Stage currently advertising; ADV_STAGE_NONE while connected or stopped on purpose */
+static volatile enum adv_stage adv_current = ADV_STAGE_NONE;
+
+/* Requests to the stage work, set from Bluetooth callbacks */
+#define ADV_REQ_RESTART BIT(0)
+static atomic_t adv_req;
+static atomic_t adv_expired = ATOMIC_INIT(ADV_STAGE_NONE); /* Stage whose time ran out */
+
+static void adv_sent(struct bt_le_ext_adv *adv, struct bt_le_ext_adv_sent_info *info);
+static void adv_stage_work_fn(struct k_work *work);
+static K_WORK_DEFINE(adv_stage_work, adv_stage_work_fn);
+
+/*
+Function : adv_state_set
+
+Description :
+    Updates the global advertising flag and posts APP_EVT_ADV_STATE when it
+    changes, so the main thread only wakes up on a real transition. The
+    mean event period of the stage is handed to the energy accounting.
+
+Parameter :
+    on : true while the advertising set is enabled
+
+Return :
+    void
+
+Example Call :
+    adv_state_set(true);
+*/
+static void adv_state_set(bool on)
+{
+    if (is_adv != on)
+    {
+        uint32_t period_us = 0;
+
+        if (on && (adv_current == ADV_STAGE_DIRECTED))
+        {
+            period_us = ADV_DIRECTED_PERIOD_US;
+        }
+        else if (on && (adv_current < ADV_STAGE_STOPPED))
+        {
+            period_us = (((uint32_t)stage_cfg[adv_current].interval_min +
+                          stage_cfg[adv_current].interval_max) * 625U / 2U) + ADV_DELAY_MEAN_US;
+        }
+        energy_adv_set(period_us);
+
+        is_adv = on;
+        app_event_post(APP_EVT_ADV_STATE);
+    }
+}
+
+/*
+Function : bond_first
+
+Description :
+    bt_foreach_bond() callback keeping the first bonded address found.
+
+Parameter :
+    info      : Bond information
+    user_data : Pointer to the output address, BT_ADDR_LE_ANY until set
+
+Return :
+    void
+
+Example Call :
+    bt_foreach_bond(BT_ID_DEFAULT, bond_first, &peer);
+*/
+static void bond_first(const struct bt_bond_info *info, void *user_data)
+{
+    bt_addr_le_t *peer = user_data;
+
+    if (bt_addr_le_eq(peer, BT_ADDR_LE_ANY))
+    {
+        bt_addr_le_copy(peer, &info->addr);
+    }
+}
+
+/*
+Function : adv_peer_lookup
+
+Description :
+    Finds the host to reconnect to: the active host slot in multi-host
+    builds, otherwise the host of the last secured link (kept across
+    system-off in the wake context) while it is still bonded, or else the
+    first bonded peer.
+
+    Directed advertising targets the identity address, which a host using
+    a resolvable private address does not answer to, so such hosts are
+    flagged in rpa. The first bonded peer is not known to be without one
+    and is flagged too; the accept list resolves either through the
+    controller's resolving list.
+
+Parameter :
+    peer : Output address
+    rpa  : Set to true if directed advertising must not target the peer
+
+Return :
+    bool : true if there is a bonded host to reconnect to
+
+Example Call :
+    if (adv_peer_lookup(&adv_peer, &adv_peer_rpa)) { ... }
+*/
+static bool adv_peer_lookup(bt_addr_le_t *peer, bool *rpa)
+{
+    const struct wake_ctx *ctx = wake_ctx_get();
+
+    if (IS_ENABLED(CONFIG_APP_MULTI_HOST))
+    {
+        return hosts_active_peer(peer, rpa);
+    }
+
+    if (!bt_addr_le_eq(&ctx->host, BT_ADDR_LE_ANY) && bt_le_bond_exists(BT_ID_DEFAULT, &ctx->host))
+    {
+        bt_addr_le_copy(peer, &ctx->host);
+        *rpa = ctx->host_rpa;
+        return true;
+    }
+
+    *rpa = true;
+    bt_addr_le_copy(peer, BT_ADDR_LE_ANY);
+    bt_foreach_bond(BT_ID_DEFAULT, bond_first, peer);
+    return !bt_addr_le_eq(peer, BT_ADDR_LE_ANY);
+}
+
+/*
+Function : adv_tx_power_set
+
+Description :
+    Sets the TX power of the advertising set through the Zephyr vendor
+    specific HCI command. Without dynamic TX power control in the
+    controller this is a no-op and the default TX power is used.
+
+Parameter :
+    dbm : TX power in dBm
+
+Return :
+    void
+
+Example Call :
+    adv_tx_power_set(-8);
+*/
+static void adv_tx_power_set(int8_t dbm)
+{
+#if CONFIG_BT_CTLR_TX_PWR_DYNAMIC_CONTROL
+    struct bt_hci_cp_vs_write_tx_power_level *cp;
+    struct net_buf *buf;
+    uint8_t handle;
+    int err;
+
+    if (bt_hci_get_adv_handle(adv_set, &handle))
+    {
+        return;
+    }
+
+    buf = bt_hci_cmd_create(BT_HCI_OP_VS_WRITE_TX_POWER_LEVEL, sizeof(*cp));
+    if (!buf)
+    {
+        return;
+    }
+    cp = net_buf_add(buf, sizeof(*cp));
+    cp->handle = sys_cpu_to_le16(handle);
+    cp->handle_type = BT_HCI_VS_LL_HANDLE_TYPE_ADV;
+    cp->tx_power_level = dbm;
+
+    err = bt_hci_cmd_send_sync(BT_HCI_OP_VS_WRITE_TX_POWER_LEVEL, buf, NULL);
+    if (err)
+    {
+        LOG_WRN("Advertising TX power not set (err %d)", err);
+    }
+#else
+    ARG_UNUSED(dbm);
+#endif
+}
+
+/*
+Function : adv_stage_start
+
+Description :
+    Reconfigures the advertising set for one stage and enables it. The
+    stage duration is handed to the controller as the set timeout, so the
+    set stops on its own and the sent callback moves on to the next stage.
+
+Parameter :
+    stage : Stage to start
+
+Return :
+    int : 0 on success, -ENOENT if the stage does not apply, other negative
+          error code on failure
+
+Example Call :
+    err = adv_stage_start(ADV_STAGE_FAST);
+*/
+static int adv_stage_start(enum adv_stage stage)
+{
+    const struct adv_stage_cfg *cfg = &stage_cfg[stage];
+    struct bt_le_adv_param param = BT_LE_ADV_PARAM_INIT(BT_LE_ADV_OPT_CONN,
+                                                        cfg->interval_min,
+                                                        cfg->interval_max,
+                                                        NULL);
+    uint16_t timeout = cfg->duration_ms / 10U;
+    int err;
+
+    switch (stage)
+    {
+    case ADV_STAGE_DIRECTED:
+        if (!adv_has_peer || adv_peer_rpa)
+        {
+            return -ENOENT;
+        }
+        param.peer = &adv_peer; /* high duty cycle, ends itself after 1.28 s */
+        timeout = 0;
+        break;
+
+    case ADV_STAGE_ALLOW_LIST:
+#if CONFIG_BT_FILTER_ACCEPT_LIST
+        if (!adv_has_peer || !cfg->duration_ms)
+        {
+            return -ENOENT;
+        }
+        err = bt_le_filter_accept_list_clear();
+        if (!err)
+        {
+            err = bt_le_filter_accept_list_add(&adv_peer);
+        }
+        if (err)
+        {
+            return err;
+        }
+        param.options |= BT_LE_ADV_OPT_FILTER_CONN;
+        break;
+#else
+        return -ENOENT;
+#endif
+
+    case ADV_STAGE_FAST:
+    case ADV_STAGE_SLOW:
+        if (!cfg->duration_ms)
+        {
+            return -ENOENT;
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    err = bt_le_ext_adv_update_param(adv_set, &param);
+    if (!err && !param.peer)
+    {
+        err = bt_le_ext_adv_set_data(adv_set, ad, ARRAY_SIZE(ad), sd, ARRAY_SIZE(sd));
+    }
+    if (err)
+    {
+        return err;
+    }
+
+    adv_tx_power_set(cfg->tx_power);
+    return bt_le_ext_adv_start(adv_set, BT_LE_EXT_ADV_START_PARAM(timeout, 0));
+}
+
+/*
+Function : adv_stage_run
+
+Description :
+    Starts the given advertising stage, falling through to the next stage
+    whenever one does not apply or cannot be started. Past the last stage
+    advertising stays off until the next key press. Updates the global
+    advertising state flag.
+
+Parameter :
+    stage : First stage to try
+
+Return :
+    void
+
+Example Call :
+    adv_stage_run(ADV_STAGE_DIRECTED);
+*/
+static void adv_stage_run(enum adv_stage stage)
+{
+    for (; stage < ADV_STAGE_STOPPED; stage++)
+    {
+        int err = adv_stage_start(stage);
+
+        if (!err)
+        {
+            adv_current = stage;
+            adv_state_set(true);
+            LOG_INF("Advertising (%s) successfully started\n", stage_cfg[stage].name);
+            return;
+        }
+        if (err != -ENOENT)
+        {
+            LOG_INF("Advertising (%s) failed to start (err %d)\n", stage_cfg[stage].name, err);
+        }
+    }
+
+    adv_current = ADV_STAGE_STOPPED;
+    adv_state_set(false);
+    LOG_INF("Advertising stopped, press a key to restart\n");
+    power_tier_update(); /* nothing left to stay up for */
+}
+
+/*
+Function : adv_stage_work_fn
+
+Description :
+    Serialises every advertising change on the system workqueue: creates
+    the advertising set on first use, restarts the stage sequence on
+    request, and moves on to the next stage when the current one expired.
+
+Parameter :
+    work : Pointer to the work item (unused)
+
+Return :
+    void
+
+Example Call :
+    k_work_submit(&adv_stage_work);
+*/
+static void adv_stage_work_fn(struct k_work *work)
+{
+    enum adv_stage expired = (enum adv_stage)atomic_set(&adv_expired, ADV_STAGE_NONE);
+    int err;
+
+    ARG_UNUSED(work);
+
+    if (!adv_set)
+    {
+        static const struct bt_le_ext_adv_cb adv_cb = {
+            .sent = adv_sent,
+        };
+
+        err = bt_le_ext_adv_create(BT_LE_ADV_PARAM(BT_LE_ADV_OPT_CONN,
+                                                   BT_GAP_ADV_FAST_INT_MIN_2,
+                                                   BT_GAP_ADV_FAST_INT_MAX_2,
+                                                   NULL),
+                                   &adv_cb, &adv_set);
+        if (err)
+        {
+            LOG_ERR("Advertising set create failed (err %d)", err);
+            return;
+        }
+    }
+
+    if (atomic_and(&adv_req, ~ADV_REQ_RESTART) & ADV_REQ_RESTART)
+    {
+        if (is_adv)
+        {
+            (void)bt_le_ext_adv_stop(adv_set);
+            adv_state_set(false);
+        }
+        adv_has_peer = adv_peer_lookup(&adv_peer, &adv_peer_rpa);
+        adv_stage_run(adv_has_peer ? ADV_STAGE_DIRECTED : ADV_STAGE_FAST);
+    }
+    else if (expired == adv_current && expired < ADV_STAGE_STOPPED)
+    {
+        /* The controller already disabled the set when its timeout ran out */
+        adv_state_set(false);
+        adv_stage_run(expired + 1);
+    }
+}
+
+/*
+Function : adv_sent
+
+Description :
+    Advertising set callback, called when the set stopped because the
+    stage timeout ran out. Hands the stage change to the stage work.
+
+Parameter :
+    adv  : Advertising set
+    info : Number of advertising events sent
+
+Return :
+    void
+
+Example Call :
+    registered in bt_le_ext_adv_cb
+*/
+static void adv_sent(struct bt_le_ext_adv *adv, struct bt_le_ext_adv_sent_info *info)
+{
+    ARG_UNUSED(adv);
+    ARG_UNUSED(info);
+
+    atomic_set(&adv_expired, adv_current);
+    k_work_submit(&adv_stage_work);
+}
+
+/*
+Function : advertising_start
+
+Description :
+    Starts advertising for the next connection: directed, then accept-list
+    advertising when a bonded host is known, then fast, slow and very slow
+    general advertising.
+
+Parameter :
+    None
+
+Return :
+    void
+
+Example Call :
+    advertising_start();
+*/
+void advertising_start(void)
+{
+    atomic_or(&adv_req, ADV_REQ_RESTART);
+    k_work_submit(&adv_stage_work);
+}
+
+/*
+Function : adv_activity
+
+Description :
+    Key press hook while no host is connected. If advertising has backed
+    off to a slow stage or stopped, it is restarted from the first stage.
+
+Parameter :
+    None
+
+Return :
+    void
+
+Example Call :
+    adv_activity();
+*/
+void adv_activity(void)
+{
+    enum adv_stage cur = adv_current;
+
+    if (cur != ADV_STAGE_NONE && cur >= ADV_STAGE_SLOW)
+    {
+        advertising_start();
+    }
+}
+
+/*
+Function : adv_schedule_running
+
+Description :
+    Tells whether the advertising schedule is still running (or about to
+    restart), i.e. a host may still connect. The power manager keeps the
+    device out of system-off meanwhile.
+
+Parameter :
+    None
+
+Return :
+    bool : true while a stage advertises or a restart is pending
+
+Example Call :
+    if (!adv_schedule_running()) { ... }
+*/
+bool adv_schedule_running(void)
+{
+    return (adv_current < ADV_STAGE_STOPPED) || (atomic_get(&adv_req) & ADV_REQ_RESTART);
+}
+
+/*
+Function : adv_directed_timeout
+
+Description :
+    Called when the directed stage timed out without the host connecting.
+    Moves on to the accept-list stage.
+
+Parameter :
+    None
+
+Return :
+    void
+
+Example Call :
+    adv_directed_timeout();
+*/
+void adv_directed_timeout(void)
+{
+    atomic_set(&adv_expired, ADV_STAGE_DIRECTED);
+    k_work_submit(&adv_stage_work);
+}
+
+/*
+Function : adv_connected
+
+Description :
+    Called on a new connection. The controller has already stopped the
+    advertising set; this only drops the stage state so no stale expiry
+    restarts it.
+
+Parameter :
+    None
+
+Return :
+    void
+
+Example Call :
+    adv_connected();
+*/
+void adv_connected(void)
+{
+    adv_current = ADV_STAGE_NONE;
+    adv_state_set(false);
+}
+
+/*
+Function : adv_stop
+
+Description :
+    Stops advertising and any pending stage change, e.g. before the device
+    powers off.
+
+Parameter :
+    None
+
+Return :
+    void
+
+Example Call :
+    adv_stop();
+*/
+void adv_stop(void)
+{
+    atomic_clear(&adv_req);
+    atomic_set(&adv_expired, ADV_STAGE_NONE);
+    k_work_cancel(&adv_stage_work);
+    adv_current = ADV_STAGE_NONE;
+    if (adv_set)
+    {
+        (void)bt_le_ext_adv_stop(adv_set); /* ok if already stopped */
+    }
+    adv_state_set(false);
+}
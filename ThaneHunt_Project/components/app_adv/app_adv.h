@@ -0,0 +1,32 @@
+/*
+Name : app_adv
+
+Description :
+    Advertising and reconnect engine for the BLE HID keyboard. With a bond
+    present, advertising escalates from high duty cycle directed
+    advertising to the bonded host, to connectable advertising filtered on
+    the accept list, and only then to general undirected advertising, so a
+    bonded host reconnects as fast as possible after wake. General
+    advertising then backs off from fast to slow to very slow (or stops),
+    each stage with its own interval and TX power, all on one extended
+    advertising set that is reconfigured between stages. A key press
+    restarts fast advertising.
+
+Date : 2026-10-14
+
+Developer : Engineer Akbar Shah
+*/
+
+#ifndef APP_ADV_H
+#define APP_ADV_H
+
+#include <stdbool.h>
+
+void advertising_start(void);
+void adv_activity(void);
+void adv_directed_timeout(void);
+void adv_connected(void);
+void adv_stop(void);
+bool adv_schedule_running(void);
+
+#endif // APP_ADV_H
@@ -0,0 +1,267 @@
+/*
+Name : app_battery
+
+Description :
+    Battery measurement for the BLE HID keyboard. The battery voltage is
+    sampled on the nRF54 SAADC (first io-channels entry of the zephyr,user
+    node) at a low duty cycle, smoothed with an exponential moving average
+    and mapped to a state of charge through a piecewise linear discharge
+    curve. The Battery Service level is only updated, and therefore only
+    notified, when the percentage moves past a hysteresis threshold.
+
+Date : 2026-10-14
+
+Developer : Engineer Akbar Shah
+*/
+
+#include <stdlib.h>
+#include <zephyr/bluetooth/services/bas.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/drivers/adc.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#include "app_battery.h"
+
+LOG_MODULE_REGISTER(APP_BATTERY);
+
+#define BATTERY_USER_NODE DT_PATH(zephyr_user)
+
+#define BATTERY_EMA_SHIFT 2              /* EMA weight of a new sample: 1/4 */
+#define BATTERY_DIVIDER_X1000 CONFIG_APP_BATTERY_DIVIDER_X1000 /* Vbat / Vadc * 1000 */
+
+struct battery_curve_point
+{
+    uint16_t mv;
+    uint8_t pct;
+};
+
+/*
+ * Typical 1S Li-Po discharge curve at light load, highest voltage first.
+ * Percentages in between are interpolated linearly.
+ */
+static const struct battery_curve_point battery_curve[] = {
+    {4200, 100},
+    {4100, 92},
+    {4000, 82},
+    {3900, 70},
+    {3800, 56},
+    {3750, 46},
+    {3700, 35},
+    {3650, 24},
+    {3600, 15},
+    {3500, 7},
+    {3400, 3},
+    {3300, 0},
+};
+
+static const struct adc_dt_spec battery_adc = ADC_DT_SPEC_GET_BY_IDX(BATTERY_USER_NODE, 0);
+
+static int16_t battery_sample_buf;
+static struct adc_sequence battery_seq = {
+    .buffer = &battery_sample_buf,
+    .buffer_size = sizeof(battery_sample_buf),
+};
+
+static int32_t battery_mv_filtered = -1; /* -1 until the first sample */
+static int battery_pct_reported = -1;    /* last level handed to BAS */
+
+static void battery_work_fn(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(battery_work, battery_work_fn);
+
+/*
+Function : battery_mv_to_pct
+
+Description :
+    Maps a battery voltage to a state of charge using the discharge curve.
+
+Parameter :
+    mv : Battery voltage in millivolts
+
+Return :
+    uint8_t : State of charge, 0..100 %
+
+Example Call :
+    uint8_t pct = battery_mv_to_pct(3850);
+*/
+static uint8_t battery_mv_to_pct(int32_t mv)
+{
+    if (mv >= battery_curve[0].mv)
+    {
+        return battery_curve[0].pct;
+    }
+
+    for (size_t i = 1; i < ARRAY_SIZE(battery_curve); i++)
+    {
+        const struct battery_curve_point *hi = &battery_curve[i - 1];
+        const struct battery_curve_point *lo = &battery_curve[i];
+
+        if (mv >= lo->mv)
+        {
+            return lo->pct + ((mv - lo->mv) * (hi->pct - lo->pct)) / (hi->mv - lo->mv);
+        }
+    }
+
+    return 0;
+}
+
+/*
+Function : battery_sample
+
+Description :
+    Takes one oversampled SAADC reading and converts it to the battery
+    voltage, undoing the external divider.
+
+Parameter :
+    mv : Output battery voltage in millivolts
+
+Return :
+    int : 0 on success, negative errno on failure
+
+Example Call :
+    int32_t mv;
+    int err = battery_sample(&mv);
+*/
+static int battery_sample(int32_t *mv)
+{
+    int32_t val;
+    int err;
+
+    err = adc_read_dt(&battery_adc, &battery_seq);
+    if (err)
+    {
+        return err;
+    }
+
+    val = battery_sample_buf;
+    err = adc_raw_to_millivolts_dt(&battery_adc, &val);
+    if (err)
+    {
+        return err;
+    }
+
+    *mv = (val * BATTERY_DIVIDER_X1000) / 1000;
+    return 0;
+}
+
+/*
+Function : battery_work_fn
+
+Description :
+    Periodic battery work. Samples the voltage, feeds the moving average
+    and updates the Battery Service level when the percentage has moved by
+    at least CONFIG_APP_BATTERY_HYSTERESIS_PCT since the last update, so
+    sample noise around a step boundary does not turn into notifications.
+
+Parameter :
+    work : Pointer to the work item (unused)
+
+Return :
+    void
+
+Example Call :
+    k_work_schedule(&battery_work, K_NO_WAIT);
+*/
+static void battery_work_fn(struct k_work *work)
+{
+    int32_t mv;
+    int err;
+
+    ARG_UNUSED(work);
+
+    err = battery_sample(&mv);
+    if (err)
+    {
+        LOG_WRN("Battery sample failed (err %d)\n", err);
+    }
+    else
+    {
+        if (battery_mv_filtered < 0)
+        {
+            battery_mv_filtered = mv; /* seed the filter */
+        }
+        else
+        {
+            battery_mv_filtered += (mv - battery_mv_filtered) >> BATTERY_EMA_SHIFT;
+        }
+
+        int pct = battery_mv_to_pct(battery_mv_filtered);
+
+        /* Empty and full are always reported, whatever the step */
+        if (pct != battery_pct_reported &&
+            (battery_pct_reported < 0 || pct == 0 || pct == 100 ||
+             abs(pct - battery_pct_reported) >= CONFIG_APP_BATTERY_HYSTERESIS_PCT))
+        {
+            battery_pct_reported = pct;
+            (void)bt_bas_set_battery_level(pct); /* notifies subscribed hosts */
+            LOG_INF("Battery %d mV, %d%%\n", battery_mv_filtered, pct);
+        }
+    }
+
+    k_work_schedule(&battery_work, K_SECONDS(CONFIG_APP_BATTERY_SAMPLE_S));
+}
+
+/*
+Function : battery_init
+
+Description :
+    Sets up the SAADC channel and schedules the first sample right away, so
+    the Battery Service holds a real level before a host reads it.
+
+Parameter :
+    None
+
+Return :
+    int : 0 on success, negative errno on failure
+
+Example Call :
+    int err = battery_init();
+*/
+int battery_init(void)
+{
+    int err;
+
+    if (!adc_is_ready_dt(&battery_adc))
+    {
+        LOG_ERR("Battery ADC is not ready\n");
+        return -ENODEV;
+    }
+
+    err = adc_channel_setup_dt(&battery_adc);
+    if (err)
+    {
+        LOG_ERR("Battery ADC channel setup failed (err %d)\n", err);
+        return err;
+    }
+
+    err = adc_sequence_init_dt(&battery_adc, &battery_seq);
+    if (err)
+    {
+        return err;
+    }
+
+    k_work_schedule(&battery_work, K_NO_WAIT);
+    return 0;
+}
+
+/*
+Function : battery_millivolts_get
+
+Description :
+    Returns the filtered battery voltage.
+
+Parameter :
+    None
+
+Return :
+    int : Battery voltage in millivolts, -EAGAIN before the first sample
+
+Example Call :
+    int mv = battery_millivolts_get();
+*/
+int battery_millivolts_get(void)
+{
+    int32_t mv = battery_mv_filtered;
+
+    return (mv < 0) ? -EAGAIN : (int)mv;
+}
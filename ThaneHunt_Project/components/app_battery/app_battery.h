@@ -0,0 +1,31 @@
+/*
+Name : app_battery
+
+Description :
+    Battery measurement for the BLE HID keyboard. The battery voltage is
+    sampled on the nRF54 SAADC (first io-channels entry of the zephyr,user
+    node) at a low duty cycle, smoothed with an exponential moving average
+    and mapped to a state of charge through a piecewise linear discharge
+    curve. The Battery Service level is only updated, and therefore only
+    notified, when the percentage moves past a hysteresis threshold.
+
+Date : 2026-10-14
+
+Developer : Engineer Akbar Shah
+*/
+
+#ifndef APP_BATTERY_H
+#define APP_BATTERY_H
+
+#include <errno.h>
+#include <stdint.h>
+
+#if CONFIG_APP_BATTERY
+int battery_init(void);
+int battery_millivolts_get(void);
+#else
+static inline int battery_init(void) { return 0; }
+static inline int battery_millivolts_get(void) { return -ENOTSUP; }
+#endif
+
+#endif // APP_BATTERY_H
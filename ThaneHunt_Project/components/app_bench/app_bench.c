@@ -0,0 +1,489 @@
+/*
+Name : app_bench
+
+Description :
+    Synthetic key event injector for the HID benchmark build
+    (bench.conf). A run steps through a pattern at a fixed rate: a single
+    tap, a rollover chord (width keys pressed together, then released
+    together) or a burst (width taps back to back, as a macro would type
+    them). Keys cycle through CONFIG_APP_BENCH_KEYS key IDs from
+    CONFIG_APP_BENCH_KEY_FIRST, so the host can tell the keystrokes apart
+    and line them up with the schedule. The step timer and the release
+    timer queue key events into an SPSC ring read by the button thread
+    after the GPIO and matrix rings: injected keys take the full path
+    (keymap, coalescing, HID TX queue, radio) and open a latency trace
+    each. The "bench" shell commands start and stop runs and print the
+    injector, HID TX and link figures of the last run.
+
+Date : 2026-10-14
+
+Developer : Engineer Akbar Shah
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/bluetooth/gap.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
+#include <zephyr/sys/spsc_lockfree.h>
+
+#include "app_bench.h"
+#include "app_ble.h"
+#include "app_button.h"
+#include "app_hid.h"
+#include "app_latency.h"
+
+LOG_MODULE_REGISTER(APP_BENCH);
+
+#define BENCH_KEY_FIRST CONFIG_APP_BENCH_KEY_FIRST
+#define BENCH_KEYS CONFIG_APP_BENCH_KEYS
+#define BENCH_WIDTH_MAX 16        /* keys per chord or taps per burst */
+#define BENCH_EVENT_RING_SIZE 64  /* must be a power of two */
+#define BENCH_RATE_MAX_HZ 500     /* steps per second */
+
+BUILD_ASSERT((BENCH_KEY_FIRST + BENCH_KEYS) <= 256, "Key IDs are 8 bit");
+BUILD_ASSERT(BENCH_EVENT_RING_SIZE >= (2 * BENCH_WIDTH_MAX), "A step must fit in the ring");
+
+enum bench_pattern
+{
+    BENCH_PATTERN_TAP = 0,
+    BENCH_PATTERN_CHORD,
+    BENCH_PATTERN_BURST,
+    BENCH_PATTERN_COUNT
+};
+
+static const char *const pattern_name[BENCH_PATTERN_COUNT] = {
+    [BENCH_PATTERN_TAP] = "tap",
+    [BENCH_PATTERN_CHORD] = "chord",
+    [BENCH_PATTERN_BURST] = "burst",
+};
+
+/* Parameters and progress of a run. Written by the shell while stopped, by the timers while running. */
+struct bench_run
+{
+    enum bench_pattern pattern;
+    uint32_t rate_hz;
+    uint32_t count;   /* steps to run */
+    uint32_t step;    /* steps started */
+    uint32_t hold_ms; /* press to release, tap and chord */
+    uint8_t width;
+    uint8_t key;      /* next key, 0..BENCH_KEYS-1 from BENCH_KEY_FIRST */
+    uint8_t held[BENCH_WIDTH_MAX];
+    uint8_t held_cnt;
+};
+
+static struct bench_run run;
+static atomic_t bench_running;
+static uint32_t bench_injected; /* key events queued  */
+static uint32_t bench_overruns; /* key events lost to a full ring */
+static int64_t bench_started;   /* k_uptime_get() at start */
+static int64_t bench_ended;     /* k_uptime_get() at the end, 0 while running */
+static struct hid_tx_stats tx_base; /* HID TX counters at start */
+
+/* Producer: bench timers (system clock interrupt). Consumer: button thread. */
+SPSC_DEFINE(bench_events, struct key_event, BENCH_EVENT_RING_SIZE);
+
+static void bench_step_expiry(struct k_timer *timer);
+static void bench_release_expiry(struct k_timer *timer);
+static void bench_done_fn(struct k_work *work);
+
+static K_TIMER_DEFINE(bench_step_timer, bench_step_expiry, NULL);
+static K_TIMER_DEFINE(bench_release_timer, bench_release_expiry, NULL);
+static K_WORK_DEFINE(bench_done_work, bench_done_fn);
+
+/*
+Function : bench_event_push
+
+Description :
+    Queues one synthetic key change and opens a latency trace for it, the
+    injection standing in for the GPIO edge and the debounce. The caller
+    wakes the button thread once the whole step is queued.
+
+Parameter :
+    key     : Key offset, 0..BENCH_KEYS-1
+    pressed : true for press, false for release
+
+Return :
+    void
+
+Example Call :
+    bench_event_push(run.key, true);
+*/
+static void bench_event_push(uint8_t key, bool pressed)
+{
+    struct key_event *evt = spsc_acquire(&bench_events);
+
+    if (evt == NULL)
+    {
+        bench_overruns++;
+        return;
+    }
+
+    latency_trace_stamp(LATENCY_STAGE_EDGE);
+    evt->key_id = BENCH_KEY_FIRST + key;
+    evt->pressed = pressed;
+    evt->timestamp = k_cycle_get_32();
+    spsc_produce(&bench_events);
+    bench_injected++;
+    latency_trace_stamp(LATENCY_STAGE_DEBOUNCED);
+}
+
+/*
+Function : bench_key_next
+
+Description :
+    Returns the next key of the cycle and advances it.
+
+Parameter :
+    None
+
+Return :
+    uint8_t : Key offset, 0..BENCH_KEYS-1
+
+Example Call :
+    uint8_t key = bench_key_next();
+*/
+static uint8_t bench_key_next(void)
+{
+    uint8_t key = run.key;
+
+    run.key = (run.key + 1U) % BENCH_KEYS;
+    return key;
+}
+
+/*
+Function : bench_release_all
+
+Description :
+    Releases the keys pressed by the current step, in press order.
+
+Parameter :
+    None
+
+Return :
+    void
+
+Example Call :
+    bench_release_all();
+*/
+static void bench_release_all(void)
+{
+    for (uint8_t i = 0; i < run.held_cnt; i++)
+    {
+        bench_event_push(run.held[i], false);
+    }
+    run.held_cnt = 0;
+}
+
+/*
+Function : bench_step_expiry
+
+Description :
+    Step timer, periodic at the run rate. Queues the presses of the next
+    step (and, for a burst, every release too) and starts the release
+    timer for taps and chords. The tick after the last step ends the run.
+    Runs in interrupt context.
+
+Parameter :
+    timer : Step timer (unused)
+
+Return :
+    void
+
+Example Call :
+    started by cmd_bench_start() via k_timer_start()
+*/
+static void bench_step_expiry(struct k_timer *timer)
+{
+    ARG_UNUSED(timer);
+
+    if (run.step == run.count)
+    {
+        k_timer_stop(&bench_step_timer);
+        bench_ended = k_uptime_get();
+        atomic_set(&bench_running, 0);
+        k_work_submit(&bench_done_work);
+        return;
+    }
+    run.step++;
+
+    for (uint8_t i = 0; i < run.width; i++)
+    {
+        uint8_t key = bench_key_next();
+
+        bench_event_push(key, true);
+        if (run.pattern == BENCH_PATTERN_BURST)
+        {
+            bench_event_push(key, false);
+        }
+        else
+        {
+            run.held[run.held_cnt++] = key;
+        }
+    }
+
+    if (run.held_cnt)
+    {
+        k_timer_start(&bench_release_timer, K_MSEC(run.hold_ms), K_NO_WAIT);
+    }
+    button_event_signal();
+}
+
+/*
+Function : bench_release_expiry
+
+Description :
+    Release timer: releases the keys of the current tap or chord. Runs in
+    interrupt context.
+
+Parameter :
+    timer : Release timer (unused)
+
+Return :
+    void
+
+Example Call :
+    started by bench_step_expiry()
+*/
+static void bench_release_expiry(struct k_timer *timer)
+{
+    ARG_UNUSED(timer);
+
+    bench_release_all();
+    button_event_signal();
+}
+
+/*
+Function : bench_done_fn
+
+Description :
+    Logs the end of a run; the shell output is for the operator, this line
+    is what scripts/hid_bench.py waits for. System workqueue.
+
+Parameter :
+    work : Work item (unused)
+
+Return :
+    void
+
+Example Call :
+    submitted by bench_step_expiry()
+*/
+static void bench_done_fn(struct k_work *work)
+{
+    ARG_UNUSED(work);
+
+    LOG_INF("bench done: %u events, %u overruns, %u ms", bench_injected, bench_overruns,
+            (uint32_t)(bench_ended - bench_started));
+}
+
+/*
+Function : bench_event_get
+
+Description :
+    Consumer side of the injector ring, called by the button thread after
+    the GPIO and matrix rings are empty. Lock-free.
+
+Parameter :
+    evt : Output event
+
+Return :
+    bool : true if an event was returned
+
+Example Call :
+    if (bench_event_get(evt)) { ... }
+*/
+bool bench_event_get(struct key_event *evt)
+{
+    struct key_event *slot = spsc_consume(&bench_events);
+
+    if (slot == NULL)
+    {
+        return false;
+    }
+    *evt = *slot;
+    spsc_release(&bench_events);
+    return true;
+}
+
+/*
+Function : bench_stop
+
+Description :
+    Stops a run and releases any key it still holds. Thread context; with
+    both timers stopped the shell is the only producer left.
+
+Parameter :
+    None
+
+Return :
+    bool : true if a run was stopped
+
+Example Call :
+    bench_stop();
+*/
+static bool bench_stop(void)
+{
+    if (!atomic_cas(&bench_running, 1, 0))
+    {
+        return false;
+    }
+    k_timer_stop(&bench_step_timer);
+    k_timer_stop(&bench_release_timer);
+    bench_release_all();
+    button_event_signal();
+    bench_ended = k_uptime_get();
+    return true;
+}
+
+static int cmd_bench_start(const struct shell *sh, size_t argc, char **argv)
+{
+    enum bench_pattern pattern = BENCH_PATTERN_COUNT;
+    uint32_t rate_hz = strtoul(argv[2], NULL, 0);
+    uint32_t count = strtoul(argv[3], NULL, 0);
+    uint32_t width;
+    uint32_t hold_ms = (argc > 5) ? strtoul(argv[5], NULL, 0) : CONFIG_APP_BENCH_HOLD_MS;
+
+    for (size_t p = 0; p < BENCH_PATTERN_COUNT; p++)
+    {
+        if (strcmp(argv[1], pattern_name[p]) == 0)
+        {
+            pattern = p;
+        }
+    }
+    if (pattern == BENCH_PATTERN_COUNT)
+    {
+        shell_error(sh, "unknown pattern %s (tap, chord, burst)", argv[1]);
+        return -EINVAL;
+    }
+
+    width = (argc > 4) ? strtoul(argv[4], NULL, 0) : ((pattern == BENCH_PATTERN_TAP) ? 1 : 6);
+    if (pattern == BENCH_PATTERN_TAP)
+    {
+        width = 1;
+    }
+    if ((rate_hz == 0) || (rate_hz > BENCH_RATE_MAX_HZ) || (count == 0) || (width == 0) ||
+        (width > MIN(BENCH_WIDTH_MAX, BENCH_KEYS)))
+    {
+        shell_error(sh, "rate 1..%u Hz, count > 0, width 1..%u", BENCH_RATE_MAX_HZ,
+                    MIN(BENCH_WIDTH_MAX, BENCH_KEYS));
+        return -EINVAL;
+    }
+    if ((pattern != BENCH_PATTERN_BURST) && ((hold_ms == 0) || (hold_ms >= (MSEC_PER_SEC / rate_hz))))
+    {
+        shell_error(sh, "hold must be 1..%u ms at %u Hz", (MSEC_PER_SEC / rate_hz) - 1U, rate_hz);
+        return -EINVAL;
+    }
+    if (!isBle_connected)
+    {
+        shell_error(sh, "no host connected");
+        return -ENOTCONN;
+    }
+    if (atomic_get(&bench_running))
+    {
+        shell_error(sh, "a run is in progress (bench stop)");
+        return -EBUSY;
+    }
+
+    memset(&run, 0, sizeof(run));
+    run.pattern = pattern;
+    run.rate_hz = rate_hz;
+    run.count = count;
+    run.width = (uint8_t)width;
+    run.hold_ms = hold_ms;
+    bench_injected = 0;
+    bench_overruns = 0;
+    bench_ended = 0;
+    latency_trace_reset();
+    hid_tx_stats_get(&tx_base);
+
+    shell_print(sh, "bench: %s x%u at %u Hz, width %u, hold %u ms", pattern_name[pattern],
+                count, rate_hz, run.width, run.hold_ms);
+    atomic_set(&bench_running, 1);
+    bench_started = k_uptime_get();
+    k_timer_start(&bench_step_timer, K_NO_WAIT, K_USEC(USEC_PER_SEC / rate_hz));
+    return 0;
+}
+
+static int cmd_bench_stop(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    shell_print(sh, "%s", bench_stop() ? "bench stopped" : "no run in progress");
+    return 0;
+}
+
+/*
+Function : bench_link_print
+
+Description :
+    bt_conn_foreach() callback printing the parameters and PHY of a link,
+    so a result can be tied to the link it was measured on.
+
+Parameter :
+    conn : Connection
+    data : Shell to print to
+
+Return :
+    void
+
+Example Call :
+    bt_conn_foreach(BT_CONN_TYPE_LE, bench_link_print, (void *)sh);
+*/
+static void bench_link_print(struct bt_conn *conn, void *data)
+{
+    const struct shell *sh = data;
+    struct ble_link_info link;
+    struct bt_conn_info info;
+
+    if (bt_conn_get_info(conn, &info) || (info.state != BT_CONN_STATE_CONNECTED))
+    {
+        return;
+    }
+    ble_link_info_get(conn, &link);
+    shell_print(sh, "link %u: interval %u us, latency %u, timeout %u ms, phy tx %s rx %s, len %u/%u",
+                bt_conn_index(conn), BT_CONN_INTERVAL_TO_US(info.le.interval), info.le.latency,
+                info.le.timeout * 10U, (link.tx_phy == BT_GAP_LE_PHY_2M) ? "2M" : "1M",
+                (link.rx_phy == BT_GAP_LE_PHY_2M) ? "2M" : "1M", link.tx_len, link.rx_len);
+}
+
+static int cmd_bench_stats(const struct shell *sh, size_t argc, char **argv)
+{
+    struct hid_tx_stats tx;
+    int64_t end = bench_ended ? bench_ended : k_uptime_get();
+    uint32_t elapsed_ms = bench_started ? (uint32_t)(end - bench_started) : 0;
+
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    hid_tx_stats_get(&tx);
+    shell_print(sh, "run: %s, %u/%u steps at %u Hz, width %u, %s", pattern_name[run.pattern],
+                run.step, run.count, run.rate_hz, run.width,
+                atomic_get(&bench_running) ? "running" : "stopped");
+    shell_print(sh, "injected %u events in %u ms, %u overruns", bench_injected, elapsed_ms,
+                bench_overruns);
+    shell_print(sh, "hid: sent %u merged %u flushed %u dropped %u waits %u rejected %u",
+                tx.sent - tx_base.sent, tx.merged - tx_base.merged, tx.flushed - tx_base.flushed,
+                tx.dropped - tx_base.dropped, tx.waits - tx_base.waits,
+                tx.rejected - tx_base.rejected);
+    if (elapsed_ms)
+    {
+        shell_print(sh, "reports/s %u", (uint32_t)(((uint64_t)(tx.sent - tx_base.sent) * MSEC_PER_SEC) /
+                                                   elapsed_ms));
+    }
+    bt_conn_foreach(BT_CONN_TYPE_LE, bench_link_print, (void *)sh);
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_bench,
+                               SHELL_CMD_ARG(start, NULL,
+                                             "<tap|chord|burst> <rate_hz> <count> [width] [hold_ms]",
+                                             cmd_bench_start, 4, 2),
+                               SHELL_CMD(stop, NULL, "Stop the run, release held keys", cmd_bench_stop),
+                               SHELL_CMD(stats, NULL, "Injector, HID TX and link figures", cmd_bench_stats),
+                               SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(bench, &sub_bench, "Synthetic key event benchmark", NULL);
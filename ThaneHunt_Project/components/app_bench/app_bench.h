@@ -0,0 +1,28 @@
+/*
+Name : app_bench
+
+Description :
+    Synthetic key event injector for the HID benchmark build
+    (bench.conf). Timer-driven patterns (single taps, rollover chords,
+    tap bursts) are queued as key events that the button thread takes
+    like real keys, so they go through the keymap, coalescing, the HID TX
+    queue and the radio. Runs are started and read back over the shell;
+    scripts/hid_bench.py captures the result on the host.
+
+Date : 2026-10-14
+
+Developer : Engineer Akbar Shah
+*/
+
+#ifndef APP_BENCH_H
+#define APP_BENCH_H
+
+#include <stdbool.h>
+
+#include "app_button.h"
+
+#if CONFIG_APP_BENCH
+bool bench_event_get(struct key_event *evt);
+#endif
+
+#endif // APP_BENCH_H
@@ -16,7 +16,6 @@ Developer : Engineer Akbar Shah
 #include <zephyr/sys/byteorder.h>
 #include <zephyr/kernel.h>
 
-#include <zephyr/settings/settings.h>
 
 #include <zephyr/bluetooth/bluetooth.h>
 #include <zephyr/bluetooth/hci.h>
@@ -24,83 +23,229 @@ Developer : Engineer Akbar Shah
 #include <zephyr/bluetooth/uuid.h>
 #include <zephyr/bluetooth/gatt.h>
 
-#include <zephyr/bluetooth/services/bas.h>
 #include <bluetooth/services/hids.h>
 #include <zephyr/bluetooth/services/dis.h>
 #include <zephyr/logging/log.h>
 
+#include "app_adv.h"
 #include "app_ble.h"
+#include "app_conn_param.h"
+#include "app_energy.h"
 #include "app_hid.h"
+#include "app_store.h"
+#include "app_wake.h"
 
 LOG_MODULE_REGISTER(APP_BLE);
 
-#define DEVICE_NAME CONFIG_BT_DEVICE_NAME
-#define DEVICE_NAME_LEN (sizeof(DEVICE_NAME) - 1)
-
 volatile bool is_adv;
 volatile bool is_internal_ble_disconnect;
 
 volatile bool isBle_connected;
 
-static const struct bt_data ad[] = {
-    BT_DATA_BYTES(BT_DATA_GAP_APPEARANCE,
-                  (CONFIG_BT_DEVICE_APPEARANCE >> 0) & 0xff,
-                  (CONFIG_BT_DEVICE_APPEARANCE >> 8) & 0xff),
-    BT_DATA_BYTES(BT_DATA_FLAGS, (BT_LE_AD_GENERAL | BT_LE_AD_NO_BREDR)),
-    BT_DATA_BYTES(BT_DATA_UUID16_ALL, BT_UUID_16_ENCODE(BT_UUID_HIDS_VAL),
-                  BT_UUID_16_ENCODE(BT_UUID_BAS_VAL)),
-};
+/* Given once the link is encrypted and HID reports can flow */
+static K_SEM_DEFINE(ble_ready_sem, 0, 1);
 
-struct conn_mode conn_mode[CONFIG_BT_HIDS_MAX_CLIENT_COUNT];
 
-static const struct bt_data sd[] = {
-    BT_DATA(BT_DATA_NAME_COMPLETE, DEVICE_NAME, DEVICE_NAME_LEN),
-};
+/* PHY and data length outcome per connection, indexed by bt_conn_index() */
+static struct ble_link_info link_info[CONFIG_BT_MAX_CONN];
 
 /*
-Function : advertising_start
+Function : link_optimize
 
 Description : 
-    Starts Bluetooth Low Energy (BLE) advertising with predefined advertising
-    and scan response data. Sets advertising parameters and enables connection 
-    mode. Updates the global advertising state flag.
+    Asks the central to move a new link to the LE 2M PHY and to raise the
+    data length so a full HID report fits in one LL packet. If the 2M
+    request cannot be issued the link stays on 1M; either way the outcome
+    is recorded in link_info[] by the update callbacks.
 
 Parameter : 
-    None
+    conn : Pointer to the new Bluetooth connection
 
 Return : 
     void
 
 Example Call : 
-    advertising_start();
+    link_optimize(conn);
 */
-void advertising_start(void)
+static void link_optimize(struct bt_conn *conn)
 {
+    struct ble_link_info *link = &link_info[bt_conn_index(conn)];
     int err;
-    const struct bt_le_adv_param *adv_param = BT_LE_ADV_PARAM(
-        BT_LE_ADV_OPT_CONN,
-        BT_GAP_ADV_FAST_INT_MIN_2,
-        BT_GAP_ADV_FAST_INT_MAX_2,
-        NULL);
-
-    err = bt_le_adv_start(adv_param, ad, ARRAY_SIZE(ad), sd,
-                          ARRAY_SIZE(sd));
+
+    memset(link, 0, sizeof(*link));
+    link->tx_phy = BT_GAP_LE_PHY_1M;
+    link->rx_phy = BT_GAP_LE_PHY_1M;
+    link->tx_len = BT_GAP_DATA_LEN_DEFAULT;
+    link->rx_len = BT_GAP_DATA_LEN_DEFAULT;
+
+#if CONFIG_BT_USER_PHY_UPDATE
+    const struct bt_conn_le_phy_param phy = {
+        .options = BT_CONN_LE_PHY_OPT_NONE,
+        .pref_tx_phy = BT_GAP_LE_PHY_2M,
+        .pref_rx_phy = BT_GAP_LE_PHY_2M,
+    };
+
+    err = bt_conn_le_phy_update(conn, &phy);
     if (err)
     {
-        if (err == -EALREADY)
-        {
-            LOG_INF("Advertising continued\n");
-        }
-        else
-        {
-            LOG_INF("Advertising failed to start (err %d)\n", err);
-        }
+        LOG_WRN("2M PHY request failed (err %d), staying on 1M\n", err);
+    }
+    else
+    {
+        link->phy_2m_requested = true;
+    }
+#endif
 
-        return;
+#if CONFIG_BT_USER_DATA_LEN_UPDATE
+    err = bt_conn_le_data_len_update(conn,
+                                     BT_LE_DATA_LEN_PARAM(CONFIG_BT_BUF_ACL_TX_SIZE,
+                                                          BT_GAP_DATA_TIME_MAX));
+    if (err)
+    {
+        LOG_WRN("Data length update request failed (err %d)\n", err);
     }
+#endif
+    (void)err;
+}
+
+#if CONFIG_BT_USER_PHY_UPDATE
+/*
+Function : le_phy_updated
+
+Description : 
+    Callback executed when the PHY of a link changed. Records the new TX
+    and RX PHY of the connection.
+
+Parameter : 
+    conn  : Pointer to the Bluetooth connection
+    param : New PHY of the link
+
+Return : 
+    void
+
+Example Call : 
+    registered as .le_phy_updated in BT_CONN_CB_DEFINE
+*/
+static void le_phy_updated(struct bt_conn *conn, struct bt_conn_le_phy_info *param)
+{
+    struct ble_link_info *link = &link_info[bt_conn_index(conn)];
+
+    link->tx_phy = param->tx_phy;
+    link->rx_phy = param->rx_phy;
+    LOG_INF("PHY updated: tx %s rx %s\n",
+            (param->tx_phy == BT_GAP_LE_PHY_2M) ? "2M" : "1M",
+            (param->rx_phy == BT_GAP_LE_PHY_2M) ? "2M" : "1M");
+}
+#endif
+
+#if CONFIG_BT_USER_DATA_LEN_UPDATE
+/*
+Function : le_data_len_updated
+
+Description : 
+    Callback executed when the data length of a link changed. Records the
+    new maximum TX and RX payload of the connection.
+
+Parameter : 
+    conn : Pointer to the Bluetooth connection
+    info : New data length of the link
+
+Return : 
+    void
+
+Example Call : 
+    registered as .le_data_len_updated in BT_CONN_CB_DEFINE
+*/
+static void le_data_len_updated(struct bt_conn *conn, struct bt_conn_le_data_len_info *info)
+{
+    struct ble_link_info *link = &link_info[bt_conn_index(conn)];
+
+    link->tx_len = info->tx_max_len;
+    link->rx_len = info->rx_max_len;
+    LOG_INF("Data length updated: tx %u rx %u\n", info->tx_max_len, info->rx_max_len);
+}
+#endif
+
+#if CONFIG_APP_CONN_PARAM || CONFIG_APP_ENERGY
+/*
+Function : le_param_updated
+
+Description : 
+    Callback executed when the central changed the connection parameters.
+    Hands them to the connection parameter policy and to the energy
+    accounting.
+
+Parameter : 
+    conn     : Pointer to the Bluetooth connection
+    interval : New connection interval (1.25 ms units)
+    latency  : New peripheral latency (connection events)
+    timeout  : New supervision timeout (10 ms units)
+
+Return : 
+    void
+
+Example Call : 
+    registered as .le_param_updated in BT_CONN_CB_DEFINE
+*/
+static void le_param_updated(struct bt_conn *conn, uint16_t interval, uint16_t latency,
+                             uint16_t timeout)
+{
+#if CONFIG_APP_CONN_PARAM
+    conn_param_updated(conn, interval, latency, timeout);
+#endif
+    energy_link_params(conn, interval, latency);
+    (void)timeout;
+}
+#endif
+
+/*
+Function : ble_link_info_get
+
+Description : 
+    Returns the PHY and data length recorded for a connection.
+
+Parameter : 
+    conn : Pointer to the Bluetooth connection
+    out  : Output link information
+
+Return : 
+    void
+
+Example Call : 
+    struct ble_link_info link;
+    ble_link_info_get(conn, &link);
+*/
+void ble_link_info_get(struct bt_conn *conn, struct ble_link_info *out)
+{
+    *out = link_info[bt_conn_index(conn)];
+}
+
+/*
+Function : ble_peer_rpa
+
+Description : 
+    Tells whether the peer connected from a resolvable private address,
+    i.e. its over-the-air address differs from its identity address. Such
+    a host does not answer advertising directed at its identity address.
+
+Parameter : 
+    conn : Pointer to the Bluetooth connection
+
+Return : 
+    bool : true if the peer uses a resolvable private address
+
+Example Call : 
+    bool rpa = ble_peer_rpa(conn);
+*/
+bool ble_peer_rpa(struct bt_conn *conn)
+{
+    struct bt_conn_info info;
 
-    is_adv = true;
-    LOG_INF("Advertising successfully started\n");
+    if (bt_conn_get_info(conn, &info))
+    {
+        return false;
+    }
+    return !bt_addr_le_eq(info.le.remote, info.le.dst);
 }
 
 /*
@@ -129,12 +274,23 @@ void connected(struct bt_conn *conn, uint8_t err)
 
     if (err)
     {
+        if (err == BT_HCI_ERR_ADV_TIMEOUT)
+        {
+            /* Directed advertising timed out, the host is not around */
+            adv_directed_timeout();
+            return;
+        }
         LOG_INF("Failed to connect to %s 0x%02x %s\n", addr, err, bt_hci_err_to_str(err));
         return;
     }
 
     LOG_INF("Connected %s\n", addr);
 
+    adv_connected();
+    energy_link_up(conn);
+
+    link_optimize(conn);
+
     err = connect_bt_hid(conn);
 
     if (err)
@@ -143,27 +299,14 @@ void connected(struct bt_conn *conn, uint8_t err)
         return;
     }
 
-    for (size_t i = 0; i < CONFIG_BT_HIDS_MAX_CLIENT_COUNT; i++)
-    {
-        if (!conn_mode[i].conn)
-        {
-            conn_mode[i].conn = conn;
-            conn_mode[i].in_boot_mode = false;
-            break;
-        }
-    }
+    conn_param_connected(conn);
 
 #if CONFIG_NFC_OOB_PAIRING == 0
-    for (size_t i = 0; i < CONFIG_BT_HIDS_MAX_CLIENT_COUNT; i++)
+    if (hid_conn_count() < CONFIG_BT_HIDS_MAX_CLIENT_COUNT)
     {
-        if (!conn_mode[i].conn)
-        {
-            advertising_start();
-            return;
-        }
+        advertising_start();
     }
 #endif
-    is_adv = false;
 }
 
 /*
@@ -171,7 +314,7 @@ Function : disconnected
 
 Description : 
     Callback executed when a BLE connection is terminated. Logs disconnection 
-    reason, notifies the HID service, clears the connection slot, updates global 
+    reason, notifies the HID service (dropping its HID context), updates global 
     connection state, and restarts advertising.
 
 Parameter : 
@@ -186,13 +329,14 @@ Example Call :
 */
 void disconnected(struct bt_conn *conn, uint8_t reason)
 {
+    energy_link_down(conn);
+
     if (is_internal_ble_disconnect)
     {
         is_internal_ble_disconnect = false;
         return;
     }
     int err;
-    bool is_any_dev_connected = false;
     char addr[BT_ADDR_LE_STR_LEN];
 
     bt_addr_le_to_str(bt_conn_get_dst(conn), addr, sizeof(addr));
@@ -206,61 +350,18 @@ void disconnected(struct bt_conn *conn, uint8_t reason)
         LOG_INF("Failed to notify HID service about disconnection\n");
     }
 
-    for (size_t i = 0; i < CONFIG_BT_HIDS_MAX_CLIENT_COUNT; i++)
-    {
-        if (conn_mode[i].conn == conn)
-        {
-            conn_mode[i].conn = NULL;
-        }
-        else
-        {
-            if (conn_mode[i].conn)
-            {
-                is_any_dev_connected = true;
-            }
-        }
-    }
     isBle_connected = false;
+    k_sem_reset(&ble_ready_sem);
     advertising_start();
 }
 
-/*
-Function : bas_notify
-
-Description : 
-    Updates the Battery Service (BAS) value by decrementing the battery level. 
-    When battery level reaches 0, it resets to 100%. Notifies connected devices 
-    about the new battery level.
-
-Parameter : 
-    None
-
-Return : 
-    void
-
-Example Call : 
-    bas_notify();
-*/
-void bas_notify(void)
-{
-    uint8_t battery_level = bt_bas_get_battery_level();
-
-    battery_level--;
-
-    if (!battery_level)
-    {
-        battery_level = 100U;
-    }
-
-    bt_bas_set_battery_level(battery_level);
-}
-
 /*
 Function : enable_bt
 
 Description : 
-    Initializes the Bluetooth stack and loads stored settings if enabled. 
-    Starts BLE advertising after initialization.
+    Initializes the Bluetooth stack and loads stored settings if enabled,
+    from the retained snapshot after a wake from system-off (see
+    app_store). Starts BLE advertising after initialization.
 
 Parameter : 
     None
@@ -283,18 +384,46 @@ int enable_bt(void)
 
     if (IS_ENABLED(CONFIG_SETTINGS))
     {
-        settings_load();
+        (void)store_load();
     }
     advertising_start();
     return err;
 }
 
+/*
+Function : disconnect_one
+
+Description : 
+    bt_conn_foreach() callback of ble_disconnect_safe(). Drops the HID
+    context of a connection and requests the disconnect.
+
+Parameter : 
+    conn : Connection to take down
+    data : Unused
+
+Return : 
+    void
+
+Example Call : 
+    bt_conn_foreach(BT_CONN_TYPE_LE, disconnect_one, NULL);
+*/
+static void disconnect_one(struct bt_conn *conn, void *data)
+{
+    ARG_UNUSED(data);
+
+    /* Notify HID that link is going down (best effort) */
+    (void)disconnect_bt_hid(conn);
+
+    /* Request BLE disconnect (REMOTE_USER is the normal reason) */
+    (void)bt_conn_disconnect(conn, BT_HCI_ERR_REMOTE_USER_TERM_CONN);
+}
+
 /*
 Function : ble_disconnect_safe
 
 Description : 
     Safely disconnects all active BLE connections. Notifies HID service, 
-    requests disconnection, clears stored connection pointers, and stops advertising. 
+    requests disconnection and stops advertising. 
     Ensures internal state consistency with short delays for proper teardown.
 
 Parameter : 
@@ -310,57 +439,29 @@ int ble_disconnect_safe(void)
 {
     is_internal_ble_disconnect = true;
 
-    /* 1) Actively disconnect all known connections (HID rides on GATT) */
-    for (size_t i = 0; i < CONFIG_BT_HIDS_MAX_CLIENT_COUNT; i++)
-    {
-        struct bt_conn *c = conn_mode[i].conn;
-        if (!c)
-        {
-            continue;
-        }
-
-        /* Notify HID that link is going down (best effort) */
-        (void)disconnect_bt_hid(c);
-
-        /* Request BLE disconnect (REMOTE_USER is the normal reason) */
-        (void)bt_conn_disconnect(c, BT_HCI_ERR_REMOTE_USER_TERM_CONN);
-    }
+    /* 1) Actively disconnect all connections (HID rides on GATT) */
+    bt_conn_foreach(BT_CONN_TYPE_LE, disconnect_one, NULL);
 
     /* 2) Short grace period so host/controller can process LL/GATT terminate */
     k_sleep(K_MSEC(100));
 
-    /* 3) Unref and clear stored connection pointers */
-    for (size_t i = 0; i < CONFIG_BT_HIDS_MAX_CLIENT_COUNT; i++)
-    {
-        if (conn_mode[i].conn)
-        {
-            bt_conn_unref(conn_mode[i].conn);
-            conn_mode[i].conn = NULL;
-            conn_mode[i].in_boot_mode = false;
-        }
-    }
+    /* 3) Stop advertising and the reconnect stages; ignore not-active errors */
+    adv_stop();
 
-    /* 4) Stop advertising if running; ignore not-active errors */
-    if (is_adv)
-    {
-        int err = bt_le_adv_stop();
-        (void)err; /* ok if already stopped */
-        is_adv = false;
-    }
-
-    /* 5) Optional tiny settle */
+    /* 4) Optional tiny settle */
     k_sleep(K_MSEC(20));
 
     return 0;
 }
 
-#if (CONFIG_ENABLE_PASS_KEY_AUTH)
 /*
-Function : security_changed   [only compiled if CONFIG_ENABLE_PASS_KEY_AUTH is set]
+Function : security_changed
 
 Description : 
     Callback triggered when the security level of a BLE connection changes. 
-    Updates global connection state and logs the security result.
+    Updates global connection state, records the peer as the host to
+    reconnect to in the wake context, wakes threads waiting in
+    ble_wait_ready() and logs the security result.
 
 Parameter : 
     conn  : Pointer to the bt_conn structure representing the connection
@@ -383,6 +484,9 @@ static void security_changed(struct bt_conn *conn, bt_security_t level,
     if (!err)
     {
         isBle_connected = true;
+        bt_addr_le_copy(&wake_ctx_get()->host, bt_conn_get_dst(conn));
+        wake_ctx_get()->host_rpa = ble_peer_rpa(conn);
+        k_sem_give(&ble_ready_sem);
         LOG_INF("Security changed: %s level %u\n", addr, level);
     }
     else
@@ -391,14 +495,46 @@ static void security_changed(struct bt_conn *conn, bt_security_t level,
                 bt_security_err_to_str(err));
     }
 }
-#endif
+
+/*
+Function : ble_wait_ready
+
+Description : 
+    Blocks until a host is connected with an encrypted link, i.e. until
+    HID reports can be delivered. Returns immediately if that is already
+    the case.
+
+Parameter : 
+    timeout : Maximum time to wait
+
+Return : 
+    int : 0 once ready, -EAGAIN on timeout
+
+Example Call : 
+    (void)ble_wait_ready(K_FOREVER);
+*/
+int ble_wait_ready(k_timeout_t timeout)
+{
+    if (isBle_connected)
+    {
+        return 0;
+    }
+    return k_sem_take(&ble_ready_sem, timeout);
+}
 
 BT_CONN_CB_DEFINE(conn_callbacks) = {
     .connected = connected,
     .disconnected = disconnected,
-#if (CONFIG_ENABLE_PASS_KEY_AUTH)
-    .security_changed = security_changed,
+#if CONFIG_APP_CONN_PARAM || CONFIG_APP_ENERGY
+    .le_param_updated = le_param_updated,
+#endif
+#if CONFIG_BT_USER_PHY_UPDATE
+    .le_phy_updated = le_phy_updated,
 #endif
+#if CONFIG_BT_USER_DATA_LEN_UPDATE
+    .le_data_len_updated = le_data_len_updated,
+#endif
+    .security_changed = security_changed,
 };
 
 #if (CONFIG_ENABLE_PASS_KEY_AUTH)
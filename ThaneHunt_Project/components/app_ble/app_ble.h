@@ -30,22 +30,26 @@ Developer : Engineer Akbar Shah
 #define KEYS_MAX_LEN (INPUT_REPORT_KEYS_MAX_LEN - \
 					  SCAN_CODE_POS)
 
-struct conn_mode
+/* Link optimization outcome of a connection */
+struct ble_link_info
 {
-	struct bt_conn *conn;
-	bool in_boot_mode;
+	uint8_t tx_phy; /* BT_GAP_LE_PHY_* */
+	uint8_t rx_phy;
+	uint16_t tx_len; /* Max LL payload, octets */
+	uint16_t rx_len;
+	bool phy_2m_requested;
 };
 
-extern struct conn_mode conn_mode[CONFIG_BT_HIDS_MAX_CLIENT_COUNT];
-
 extern volatile bool is_adv;
 extern volatile bool isBle_connected;
 
 void connected(struct bt_conn *conn, uint8_t err);
 void disconnected(struct bt_conn *conn, uint8_t reason);
 int enable_bt(void);
-void bas_notify(void);
 int ble_disconnect_safe(void);
+int ble_wait_ready(k_timeout_t timeout);
+void ble_link_info_get(struct bt_conn *conn, struct ble_link_info *out);
+bool ble_peer_rpa(struct bt_conn *conn);
 
 #if (CONFIG_ENABLE_PASS_KEY_AUTH)
 int bt_register_auth_callbacks(void);
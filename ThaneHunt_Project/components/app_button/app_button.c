@@ -3,7 +3,7 @@ Name : app_button
 
 Description :
 	Button/LED and idle-power management for a BLE HID device on Zephyr RTOS.
-	Configures a GPIO button with interrupt + debounced work queue, maps button
+	Configures GPIO keys with interrupt + per-key debounce engine, maps button
 	events to HID key reports, manages an activity timer that disconnects BLE
 	and enters system-off, and controls a user LED.
 
@@ -14,143 +14,316 @@ Developer : Engineer Akbar Shah
 
 #include <zephyr/kernel.h>
 #include <zephyr/drivers/gpio.h>
+#include <zephyr/sys/spsc_lockfree.h>
 #include <bluetooth/services/hids.h>
 #include <zephyr/logging/log.h>
 
+#include "app_adv.h"
 #include "app_ble.h"
 #include "app_button.h"
+#include "app_energy.h"
 #include "app_hid.h"
-#include "app_keycodes.h"
+#include "app_hosts.h"
+#include "app_keymap.h"
+#include "app_latency.h"
 #include "app_sleep.h"
 
+#if CONFIG_APP_KEY_MATRIX
+#include "app_matrix.h"
+#endif
+
+#if CONFIG_IMU_LSM6DSO
+#include "app_imu.h" /* IMU_WAKE_ON_MOTION */
+#endif
+
+#if CONFIG_APP_BENCH
+#include "app_bench.h"
+#endif
+
 LOG_MODULE_REGISTER(APP_BUTTON);
 
 #define USER_LED_NODE DT_NODELABEL(led_0)
 #define USER_BUTTON_NODE DT_NODELABEL(button_0)
 #define USER_BUTTON_PIN DT_GPIO_PIN(USER_BUTTON_NODE, gpios)
-#define KEY_TEXT_MASK BIT(USER_BUTTON_PIN)
-#define BUTTON_THREAD_STACK_SIZE 2048
+#define USER_BUTTON_CTLR DT_GPIO_CTLR(USER_BUTTON_NODE, gpios)
+#define WAKE_IMU_NODE DT_PATH(zephyr_user)
+#define BUTTON_THREAD_STACK_SIZE CONFIG_APP_BUTTON_THREAD_STACK_SIZE
 #define BUTTON_THREAD_PRIO 0
-#define BUTTON_DEBOUNCE_MS 10
+#define BUTTON_DEBOUNCE_MS CONFIG_APP_BUTTON_DEBOUNCE_MS
+#define BUTTON_EVENT_RING_SIZE 16 /* must be a power of two */
+#define LED_BLINK_PERIOD_MS 1000  /* toggle period of LED_PATTERN_BLINK */
 
-static struct gpio_callback button_cb;
+/*
+ * Per-key debounce state machine.
+ *
+ * Eager mode:    IDLE --edge--> report level, LOCKOUT --timer--> re-sample;
+ *                a level that changed during the lockout is reported and the
+ *                lockout restarted, otherwise back to IDLE.
+ * Deferred mode: IDLE/SETTLING --edge--> (re)start timer, SETTLING --timer-->
+ *                report the level if it differs from the last one, IDLE.
+ *
+ * Both the edge and the timer expiry run in interrupt context, so the whole
+ * engine is driven from the ISR side and never touches the work queues.
+ */
+enum debounce_state
+{
+	DEBOUNCE_IDLE = 0,
+	DEBOUNCE_SETTLING, /* deferred: waiting for the line to go quiet */
+	DEBOUNCE_LOCKOUT,  /* eager: edge reported, ignoring chatter     */
+};
 
-static volatile uint32_t BUTTON_PIN;
-static volatile bool LATCH_RESET_BUTTON;
+struct button_key
+{
+	const struct gpio_dt_spec spec;
+	uint8_t id; /* key ID carried in key_event */
+	struct gpio_callback cb;
+	struct k_timer timer;
+	enum debounce_state state;
+	bool reported; /* last level handed to the consumer thread */
+};
+
+static enum wake_source wake_source = WAKE_SOURCE_OTHER;
 
 static k_tid_t button_thread_tid;
 static struct k_thread button_thread_data;
 
-static void button_work_handler(struct k_work *work);
-
-K_MSGQ_DEFINE(Button_queue, sizeof(bool), 16, 4);
-K_WORK_DELAYABLE_DEFINE(button_work, button_work_handler);
+/*
+ * GPIO key events. The ring is single-producer/single-consumer; the GPIO
+ * and debounce timer ISRs that produce into it may preempt each other, so
+ * the producer side is serialised with a spinlock. The consumer (button
+ * thread) never takes a lock. The matrix scanner has its own ring.
+ */
+SPSC_DEFINE(gpio_key_events, struct key_event, BUTTON_EVENT_RING_SIZE);
+static struct k_spinlock gpio_key_lock;
+
+K_SEM_DEFINE(key_event_sem, 0, K_SEM_MAX_LIMIT);
 K_THREAD_STACK_DEFINE(button_thread_stack, BUTTON_THREAD_STACK_SIZE);
 
 static const struct gpio_dt_spec user_led = GPIO_DT_SPEC_GET(USER_LED_NODE, gpios);
-static const struct gpio_dt_spec button = GPIO_DT_SPEC_GET(USER_BUTTON_NODE, gpios);
+
+static void user_led_blink_expiry(struct k_timer *timer);
+
+/* Drives LED_PATTERN_BLINK; stopped for the steady patterns */
+K_TIMER_DEFINE(user_led_timer, user_led_blink_expiry, NULL);
+
+/*
+ * LED state is set from the button thread, the Bluetooth RX thread (host
+ * lock LED), the power manager and the blink timer ISR; led_state_lock
+ * keeps the state and the pin consistent between them.
+ */
+static struct k_spinlock led_state_lock;
+static enum led_pattern user_led_pattern = LED_PATTERN_OFF;
+static bool user_led_gated; /* connected-sleep: LED held off */
+static bool user_led_lock;  /* host lock LED, shown while LED_PATTERN_OFF */
+
+static void button_tier_enter(enum power_tier tier);
+static void button_tier_exit(enum power_tier tier);
+
+static struct power_hook button_power_hook = {
+	.enter = button_tier_enter,
+	.exit = button_tier_exit,
+};
+
+static struct button_key button_keys[] = {
+	{.spec = GPIO_DT_SPEC_GET(USER_BUTTON_NODE, gpios)},
+};
 
 /*
-Function : button_text_changed
+Function : button_event_signal
 
 Description :
-	Sends a single HID key press or release based on the button state.
+	Wakes the button consumer thread after an event has been produced into
+	one of the key event rings. Without a host the event only counts as
+	activity: it keeps the device out of system-off and brings advertising
+	back from a slow stage, since the consumer does not take events
+	before the first link. Safe from ISR context.
 
 Parameter :
-	down : true for press, false for release
-	chr  : Pointer to the HID key code to send
+	None
 
 Return :
 	void
 
 Example Call :
-	uint8_t key = HID_KEY_H;
-	button_text_changed(true, &key);
+	button_event_signal();
+*/
+void button_event_signal(void)
+{
+	if (!isBle_connected)
+	{
+		reset_idle_timer();
+		adv_activity();
+	}
+	k_sem_give(&key_event_sem);
+}
+
+/*
+Function : button_key_report
+
+Description :
+	Pushes a debounced level of a key into the GPIO key event ring and
+	remembers it as the last reported level. Called from interrupt context.
+	If the ring is full the level is not recorded as reported, so the next
+	debounce expiry retries it.
+
+Parameter :
+	key   : Key whose level is reported
+	level : Debounced level (true = pressed)
+
+Return :
+	bool : true if the event was queued
+
+Example Call :
+	button_key_report(key, true);
 */
-static void button_text_changed(bool down, uint8_t *chr)
+static bool button_key_report(struct button_key *key, bool level)
 {
-	LOG_DBG("Button %s: sending HID key 0x%02X", down ? "pressed" : "released", *chr);
-	if (down)
+	struct key_event *evt;
+	k_spinlock_key_t lock = k_spin_lock(&gpio_key_lock);
+
+	evt = spsc_acquire(&gpio_key_events);
+	if (evt)
 	{
-		(void)hid_buttons_press(chr, 1);
+		evt->key_id = key->id;
+		evt->pressed = level;
+		evt->timestamp = k_cycle_get_32();
+		spsc_produce(&gpio_key_events);
+		key->reported = level;
 	}
-	else
+	k_spin_unlock(&gpio_key_lock, lock);
+
+	if (!evt)
 	{
-		(void)hid_buttons_release(chr, 1);
+		return false;
 	}
+
+	latency_trace_stamp(LATENCY_STAGE_DEBOUNCED);
+	button_event_signal();
+	return true;
 }
 
 /*
-Function : onButton_reset_send_spaceBar
+Function : wake_key_replay
 
 Description :
-	Sends a quick SPACE key tap (press + release). Used after a wakeup latch
-	indicates the button triggered system resume.
+	Queues the press that woke the SoC from system-off, so it reaches the
+	host like any other key once the link is up. Called at init, while
+	the button thread still waits for a host. If the key is still held
+	the real release follows from the ISR and the keymap sees the actual
+	hold time; if it was already let go, it is queued as a tap.
 
 Parameter :
-	None
+	key : Key that woke the SoC, its reported level read at init
 
 Return :
 	void
 
 Example Call :
-	onButton_reset_send_spaceBar();
+	wake_key_replay(key);
 */
-static void onButton_reset_send_spaceBar(void)
+static void wake_key_replay(struct button_key *key)
 {
-	static const uint8_t key = HID_KEY_SPACE;
-	(void)hid_buttons_press(&key, 1);
-	k_msleep(50);
-	(void)hid_buttons_release(&key, 1);
-	LOG_DBG("Sent SPACE key tap after wakeup");
+	bool held = key->reported;
+
+	(void)button_key_report(key, true);
+	if (!held)
+	{
+		(void)button_key_report(key, false);
+	}
+	LOG_DBG("Wake key %u queued (%s)", key->id, held ? "held" : "tap");
 }
 
 /*
 Function : button_isr
 
 Description :
-	GPIO interrupt service routine for the button. Captures the pin bitmap,
-	then reschedules a debounced work handler.
+	GPIO interrupt service routine for a key. In eager mode the first edge
+	is reported straight away and the key enters its lockout window; edges
+	during the lockout are ignored. In deferred mode every edge restarts the
+	settle timer and the level is only sampled once the line is quiet.
 
 Parameter :
 	dev  : GPIO device pointer (unused)
-	cb   : Callback structure pointer (unused)
-	pins : Bitmask of pins that triggered the interrupt
+	cb   : Callback structure embedded in the key
+	pins : Bitmask of pins that triggered the interrupt (unused)
 
 Return :
 	void
 
 Example Call :
-	egistered via gpio_init_callback(...)
+	registered via gpio_init_callback(...)
 */
 static void button_isr(const struct device *dev, struct gpio_callback *cb, uint32_t pins)
 {
+	struct button_key *key = CONTAINER_OF(cb, struct button_key, cb);
+
 	ARG_UNUSED(dev);
-	ARG_UNUSED(cb);
-	BUTTON_PIN = pins;
-	k_work_reschedule(&button_work, K_MSEC(BUTTON_DEBOUNCE_MS));
+	ARG_UNUSED(pins);
+	latency_trace_stamp(LATENCY_STAGE_EDGE);
+
+#if CONFIG_APP_BUTTON_DEBOUNCE_EAGER
+	if (key->state == DEBOUNCE_LOCKOUT)
+	{
+		return; /* chatter inside the lockout window */
+	}
+
+	bool level = gpio_pin_get_dt(&key->spec) > 0;
+
+	if (level == key->reported)
+	{
+		return; /* glitch shorter than the ISR latency */
+	}
+	(void)button_key_report(key, level);
+	key->state = DEBOUNCE_LOCKOUT;
+#else
+	key->state = DEBOUNCE_SETTLING;
+#endif
+	k_timer_start(&key->timer, K_MSEC(BUTTON_DEBOUNCE_MS), K_NO_WAIT);
 }
 
 /*
-Function : button_work_handler
+Function : button_debounce_expiry
 
 Description :
-	Debounce work handler. Reads the current button GPIO level and enqueues
-	it to the Button_queue for the consumer thread.
+	Debounce timer expiry for a key. Samples the settled level and reports it
+	if it differs from the last reported one. In eager mode a change found at
+	the end of the lockout (e.g. a short tap released within the window) is
+	reported and a new lockout window is started.
 
 Parameter :
-	work : Pointer to the work item
+	timer : Debounce timer embedded in the key
 
 Return :
 	void
 
 Example Call :
-	scheduled by button_isr via k_work_reschedule(...)
+	started by button_isr via k_timer_start(...)
 */
-static void button_work_handler(struct k_work *work)
+static void button_debounce_expiry(struct k_timer *timer)
 {
-	bool gp_state = gpio_pin_get_dt(&button);
-	(void)k_msgq_put(&Button_queue, &gp_state, K_NO_WAIT);
+	struct button_key *key = CONTAINER_OF(timer, struct button_key, timer);
+	bool level = gpio_pin_get_dt(&key->spec) > 0;
+
+	if (level == key->reported)
+	{
+		key->state = DEBOUNCE_IDLE;
+		return;
+	}
+
+#if CONFIG_APP_BUTTON_DEBOUNCE_EAGER
+	/* New lockout window; a dropped event is retried when it ends */
+	(void)button_key_report(key, level);
+	key->state = DEBOUNCE_LOCKOUT;
+	k_timer_start(&key->timer, K_MSEC(BUTTON_DEBOUNCE_MS), K_NO_WAIT);
+#else
+	if (!button_key_report(key, level))
+	{
+		/* Event ring full: sample again after another debounce period */
+		k_timer_start(&key->timer, K_MSEC(BUTTON_DEBOUNCE_MS), K_NO_WAIT);
+		return;
+	}
+	key->state = DEBOUNCE_IDLE;
+#endif
 }
 
 /*
@@ -204,7 +377,8 @@ void user_led_turn_on(void)
 {
 	if (!gpio_pin_set_dt(&user_led, 1))
 	{
-		LOG_INF("User LED Turn ON\n\r");
+		energy_state_set(ENERGY_STATE_LED, true);
+		LOG_DBG("User LED on");
 	}
 }
 
@@ -227,7 +401,8 @@ void user_led_turn_off(void)
 {
 	if (!gpio_pin_set_dt(&user_led, 0))
 	{
-		LOG_INF("User LED Turn OFF\n\r");
+		energy_state_set(ENERGY_STATE_LED, false);
+		LOG_DBG("User LED off");
 	}
 }
 
@@ -248,17 +423,236 @@ Example Call :
 */
 void user_led_toggle(void)
 {
-	gpio_pin_toggle_dt(&user_led);
+	if (!gpio_pin_toggle_dt(&user_led))
+	{
+		energy_state_toggle(ENERGY_STATE_LED);
+	}
 	LOG_DBG("User LED Toggled\n\r");
 }
 
+/*
+Function : user_led_blink_expiry
+
+Description :
+	LED timer callback, toggles the LED for the blink pattern. Runs in
+	interrupt context; gpio_pin_toggle_dt() is safe there.
+
+Parameter :
+	timer : Pointer to the LED timer (unused)
+
+Return :
+	void
+
+Example Call :
+	invoked by k_timer while LED_PATTERN_BLINK is active
+*/
+static void user_led_blink_expiry(struct k_timer *timer)
+{
+	k_spinlock_key_t key = k_spin_lock(&led_state_lock);
+
+	ARG_UNUSED(timer);
+
+	if (!gpio_pin_toggle_dt(&user_led))
+	{
+		energy_state_toggle(ENERGY_STATE_LED);
+	}
+	k_spin_unlock(&led_state_lock, key);
+}
+
+/*
+Function : user_led_apply
+
+Description :
+	Drives the LED for the recorded pattern, gate and lock LED state.
+	Called with led_state_lock held.
+
+Parameter :
+	None
+
+Return :
+	void
+
+Example Call :
+	user_led_apply();
+*/
+static void user_led_apply(void)
+{
+	enum led_pattern pattern = user_led_gated ? LED_PATTERN_OFF : user_led_pattern;
+
+	switch (pattern)
+	{
+	case LED_PATTERN_BLINK:
+		k_timer_start(&user_led_timer, K_NO_WAIT, K_MSEC(LED_BLINK_PERIOD_MS));
+		break;
+	case LED_PATTERN_ON:
+		k_timer_stop(&user_led_timer);
+		user_led_turn_on();
+		break;
+	case LED_PATTERN_OFF:
+	default:
+		k_timer_stop(&user_led_timer);
+		if (user_led_lock && !user_led_gated)
+		{
+			user_led_turn_on();
+		}
+		else
+		{
+			user_led_turn_off();
+		}
+		break;
+	}
+}
+
+/*
+Function : user_led_pattern_set
+
+Description :
+	Selects the LED pattern. The blink pattern runs on a kernel timer, so
+	no thread has to wake up to drive it; the steady patterns stop the
+	timer and set the pin once; LED_PATTERN_OFF still shows the host lock
+	LED. While the LED is gated (connected-sleep) the pattern is only
+	recorded and applied on wake. Safe to call from any context.
+
+Parameter :
+	pattern : LED_PATTERN_OFF, LED_PATTERN_ON or LED_PATTERN_BLINK
+
+Return :
+	void
+
+Example Call :
+	user_led_pattern_set(LED_PATTERN_BLINK);
+*/
+void user_led_pattern_set(enum led_pattern pattern)
+{
+	k_spinlock_key_t key = k_spin_lock(&led_state_lock);
+
+	user_led_pattern = pattern;
+	user_led_apply();
+	k_spin_unlock(&led_state_lock, key);
+}
+
+/*
+Function : user_led_lock_set
+
+Description :
+	Sets the host lock LED state (Caps Lock) shown on the user LED while
+	no pattern is running. The GPIO is only written when the state
+	changes and the LED is not busy with a pattern; connected-sleep keeps
+	it off. Safe to call from any context.
+
+Parameter :
+	on : true to light the lock LED
+
+Return :
+	void
+
+Example Call :
+	user_led_lock_set(true);
+*/
+void user_led_lock_set(bool on)
+{
+	k_spinlock_key_t key = k_spin_lock(&led_state_lock);
+
+	if (user_led_lock != on)
+	{
+		user_led_lock = on;
+		if (user_led_pattern == LED_PATTERN_OFF && !user_led_gated)
+		{
+			if (!gpio_pin_set_dt(&user_led, on))
+			{
+				energy_state_set(ENERGY_STATE_LED, on);
+			}
+		}
+	}
+	k_spin_unlock(&led_state_lock, key);
+}
+
+/*
+Function : user_led_gate
+
+Description :
+	Holds the LED off for connected-sleep, or releases it and restores
+	the recorded pattern.
+
+Parameter :
+	gated : true to hold the LED off
+
+Return :
+	void
+
+Example Call :
+	user_led_gate(true);
+*/
+static void user_led_gate(bool gated)
+{
+	k_spinlock_key_t key = k_spin_lock(&led_state_lock);
+
+	user_led_gated = gated;
+	user_led_apply();
+	k_spin_unlock(&led_state_lock, key);
+}
+
+/*
+Function : button_tier_enter
+
+Description :
+	Power tier entry hook. Connected-sleep turns the user LED off; before
+	system-off the key matrix is armed as a wake source.
+
+Parameter :
+	tier : Tier being entered
+
+Return :
+	void
+
+Example Call :
+	registered with power_hook_register()
+*/
+static void button_tier_enter(enum power_tier tier)
+{
+	if (tier == POWER_TIER_CONN_SLEEP)
+	{
+		user_led_gate(true);
+	}
+#if CONFIG_APP_KEY_MATRIX
+	else if (tier == POWER_TIER_OFF)
+	{
+		kbd_matrix_suspend(); /* any matrix key wakes the SoC via GPIO sense */
+	}
+#endif
+}
+
+/*
+Function : button_tier_exit
+
+Description :
+	Power tier exit hook. Leaving connected-sleep restores the LED pattern.
+
+Parameter :
+	tier : Tier being left
+
+Return :
+	void
+
+Example Call :
+	registered with power_hook_register()
+*/
+static void button_tier_exit(enum power_tier tier)
+{
+	if (tier == POWER_TIER_CONN_SLEEP)
+	{
+		user_led_gate(false);
+	}
+}
+
 /*
 Function : init_user_buttons
 
 Description :
-	Configures the button GPIO as input with interrupts on both edges, installs
-	the ISR callback, initializes the user LED, and starts the button consumer
-	thread. Logs configuration details.
+	Configures every key GPIO as input with interrupts on both edges, sets up
+	its debounce timer and ISR callback, queues the wake key after a button
+	wake, initializes the user LED, and starts the button consumer thread.
+	Logs configuration details.
 
 Parameter :
 	None
@@ -273,28 +667,56 @@ void init_user_buttons(void)
 {
 	int ret;
 
-	if (!device_is_ready(button.port))
+	for (size_t i = 0; i < ARRAY_SIZE(button_keys); i++)
 	{
-		LOG_ERR("Error: button device not ready\n");
-		return;
-	}
+		struct button_key *key = &button_keys[i];
 
-	ret = gpio_pin_configure_dt(&button, GPIO_INPUT);
-	if (ret)
-	{
-		LOG_ERR("Error %d: failed to configure button pin\n", ret);
-		return;
+		if (!device_is_ready(key->spec.port))
+		{
+			LOG_ERR("Error: button device not ready\n");
+			return;
+		}
+
+		ret = gpio_pin_configure_dt(&key->spec, GPIO_INPUT);
+		if (ret)
+		{
+			LOG_ERR("Error %d: failed to configure button pin\n", ret);
+			return;
+		}
+
+		key->id = i;
+		k_timer_init(&key->timer, button_debounce_expiry, NULL);
+		key->state = DEBOUNCE_IDLE;
+		key->reported = gpio_pin_get_dt(&key->spec) > 0;
+		if ((wake_source == WAKE_SOURCE_BUTTON) && (i == 0))
+		{
+			wake_key_replay(key); /* button 0 is the wake button */
+		}
+
+		ret = gpio_pin_interrupt_configure_dt(&key->spec, GPIO_INT_EDGE_BOTH);
+		if (ret)
+		{
+			LOG_ERR("Error %d: failed to configure interrupt\n", ret);
+			return;
+		}
+
+		gpio_init_callback(&key->cb, button_isr, BIT(key->spec.pin));
+		gpio_add_callback(key->spec.port, &key->cb);
+
+		LOG_DBG("Button configured: port=%s pin=%u active_%s, debounce=%s %dms\n",
+				key->spec.port->name, key->spec.pin,
+				(key->spec.dt_flags & GPIO_ACTIVE_LOW) ? "low" : "high",
+				IS_ENABLED(CONFIG_APP_BUTTON_DEBOUNCE_EAGER) ? "eager" : "deferred",
+				BUTTON_DEBOUNCE_MS);
 	}
 
-	ret = gpio_pin_interrupt_configure_dt(&button, GPIO_INT_EDGE_BOTH);
+#if CONFIG_APP_KEY_MATRIX
+	ret = kbd_matrix_init(ARRAY_SIZE(button_keys));
 	if (ret)
 	{
-		LOG_ERR("Error %d: failed to configure interrupt\n", ret);
-		return;
+		LOG_ERR("Cannot init key matrix (err: %d)\n", ret);
 	}
-
-	gpio_init_callback(&button_cb, button_isr, BIT(button.pin));
-	gpio_add_callback(button.port, &button_cb);
+#endif
 
 	/* LEDs init (unchanged) */
 	int err = init_user_led();
@@ -303,23 +725,106 @@ void init_user_buttons(void)
 		LOG_ERR("Cannot init LEDs (err: %d)\n", err);
 	}
 
+	power_hook_register(&button_power_hook);
+
 	/* Start the consumer thread */
 	button_thread_start();
+}
+
+/*
+Function : key_event_get
+
+Description :
+	Consumer side of the key event rings. Returns the oldest pending GPIO
+	key event, then matrix events, then benchmark injector events.
+	Lock-free; only called from the button thread.
 
-	LOG_DBG("Button configured: port=%s pin=%u active_%s, debounce=%dms\n",
-			button.port->name, button.pin,
-			(button.dt_flags & GPIO_ACTIVE_LOW) ? "low" : "high",
-			BUTTON_DEBOUNCE_MS);
+Parameter :
+	evt : Output event
+
+Return :
+	bool : true if an event was returned, false if every ring is empty
+
+Example Call :
+	while (key_event_get(&ev)) { ... }
+*/
+static bool key_event_get(struct key_event *evt)
+{
+	struct key_event *slot = spsc_consume(&gpio_key_events);
+
+	if (slot)
+	{
+		*evt = *slot;
+		spsc_release(&gpio_key_events);
+		return true;
+	}
+#if CONFIG_APP_KEY_MATRIX
+	if (kbd_matrix_event_get(evt))
+	{
+		return true;
+	}
+#endif
+#if CONFIG_APP_BENCH
+	if (bench_event_get(evt))
+	{
+		return true;
+	}
+#endif
+	return false;
+}
+
+/*
+Function : button_event_process
+
+Description :
+	Handles one key event: feeds the host switch chord, drops the
+	event if no host is connected (button_event_signal() already
+	counted it as activity), otherwise restarts the idle timer and runs
+	the event through the keymap.
+
+Parameter :
+	ev : Key event taken from a ring
+
+Return :
+	void
+
+Example Call :
+	button_event_process(&ev);
+*/
+static void button_event_process(const struct key_event *ev)
+{
+	latency_trace_stamp(LATENCY_STAGE_DEQUEUED);
+	if (hosts_chord_update(ev->key_id, ev->pressed))
+	{
+		latency_trace_abort();
+		return; // host switch chord, works while disconnected too
+	}
+	if (isBle_connected == false)
+	{
+		latency_trace_abort();
+		return; // ignore button presses when not connected
+	}
+	/* Any activity -> restart idle timer */
+	reset_idle_timer();
+
+	LOG_DBG("Key %u %s (t=%u)", ev->key_id, ev->pressed ? "down" : "up", ev->timestamp);
+	if (!keymap_key_event(ev->key_id, ev->pressed, ev->timestamp))
+	{
+		latency_trace_abort(); // unmapped, layer or pending tap/hold key
+	}
 }
 
 /*
 Function : button_thread_fn
 
 Description :
-	Button consumer thread. Starts an idle timer, waits for BLE connection,
-	optionally sends a SPACE tap if the wake latch indicates button resume,
-	then processes debounced button events from the queue. For each event it
-	restarts the idle timer and sends the mapped HID key press/release.
+	Button consumer thread. Starts an idle timer, blocks until a host
+	is connected and encrypted (signalled from security_changed), then
+	drains debounced key events from the event rings each time a
+	producer signals or the keymap timer fires. Each event goes
+	through the keymap, then pending keymap deadlines are run. Events
+	queued while waiting, such as the wake key, keep their timestamps,
+	so tap/hold resolves as typed.
 
 Parameter :
 	p1 : Unused (NULL expected)
@@ -334,34 +839,19 @@ Example Call :
 */
 static void button_thread_fn(void *p1, void *p2, void *p3)
 {
-	bool ev;
+	struct key_event ev;
 
 	start_idle_timer();
-	while (isBle_connected == false)
-	{
-		k_sleep(K_MSEC(100));
-	}
-	if (LATCH_RESET_BUTTON)
-	{
-		LATCH_RESET_BUTTON = false;
-		onButton_reset_send_spaceBar();
-	}
+	(void)ble_wait_ready(K_FOREVER); /* keys pressed meanwhile wait in the rings */
 
 	for (;;)
 	{
-		k_msgq_get(&Button_queue, &ev, K_FOREVER);
-		if (isBle_connected == false)
-		{
-			continue; // ignore button presses when not connected
-		}
-		/* Any activity -> restart idle timer */
-		reset_idle_timer();
-
-		if (BUTTON_PIN & KEY_TEXT_MASK)
+		k_sem_take(&key_event_sem, K_FOREVER);
+		while (key_event_get(&ev))
 		{
-			static uint8_t key = HID_KEY_H;
-			button_text_changed(ev, &key);
+			button_event_process(&ev);
 		}
+		keymap_tick(); // tap/hold deadlines and macro steps
 	}
 }
 
@@ -403,9 +893,11 @@ void button_thread_start(void)
 Function : read_latch_register
 
 Description :
-	Reads and logs the GPIO LATCH register to determine if the button caused
-	the wakeup from system off. Sets LATCH_RESET_BUTTON if the button bit is
-	found, and clears the corresponding latch flags.
+	Reads and logs the GPIO LATCH registers to determine what caused the
+	wakeup from system off: the button, or with wake-on-motion the IMU INT1
+	line. Each line's own port is read. Records the wake source, which
+	init_user_buttons() uses to replay the wake key, and clears the latch
+	flags that were set.
 
 Parameter :
 	None
@@ -418,21 +910,60 @@ Example Call :
 */
 int read_latch_register(void)
 {
-	uint32_t lat = NRF_P0->LATCH; /* snapshot */
-	if (lat)
+	NRF_GPIO_Type *btn_port = (NRF_GPIO_Type *)DT_REG_ADDR(USER_BUTTON_CTLR);
+	uint32_t btn_lat = btn_port->LATCH; /* snapshot */
+#if IMU_WAKE_ON_MOTION
+	NRF_GPIO_Type *imu_port = (NRF_GPIO_Type *)DT_REG_ADDR(DT_GPIO_CTLR(WAKE_IMU_NODE, imu_int1_gpios));
+	uint32_t imu_lat = imu_port->LATCH; /* before clearing: may be the same port */
+#endif
+
+	if (btn_lat & BIT(USER_BUTTON_PIN))
 	{
-		if (lat & BIT(USER_BUTTON_PIN))
-		{
-			LATCH_RESET_BUTTON = true;
-			LOG_INF("Button (P1.%u) was the wakeup source", USER_BUTTON_PIN);
-		}
-		/* Clear only the bits that were set */
-		NRF_P0->LATCH = lat; /* write-1-to-clear */
+		wake_source = WAKE_SOURCE_BUTTON;
+		LOG_INF("Button (P%u.%u) was the wakeup source", DT_PROP(USER_BUTTON_CTLR, port), USER_BUTTON_PIN);
+	}
+#if IMU_WAKE_ON_MOTION
+	else if (imu_lat & BIT(DT_GPIO_PIN(WAKE_IMU_NODE, imu_int1_gpios)))
+	{
+		wake_source = WAKE_SOURCE_MOTION;
+		LOG_INF("IMU motion was the wakeup source");
+	}
+
+	if (imu_lat)
+	{
+		imu_port->LATCH = imu_lat; /* write-1-to-clear */
+	}
+#endif
+
+	/* Clear only the bits that were set */
+	if (btn_lat)
+	{
+		btn_port->LATCH = btn_lat; /* write-1-to-clear */
 	}
-	/* If your board also uses P1, read/clear NRF_P1->LATCH similarly. */
 	return 0;
 }
 
+/*
+Function : wake_source_get
+
+Description :
+	Returns the wake source recorded by read_latch_register() at boot.
+
+Parameter :
+	None
+
+Return :
+	enum wake_source : WAKE_SOURCE_BUTTON, WAKE_SOURCE_MOTION or
+	                   WAKE_SOURCE_OTHER (reset, power-on, debugger)
+
+Example Call :
+	if (wake_source_get() == WAKE_SOURCE_MOTION) { ... }
+*/
+enum wake_source wake_source_get(void)
+{
+	return wake_source;
+}
+
 /*
 SYS_INIT(read_latch_register, PRE_KERNEL_1, 0);
 
@@ -3,7 +3,7 @@ Name : app_button
 
 Description : 
     Button/LED and idle-power management for a BLE HID device on Zephyr RTOS.
-    Configures a GPIO button with interrupt + debounced work queue, maps button
+    Configures GPIO keys with interrupt + per-key debounce engine, maps button
     events to HID key reports, manages an activity timer that disconnects BLE
     and enters system-off, and controls a user LED.
 
@@ -16,13 +16,44 @@ Developer : Engineer Akbar Shah
 #ifndef APP_BUTTON_H
 #define APP_BUTTON_H
 
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Debounced key change handed from a key source to the button thread */
+struct key_event
+{
+    uint8_t key_id;     /* GPIO keys first, then matrix keys row-major */
+    uint8_t pressed;    /* 1 = pressed, 0 = released */
+    uint32_t timestamp; /* k_cycle_get_32() when the change was accepted */
+};
+
+/* User LED patterns */
+enum led_pattern
+{
+    LED_PATTERN_OFF = 0,
+    LED_PATTERN_ON,
+    LED_PATTERN_BLINK, /* 1 s toggle, e.g. while advertising */
+};
+
+/* What woke the SoC from system-off */
+enum wake_source
+{
+    WAKE_SOURCE_OTHER = 0, /* power-on, reset pin, debugger */
+    WAKE_SOURCE_BUTTON,
+    WAKE_SOURCE_MOTION, /* LSM6DSO wake-up interrupt on INT1 */
+};
+
 int read_latch_register(void);
+enum wake_source wake_source_get(void);
 
 int init_user_led(void);
 void user_led_turn_on(void);
 void user_led_turn_off(void);
 void user_led_toggle(void);
+void user_led_pattern_set(enum led_pattern pattern);
+void user_led_lock_set(bool on);
 void button_thread_start(void);
 void init_user_buttons(void);
+void button_event_signal(void);
 
 #endif // APP_BUTTON_H
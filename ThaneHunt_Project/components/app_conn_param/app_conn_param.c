@@ -0,0 +1,300 @@
+/*
+Name : app_conn_param
+
+Description :
+    Connection parameter policy for the BLE HID keyboard. It follows the
+    power tiers of app_sleep: while keys are being typed (active) every
+    link is asked for a 7.5 ms interval with no peripheral latency; in the
+    idle tier the links are relaxed to a long interval with high peripheral
+    latency, and in connected-sleep the latency goes to its maximum to cut
+    the radio duty cycle further. Every parameter set negotiated by the
+    central is logged and counted. The active parameters the central last
+    granted are kept in the wake context, and active requests accept an
+    interval up to them, so a central that cannot do 7.5 ms takes the
+    first request after a wake as it is.
+
+Date : 2026-10-14
+
+Developer : Engineer Akbar Shah
+*/
+
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#include "app_conn_param.h"
+#include "app_sleep.h"
+#include "app_wake.h"
+
+LOG_MODULE_REGISTER(APP_CONN_PARAM);
+
+/* Active profile: 7.5 ms, no latency, 4 s supervision timeout */
+#define CONN_PARAM_ACTIVE_INTERVAL 6
+#define CONN_PARAM_ACTIVE_LATENCY 0
+#define CONN_PARAM_ACTIVE_TIMEOUT 400
+
+#define CONN_PARAM_IDLE_INTERVAL CONFIG_APP_CONN_PARAM_IDLE_INTERVAL
+#define CONN_PARAM_IDLE_LATENCY CONFIG_APP_CONN_PARAM_IDLE_LATENCY
+#define CONN_PARAM_IDLE_TIMEOUT CONFIG_APP_CONN_PARAM_IDLE_TIMEOUT
+
+/* Connected-sleep profile: idle interval, latency as high as the timeout allows */
+#define CONN_PARAM_SLEEP_LATENCY CONFIG_APP_CONN_PARAM_SLEEP_LATENCY
+#define CONN_PARAM_SLEEP_TIMEOUT CONFIG_APP_CONN_PARAM_SLEEP_TIMEOUT
+
+/* Core spec: timeout (10 ms units) > (1 + latency) * interval (1.25 ms units) * 2 */
+BUILD_ASSERT((CONN_PARAM_IDLE_TIMEOUT * 4) >
+                 ((1 + CONN_PARAM_IDLE_LATENCY) * CONN_PARAM_IDLE_INTERVAL),
+             "Idle supervision timeout too short for interval and latency");
+BUILD_ASSERT((CONN_PARAM_SLEEP_TIMEOUT * 4) >
+                 ((1 + CONN_PARAM_SLEEP_LATENCY) * CONN_PARAM_IDLE_INTERVAL),
+             "Sleep supervision timeout too short for interval and latency");
+
+enum conn_param_profile
+{
+    CONN_PARAM_PROFILE_IDLE = 0,
+    CONN_PARAM_PROFILE_ACTIVE,
+    CONN_PARAM_PROFILE_SLEEP,
+};
+
+static const char *const profile_name[] = {
+    [CONN_PARAM_PROFILE_IDLE] = "idle",
+    [CONN_PARAM_PROFILE_ACTIVE] = "active",
+    [CONN_PARAM_PROFILE_SLEEP] = "sleep",
+};
+
+static const struct bt_le_conn_param profile_param[] = {
+    [CONN_PARAM_PROFILE_IDLE] = BT_LE_CONN_PARAM_INIT(CONN_PARAM_IDLE_INTERVAL,
+                                                      CONN_PARAM_IDLE_INTERVAL,
+                                                      CONN_PARAM_IDLE_LATENCY,
+                                                      CONN_PARAM_IDLE_TIMEOUT),
+    [CONN_PARAM_PROFILE_ACTIVE] = BT_LE_CONN_PARAM_INIT(CONN_PARAM_ACTIVE_INTERVAL,
+                                                        CONN_PARAM_ACTIVE_INTERVAL,
+                                                        CONN_PARAM_ACTIVE_LATENCY,
+                                                        CONN_PARAM_ACTIVE_TIMEOUT),
+    [CONN_PARAM_PROFILE_SLEEP] = BT_LE_CONN_PARAM_INIT(CONN_PARAM_IDLE_INTERVAL,
+                                                       CONN_PARAM_IDLE_INTERVAL,
+                                                       CONN_PARAM_SLEEP_LATENCY,
+                                                       CONN_PARAM_SLEEP_TIMEOUT),
+};
+
+static atomic_t profile = ATOMIC_INIT(CONN_PARAM_PROFILE_ACTIVE);
+static atomic_t update_count;
+
+static void conn_param_tier_enter(enum power_tier tier);
+static void conn_param_tier_exit(enum power_tier tier);
+
+static struct power_hook conn_param_power_hook = {
+    .enter = conn_param_tier_enter,
+    .exit = conn_param_tier_exit,
+};
+
+/*
+Function : conn_param_request
+
+Description :
+    Asks the central to switch one link to the parameters of the current
+    profile. Links that are not fully connected are skipped. The active
+    profile's maximum interval is widened to the interval the central
+    granted last time, so the request does not have to be renegotiated.
+
+Parameter :
+    conn : Pointer to the Bluetooth connection
+    data : Unused (bt_conn_foreach user data)
+
+Return :
+    void
+
+Example Call :
+    bt_conn_foreach(BT_CONN_TYPE_LE, conn_param_request, NULL);
+*/
+static void conn_param_request(struct bt_conn *conn, void *data)
+{
+    enum conn_param_profile p = (enum conn_param_profile)atomic_get(&profile);
+    struct bt_le_conn_param param = profile_param[p];
+    struct bt_conn_info info;
+    int err;
+
+    ARG_UNUSED(data);
+
+    if (bt_conn_get_info(conn, &info) || info.state != BT_CONN_STATE_CONNECTED)
+    {
+        return;
+    }
+
+    if (p == CONN_PARAM_PROFILE_ACTIVE)
+    {
+        param.interval_max = MAX(param.interval_max, wake_ctx_get()->conn_interval);
+    }
+
+    err = bt_conn_le_param_update(conn, &param);
+    if (err && err != -EALREADY)
+    {
+        LOG_WRN("Conn param %s request failed (err %d)", profile_name[p], err);
+        return;
+    }
+    LOG_DBG("Conn param %s requested", profile_name[p]);
+}
+
+/*
+Function : conn_param_profile_apply
+
+Description :
+    Switches to a profile and requests it on every link.
+
+Parameter :
+    p : Profile to apply
+
+Return :
+    void
+
+Example Call :
+    conn_param_profile_apply(CONN_PARAM_PROFILE_IDLE);
+*/
+static void conn_param_profile_apply(enum conn_param_profile p)
+{
+    atomic_set(&profile, p);
+    bt_conn_foreach(BT_CONN_TYPE_LE, conn_param_request, NULL);
+}
+
+/*
+Function : conn_param_tier_enter
+
+Description :
+    Power tier entry hook: relaxes the links to the idle profile in the
+    idle tier and to the sleep profile in connected-sleep.
+
+Parameter :
+    tier : Tier being entered
+
+Return :
+    void
+
+Example Call :
+    registered with power_hook_register()
+*/
+static void conn_param_tier_enter(enum power_tier tier)
+{
+    if (tier == POWER_TIER_IDLE)
+    {
+        conn_param_profile_apply(CONN_PARAM_PROFILE_IDLE);
+    }
+    else if (tier == POWER_TIER_CONN_SLEEP)
+    {
+        conn_param_profile_apply(CONN_PARAM_PROFILE_SLEEP);
+    }
+}
+
+/*
+Function : conn_param_tier_exit
+
+Description :
+    Power tier exit hook. Only the final step back to active changes the
+    links, so waking from connected-sleep asks for the active profile once
+    instead of going through the idle one.
+
+Parameter :
+    tier : Tier being left
+
+Return :
+    void
+
+Example Call :
+    registered with power_hook_register()
+*/
+static void conn_param_tier_exit(enum power_tier tier)
+{
+    if (tier == POWER_TIER_IDLE)
+    {
+        conn_param_profile_apply(CONN_PARAM_PROFILE_ACTIVE);
+    }
+}
+
+/*
+Function : conn_param_connected
+
+Description :
+    Starts the policy on a new link: requests the active profile so the
+    first keystrokes after (re)connecting already see the short interval.
+    The connection counts as activity, so the power manager is back in
+    the active tier as well.
+
+Parameter :
+    conn : Pointer to the new Bluetooth connection
+
+Return :
+    void
+
+Example Call :
+    conn_param_connected(conn);
+*/
+void conn_param_connected(struct bt_conn *conn)
+{
+    atomic_set(&profile, CONN_PARAM_PROFILE_ACTIVE);
+    reset_idle_timer();
+    conn_param_request(conn, NULL);
+}
+
+/*
+Function : conn_param_updated
+
+Description :
+    le_param_updated connection callback. Logs and counts every parameter
+    set negotiated by the central, and keeps a set applied in the active
+    profile in the wake context. Intervals as long as the idle one are
+    not kept: they are the central's own choice, not an answer to the
+    active request.
+
+Parameter :
+    conn     : Pointer to the Bluetooth connection
+    interval : New connection interval (1.25 ms units)
+    latency  : New peripheral latency (connection events)
+    timeout  : New supervision timeout (10 ms units)
+
+Return :
+    void
+
+Example Call :
+    registered as .le_param_updated in BT_CONN_CB_DEFINE
+*/
+void conn_param_updated(struct bt_conn *conn, uint16_t interval,
+                        uint16_t latency, uint16_t timeout)
+{
+    struct wake_ctx *ctx = wake_ctx_get();
+
+    ARG_UNUSED(conn);
+
+    if ((atomic_get(&profile) == CONN_PARAM_PROFILE_ACTIVE) && (interval < CONN_PARAM_IDLE_INTERVAL))
+    {
+        ctx->conn_interval = interval;
+        ctx->conn_latency = latency;
+        ctx->conn_timeout = timeout;
+    }
+
+    LOG_INF("Conn params #%ld: interval %u us latency %u timeout %u ms (%s)\n",
+            (long)atomic_inc(&update_count) + 1, BT_CONN_INTERVAL_TO_US(interval),
+            latency, timeout * 10U, profile_name[atomic_get(&profile)]);
+}
+
+/*
+Function : conn_param_init
+
+Description :
+    Registers the policy with the power manager.
+
+Parameter :
+    None
+
+Return :
+    int : 0 always
+
+Example Call :
+    run by SYS_INIT at APPLICATION level
+*/
+static int conn_param_init(void)
+{
+    power_hook_register(&conn_param_power_hook);
+    return 0;
+}
+
+SYS_INIT(conn_param_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
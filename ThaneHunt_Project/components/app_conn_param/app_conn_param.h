@@ -0,0 +1,33 @@
+/*
+Name : app_conn_param
+
+Description :
+    Connection parameter policy for the BLE HID keyboard. It follows the
+    power tiers of app_sleep: while keys are being typed (active) every
+    link is asked for a 7.5 ms interval with no peripheral latency; in the
+    idle tier the links are relaxed to a long interval with high peripheral
+    latency, and in connected-sleep the latency goes to its maximum to cut
+    the radio duty cycle further. Every parameter set negotiated by the
+    central is logged and counted.
+
+Date : 2026-10-14
+
+Developer : Engineer Akbar Shah
+*/
+
+#ifndef APP_CONN_PARAM_H
+#define APP_CONN_PARAM_H
+
+#include <stdint.h>
+
+struct bt_conn;
+
+#if CONFIG_APP_CONN_PARAM
+void conn_param_connected(struct bt_conn *conn);
+void conn_param_updated(struct bt_conn *conn, uint16_t interval,
+                        uint16_t latency, uint16_t timeout);
+#else
+static inline void conn_param_connected(struct bt_conn *conn) { (void)conn; }
+#endif
+
+#endif // APP_CONN_PARAM_H
@@ -0,0 +1,461 @@
+/*
+Name : app_energy
+
+Description :
+    Energy accounting for the BLE HID keyboard. The owning modules report
+    their state changes: app_adv the advertising period, app_ble the links
+    and their parameters, app_sleep the power tier, app_imu the sensor,
+    app_button the user LED and app_hid every notification sent. Each
+    change first closes the running interval, adding its time to the
+    states that were on and the radio events it held (system-on time over
+    the advertising or connection event period) to the state they fell in.
+    "energy stats" applies the Kconfig coefficients: extra current times
+    time, plus charge per event, on top of the system-on floor. Totals
+    live in the wake context, so they run from the last cold boot.
+
+Date : 2026-10-14
+
+Developer : Engineer Akbar Shah
+*/
+
+#include <string.h>
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/kernel.h>
+#include <zephyr/shell/shell.h>
+#include <zephyr/sys/util.h>
+
+#include "app_energy.h"
+#include "app_wake.h"
+
+/*
+ * Connection event period of a link: the interval stretched by the
+ * peripheral latency, i.e. assuming the events the latency allows are
+ * skipped while there is nothing to send. The events a notification
+ * wakes are covered by its own charge.
+ */
+struct energy_link
+{
+    uint32_t period_us; /* 0: link down */
+    uint32_t phase_us;  /* time into the current event period */
+};
+
+static struct k_spinlock energy_lock;
+static uint32_t energy_last_ms;    /* k_uptime_get_32() of the last update */
+static uint32_t adv_period_us;     /* 0: not advertising */
+static uint32_t adv_phase_us;
+static struct energy_link energy_links[CONFIG_BT_MAX_CONN];
+static enum power_tier energy_tier = POWER_TIER_ACTIVE;
+static uint8_t energy_on;          /* BIT(ENERGY_STATE_IMU / _LED) while on */
+
+static const char *const state_name[ENERGY_STATE_COUNT] = {
+    [ENERGY_STATE_ADV] = "advertising",
+    [ENERGY_STATE_CONN_ACTIVE] = "conn-active",
+    [ENERGY_STATE_CONN_IDLE] = "conn-idle",
+    [ENERGY_STATE_IMU] = "imu",
+    [ENERGY_STATE_LED] = "led",
+};
+
+static const uint32_t state_ua[ENERGY_STATE_COUNT] = {
+    [ENERGY_STATE_ADV] = CONFIG_APP_ENERGY_ADV_UA,
+    [ENERGY_STATE_CONN_ACTIVE] = CONFIG_APP_ENERGY_CONN_ACTIVE_UA,
+    [ENERGY_STATE_CONN_IDLE] = CONFIG_APP_ENERGY_CONN_IDLE_UA,
+    [ENERGY_STATE_IMU] = CONFIG_APP_ENERGY_IMU_UA,
+    [ENERGY_STATE_LED] = CONFIG_APP_ENERGY_LED_UA,
+};
+
+static const uint32_t radio_event_nc[ENERGY_RADIO_STATES] = {
+    [ENERGY_STATE_ADV] = CONFIG_APP_ENERGY_ADV_EVENT_NC,
+    [ENERGY_STATE_CONN_ACTIVE] = CONFIG_APP_ENERGY_CONN_EVENT_NC,
+    [ENERGY_STATE_CONN_IDLE] = CONFIG_APP_ENERGY_CONN_EVENT_NC,
+};
+
+/*
+Function : energy_events
+
+Description :
+    Advances an event period phase by some time and returns the number of
+    event periods that ended in it.
+
+Parameter :
+    phase_us  : Phase into the current period, updated
+    period_us : Event period
+    dt_ms     : Time elapsed
+
+Return :
+    uint32_t : Events in the elapsed time
+
+Example Call :
+    n = energy_events(&adv_phase_us, adv_period_us, dt);
+*/
+static uint32_t energy_events(uint32_t *phase_us, uint32_t period_us, uint32_t dt_ms)
+{
+    uint64_t t = (uint64_t)*phase_us + ((uint64_t)dt_ms * USEC_PER_MSEC);
+
+    *phase_us = (uint32_t)(t % period_us);
+    return (uint32_t)(t / period_us);
+}
+
+/*
+Function : energy_account
+
+Description :
+    Closes the interval since the last update with the states as they
+    were during it. Caller must hold energy_lock.
+
+Parameter :
+    None
+
+Return :
+    void
+
+Example Call :
+    energy_account();
+*/
+static void energy_account(void)
+{
+    struct energy_stats *st = &wake_ctx_get()->energy;
+    uint32_t now = k_uptime_get_32();
+    uint32_t dt = now - energy_last_ms;
+    enum energy_state conn_state = (energy_tier == POWER_TIER_ACTIVE) ? ENERGY_STATE_CONN_ACTIVE
+                                                                      : ENERGY_STATE_CONN_IDLE;
+    bool linked = false;
+
+    if (!dt)
+    {
+        return;
+    }
+    energy_last_ms = now;
+    st->on_ms += dt;
+
+    if (adv_period_us)
+    {
+        st->state_ms[ENERGY_STATE_ADV] += dt;
+        st->radio_events[ENERGY_STATE_ADV] += energy_events(&adv_phase_us, adv_period_us, dt);
+    }
+
+    for (size_t i = 0; i < ARRAY_SIZE(energy_links); i++)
+    {
+        struct energy_link *link = &energy_links[i];
+
+        if (link->period_us)
+        {
+            linked = true;
+            st->radio_events[conn_state] += energy_events(&link->phase_us, link->period_us, dt);
+        }
+    }
+    if (linked)
+    {
+        st->state_ms[conn_state] += dt;
+    }
+
+    for (enum energy_state s = ENERGY_STATE_IMU; s < ENERGY_STATE_COUNT; s++)
+    {
+        if (energy_on & BIT(s))
+        {
+            st->state_ms[s] += dt;
+        }
+    }
+}
+
+/*
+Function : energy_adv_set
+
+Description :
+    Records the advertising event period, or that advertising stopped.
+
+Parameter :
+    period_us : Mean time between advertising events, 0 when stopped
+
+Return :
+    void
+
+Example Call :
+    energy_adv_set(0);
+*/
+void energy_adv_set(uint32_t period_us)
+{
+    k_spinlock_key_t key = k_spin_lock(&energy_lock);
+
+    energy_account();
+    adv_period_us = period_us;
+    adv_phase_us = 0;
+    k_spin_unlock(&energy_lock, key);
+}
+
+/*
+Function : energy_link_params
+
+Description :
+    Records the connection parameters of a link as negotiated.
+
+Parameter :
+    conn     : Pointer to the Bluetooth connection
+    interval : Connection interval (1.25 ms units)
+    latency  : Peripheral latency (connection events)
+
+Return :
+    void
+
+Example Call :
+    energy_link_params(conn, interval, latency);
+*/
+void energy_link_params(struct bt_conn *conn, uint16_t interval, uint16_t latency)
+{
+    struct energy_link *link = &energy_links[bt_conn_index(conn)];
+    k_spinlock_key_t key = k_spin_lock(&energy_lock);
+
+    energy_account();
+    link->period_us = BT_CONN_INTERVAL_TO_US(interval) * (latency + 1U);
+    k_spin_unlock(&energy_lock, key);
+}
+
+/*
+Function : energy_link_up
+
+Description :
+    Starts counting the connection events of a new link with the
+    parameters it was created with.
+
+Parameter :
+    conn : Pointer to the Bluetooth connection
+
+Return :
+    void
+
+Example Call :
+    energy_link_up(conn);
+*/
+void energy_link_up(struct bt_conn *conn)
+{
+    struct bt_conn_info info;
+
+    if (bt_conn_get_info(conn, &info) == 0)
+    {
+        energy_link_params(conn, info.le.interval, info.le.latency);
+    }
+}
+
+/*
+Function : energy_link_down
+
+Description :
+    Stops counting the connection events of a link.
+
+Parameter :
+    conn : Pointer to the Bluetooth connection
+
+Return :
+    void
+
+Example Call :
+    energy_link_down(conn);
+*/
+void energy_link_down(struct bt_conn *conn)
+{
+    struct energy_link *link = &energy_links[bt_conn_index(conn)];
+    k_spinlock_key_t key = k_spin_lock(&energy_lock);
+
+    energy_account();
+    link->period_us = 0;
+    link->phase_us = 0;
+    k_spin_unlock(&energy_lock, key);
+}
+
+/*
+Function : energy_tier_set
+
+Description :
+    Records a power tier change, which moves the links between the
+    connected-active and connected-idle states. Entering system-off
+    closes the last interval before the wake context is saved.
+
+Parameter :
+    tier : Tier entered
+
+Return :
+    void
+
+Example Call :
+    energy_tier_set(POWER_TIER_IDLE);
+*/
+void energy_tier_set(enum power_tier tier)
+{
+    k_spinlock_key_t key = k_spin_lock(&energy_lock);
+
+    energy_account();
+    energy_tier = tier;
+    k_spin_unlock(&energy_lock, key);
+}
+
+/*
+Function : energy_state_set
+
+Description :
+    Records a load turning on or off. For ENERGY_STATE_IMU and
+    ENERGY_STATE_LED only; the radio states follow from the calls above.
+    Safe from ISR context.
+
+Parameter :
+    state : ENERGY_STATE_IMU or ENERGY_STATE_LED
+    on    : true when the load turned on
+
+Return :
+    void
+
+Example Call :
+    energy_state_set(ENERGY_STATE_LED, true);
+*/
+void energy_state_set(enum energy_state state, bool on)
+{
+    k_spinlock_key_t key = k_spin_lock(&energy_lock);
+
+    energy_account();
+    WRITE_BIT(energy_on, state, on);
+    k_spin_unlock(&energy_lock, key);
+}
+
+/*
+Function : energy_state_toggle
+
+Description :
+    Records a load flipping state, for callers that toggle a pin. Same
+    states as energy_state_set(); safe from ISR context.
+
+Parameter :
+    state : ENERGY_STATE_IMU or ENERGY_STATE_LED
+
+Return :
+    void
+
+Example Call :
+    energy_state_toggle(ENERGY_STATE_LED);
+*/
+void energy_state_toggle(enum energy_state state)
+{
+    k_spinlock_key_t key = k_spin_lock(&energy_lock);
+
+    energy_account();
+    energy_on ^= BIT(state);
+    k_spin_unlock(&energy_lock, key);
+}
+
+/*
+Function : energy_notify_sent
+
+Description :
+    Counts one HID notification completed by the stack.
+
+Parameter :
+    None
+
+Return :
+    void
+
+Example Call :
+    energy_notify_sent();
+*/
+void energy_notify_sent(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&energy_lock);
+
+    wake_ctx_get()->energy.notifications++;
+    k_spin_unlock(&energy_lock, key);
+}
+
+/*
+Function : energy_nah_print
+
+Description :
+    Prints one row of the energy table, the charge given in nAh and shown
+    in uAh.
+
+Parameter :
+    sh     : Shell to print to
+    name   : Row name
+    ms     : Time in the state
+    events : Radio events or notifications
+    nah    : Estimated charge (nAh)
+
+Return :
+    void
+
+Example Call :
+    energy_nah_print(sh, "system-on", st.on_ms, 0, nah);
+*/
+static void energy_nah_print(const struct shell *sh, const char *name, uint32_t ms,
+                             uint32_t events, uint32_t nah)
+{
+    shell_print(sh, "%-12s %10u %10u %8u.%03u", name, ms, events, nah / 1000U, nah % 1000U);
+}
+
+static int cmd_energy_stats(const struct shell *sh, size_t argc, char **argv)
+{
+    struct energy_stats st;
+    uint64_t total_nah;
+    uint32_t nah;
+    uint32_t avg_na;
+    k_spinlock_key_t key;
+
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    key = k_spin_lock(&energy_lock);
+    energy_account();
+    st = wake_ctx_get()->energy;
+    k_spin_unlock(&energy_lock, key);
+
+    shell_print(sh, "%-12s %10s %10s %12s", "state", "ms", "events", "uAh");
+
+    /* uA x ms and nC both make nA x s; / 3600 gives nAh */
+    total_nah = ((uint64_t)st.on_ms * CONFIG_APP_ENERGY_ON_UA) / 3600U;
+    energy_nah_print(sh, "system-on", st.on_ms, 0, (uint32_t)total_nah);
+
+    for (enum energy_state s = 0; s < ENERGY_STATE_COUNT; s++)
+    {
+        uint64_t nc = (uint64_t)st.state_ms[s] * state_ua[s];
+        uint32_t events = 0;
+
+        if (s < ENERGY_RADIO_STATES)
+        {
+            events = st.radio_events[s];
+            nc += (uint64_t)events * radio_event_nc[s];
+        }
+        nah = (uint32_t)(nc / 3600U);
+        total_nah += nah;
+        energy_nah_print(sh, state_name[s], st.state_ms[s], events, nah);
+    }
+
+    nah = (uint32_t)(((uint64_t)st.notifications * CONFIG_APP_ENERGY_NOTIFY_NC) / 3600U);
+    total_nah += nah;
+    energy_nah_print(sh, "notify", 0, st.notifications, nah);
+
+    /* nAh x 3600 / ms = uA; x 1000 for nA */
+    avg_na = st.on_ms ? (uint32_t)((total_nah * 3600U * 1000U) / st.on_ms) : 0;
+    shell_print(sh, "total %u.%03u uAh, %u s on, %u system-off, avg %u.%03u uA",
+                (uint32_t)(total_nah / 1000U), (uint32_t)(total_nah % 1000U),
+                st.on_ms / MSEC_PER_SEC, wake_ctx_get()->power.off_count, avg_na / 1000U,
+                avg_na % 1000U);
+    return 0;
+}
+
+static int cmd_energy_reset(const struct shell *sh, size_t argc, char **argv)
+{
+    k_spinlock_key_t key;
+
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    key = k_spin_lock(&energy_lock);
+    energy_account();
+    memset(&wake_ctx_get()->energy, 0, sizeof(struct energy_stats));
+    k_spin_unlock(&energy_lock, key);
+    shell_print(sh, "energy totals cleared");
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_energy,
+                               SHELL_CMD(stats, NULL, "Time, events and estimated uAh per state", cmd_energy_stats),
+                               SHELL_CMD(reset, NULL, "Clear the totals", cmd_energy_reset),
+                               SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(energy, &sub_energy, "Per-state energy accounting", NULL);
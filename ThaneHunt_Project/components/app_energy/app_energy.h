@@ -0,0 +1,80 @@
+/*
+Name : app_energy
+
+Description :
+    Energy accounting for the BLE HID keyboard. The owning modules report
+    their state changes (advertising, links and their parameters, power
+    tier, IMU, user LED, HID notifications); app_energy turns them into
+    time per state and estimated radio events, and with the current and
+    charge coefficients from Kconfig into an estimated charge per state,
+    read back over the shell. Without CONFIG_APP_ENERGY the hooks are
+    empty.
+
+Date : 2026-10-14
+
+Developer : Engineer Akbar Shah
+*/
+
+#ifndef APP_ENERGY_H
+#define APP_ENERGY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "app_sleep.h"
+
+struct bt_conn;
+
+/* Accounted states; they overlap, except the two connected ones */
+enum energy_state
+{
+    ENERGY_STATE_ADV = 0,     /* advertising set enabled                  */
+    ENERGY_STATE_CONN_ACTIVE, /* a link up, active power tier             */
+    ENERGY_STATE_CONN_IDLE,   /* a link up, idle or connected-sleep tier  */
+    ENERGY_STATE_IMU,         /* IMU sampling                             */
+    ENERGY_STATE_LED,         /* user LED lit                             */
+    ENERGY_STATE_COUNT
+};
+
+/* States with radio events: advertising and connection events */
+#define ENERGY_RADIO_STATES (ENERGY_STATE_CONN_IDLE + 1)
+
+/* Totals since the last cold boot, kept across system-off in the wake context */
+struct energy_stats
+{
+    uint32_t on_ms;                              /* system-on time */
+    uint32_t state_ms[ENERGY_STATE_COUNT];       /* time in each state */
+    uint32_t radio_events[ENERGY_RADIO_STATES];  /* estimated radio events in each state */
+    uint32_t notifications;                      /* HID notifications sent */
+};
+
+#if CONFIG_APP_ENERGY
+void energy_adv_set(uint32_t period_us);
+void energy_link_up(struct bt_conn *conn);
+void energy_link_params(struct bt_conn *conn, uint16_t interval, uint16_t latency);
+void energy_link_down(struct bt_conn *conn);
+void energy_tier_set(enum power_tier tier);
+void energy_state_set(enum energy_state state, bool on);
+void energy_state_toggle(enum energy_state state);
+void energy_notify_sent(void);
+#else
+static inline void energy_adv_set(uint32_t period_us) { (void)period_us; }
+static inline void energy_link_up(struct bt_conn *conn) { (void)conn; }
+static inline void energy_link_params(struct bt_conn *conn, uint16_t interval, uint16_t latency)
+{
+    (void)conn;
+    (void)interval;
+    (void)latency;
+}
+static inline void energy_link_down(struct bt_conn *conn) { (void)conn; }
+static inline void energy_tier_set(enum power_tier tier) { (void)tier; }
+static inline void energy_state_set(enum energy_state state, bool on)
+{
+    (void)state;
+    (void)on;
+}
+static inline void energy_state_toggle(enum energy_state state) { (void)state; }
+static inline void energy_notify_sent(void) {}
+#endif
+
+#endif // APP_ENERGY_H
@@ -0,0 +1,70 @@
+/*
+Name : app_events
+
+Description :
+    Application event set for the BLE HID keyboard. Modules post event bits
+    from any context (ISR, timer, work or thread) and the main thread blocks
+    on them, so nothing wakes the CPU unless something actually changed.
+
+Date : 2026-10-14
+
+Developer : Engineer Akbar Shah
+*/
+
+#include <zephyr/kernel.h>
+
+#include "app_events.h"
+
+static K_EVENT_DEFINE(app_events);
+
+/*
+Function : app_event_post
+
+Description :
+    Posts one or more event bits and wakes the thread waiting on them. Safe
+    to call from interrupt context.
+
+Parameter :
+    events : APP_EVT_* bits to post
+
+Return :
+    void
+
+Example Call :
+    app_event_post(APP_EVT_ADV_STATE);
+*/
+void app_event_post(uint32_t events)
+{
+    k_event_post(&app_events, events);
+}
+
+/*
+Function : app_event_wait
+
+Description :
+    Blocks until any of the requested events is posted, then consumes the
+    events that were seen. Events are cleared before the caller handles
+    them, so a post that races with the handling is kept for the next wait
+    instead of being lost; handlers must therefore re-read the state they
+    act on rather than count events.
+
+Parameter :
+    events  : APP_EVT_* bits to wait for
+    timeout : Maximum time to wait
+
+Return :
+    uint32_t : Posted events out of the requested ones, 0 on timeout
+
+Example Call :
+    uint32_t evt = app_event_wait(APP_EVT_ALL, K_FOREVER);
+*/
+uint32_t app_event_wait(uint32_t events, k_timeout_t timeout)
+{
+    uint32_t posted = k_event_wait(&app_events, events, false, timeout);
+
+    if (posted)
+    {
+        k_event_clear(&app_events, posted);
+    }
+    return posted;
+}
@@ -0,0 +1,29 @@
+/*
+Name : app_events
+
+Description :
+    Application event set for the BLE HID keyboard. Modules post event bits
+    from any context (ISR, timer, work or thread) and the main thread blocks
+    on them, so nothing wakes the CPU unless something actually changed.
+
+Date : 2026-10-14
+
+Developer : Engineer Akbar Shah
+*/
+
+#ifndef APP_EVENTS_H
+#define APP_EVENTS_H
+
+#include <stdint.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+
+/* Events handled by the main thread */
+#define APP_EVT_ADV_STATE BIT(0) /* advertising started or stopped */
+
+#define APP_EVT_ALL (APP_EVT_ADV_STATE)
+
+void app_event_post(uint32_t events);
+uint32_t app_event_wait(uint32_t events, k_timeout_t timeout);
+
+#endif // APP_EVENTS_H
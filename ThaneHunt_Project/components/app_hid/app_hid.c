@@ -7,7 +7,12 @@ Description :
     keyboard state, key press/release reporting, HID report map 
     initialization, protocol mode events, and output report handling 
     (e.g., Caps Lock). It works alongside the BLE module to enable full 
-    HID keyboard functionality.
+    HID keyboard functionality. Input events from any thread are posted to
+    a lock-free ring and applied by one HID TX thread, the only writer of
+    the report state. With the air mouse enabled it also carries
+    a relative mouse report fed with IMU motion deltas, and with
+    CONFIG_APP_HID_CONSUMER consumer (media) and system control reports
+    that are sent on their own when their state changes.
 
 Date : 2025-09-14
 
@@ -15,66 +20,349 @@ Developer : Engineer Akbar Shah
 */
 
 #include <assert.h>
+#include <bluetooth/conn_ctx.h>
 #include <bluetooth/services/hids.h>
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
+#include <zephyr/sys/byteorder.h>
 
 #include "app_ble.h"
+#include "app_button.h"
+#include "app_energy.h"
 #include "app_hid.h"
+#include "app_keycodes.h"
+#include "app_latency.h"
 
 LOG_MODULE_REGISTER(APP_HID);
  
+#define OUTPUT_REPORT_BIT_MASK_NUM_LOCK 0x01
 #define OUTPUT_REPORT_BIT_MASK_CAPS_LOCK 0x02
+#define OUTPUT_REPORT_BIT_MASK_SCROLL_LOCK 0x04
 
 #define BASE_USB_HID_SPEC_VERSION 0x0101
-#define INPUT_REP_KEYS_REF_ID 0
+#define INPUT_REP_KEYS_REF_ID 1
+#define INPUT_REP_NKRO_REF_ID 2
 #define OUTPUT_REPORT_MAX_LEN 1
-#define OUTPUT_REP_KEYS_REF_ID 0
+#define OUTPUT_REP_KEYS_REF_ID 1
+#define INPUT_REP_MOUSE_REF_ID 3
+#define INPUT_REPORT_MOUSE_LEN 5 /* Buttons, X (int16 LE), Y (int16 LE) */
+#define INPUT_REP_CONSUMER_REF_ID 4
+#define INPUT_REPORT_CONSUMER_LEN 2 /* One consumer usage (uint16 LE) */
+#define INPUT_REP_SYSTEM_REF_ID 5
+#define INPUT_REPORT_SYSTEM_LEN 1 /* Power down, sleep, wake up bits */
+
+#define CONSUMER_USAGE_MAX 0x03FF /* Highest usage in the report map */
+#define SYSTEM_USAGE_MIN HID_SYSTEM_POWER_DOWN
+#define SYSTEM_USAGE_MAX HID_SYSTEM_WAKE_UP
 
 #define KEY_CTRL_CODE_MIN 224 /* Control key codes - required 8 of them */
 #define KEY_CTRL_CODE_MAX 231 /* Control key codes - required 8 of them */
 
+#define KEY_ERROR_ROLLOVER 0x01 /* Keyboard ErrorRollOver usage */
+
 /* Current report map construction requires exactly 8 buttons */
 BUILD_ASSERT((KEY_CTRL_CODE_MAX - KEY_CTRL_CODE_MIN) + 1 == 8);
 
+/* One bit per usage 0x00-0xE7; the last byte holds the 8 control keys and
+ * doubles as the modifier byte of the 6KRO report.
+ */
+#define KEY_BITMAP_LEN ((KEY_CTRL_CODE_MAX + 1) / 8)
+#define KEY_BITMAP_CTRL_BYTE (KEY_CTRL_CODE_MIN / 8)
+#define INPUT_REPORT_NKRO_LEN KEY_BITMAP_LEN
+
+BUILD_ASSERT(KEY_BITMAP_CTRL_BYTE == KEY_BITMAP_LEN - 1);
+
 struct keyboard_state
 {
-	uint8_t ctrl_keys_state; /* Current keys state */
-	uint8_t keys_state[KEY_PRESS_MAX];
-} hid_keyboard_state;
+	uint8_t keys_bitmap[KEY_BITMAP_LEN]; /* Current keys state */
+	uint8_t keys_cnt;                    /* Non-control keys held */
+};
 
 enum
 {
-    INPUT_REP_KEYS_IDX = 0
+    INPUT_REP_KEYS_IDX = 0,
+#if CONFIG_APP_HID_NKRO
+    INPUT_REP_NKRO_IDX,
+#endif
+#if CONFIG_APP_AIR_MOUSE
+    INPUT_REP_MOUSE_IDX,
+#endif
+#if CONFIG_APP_HID_CONSUMER
+    INPUT_REP_CONSUMER_IDX,
+    INPUT_REP_SYSTEM_IDX,
+#endif
+    INPUT_REP_COUNT
 };
+BUILD_ASSERT(INPUT_REP_COUNT <= CONFIG_BT_HIDS_INPUT_REP_MAX,
+             "CONFIG_BT_HIDS_INPUT_REP_MAX is below the input reports in use");
 enum
 {
     OUTPUT_REP_KEYS_IDX = 0
 };
 
+/*
+ * Input events: producers (button thread, keymap, further input sources)
+ * post key, consumer and system events to a bounded lock-free MPSC ring and
+ * never block; the HID TX thread is its only consumer and the only writer
+ * of the key state, the TX queues and the control report state. Each slot
+ * carries a sequence number: a producer claims a position with a CAS on
+ * the tail and publishes the slot by advancing its sequence, the consumer
+ * frees it by advancing the sequence one lap. Presses leave
+ * HID_EVENT_RELEASE_RESERVE slots for releases. A release that still finds
+ * the ring full is parked in a bitmap applied once the ring is drained,
+ * and presses are refused until then, so a release is never lost nor
+ * overtaken by a later press.
+ */
+#define HID_EVENT_QUEUE_DEPTH CONFIG_APP_HID_EVENT_QUEUE_DEPTH
+#define HID_EVENT_RELEASE_RESERVE (HID_EVENT_QUEUE_DEPTH / 4)
+#define HID_EVENT_KEYS_MAX KEY_PRESS_MAX /* Longer key lists are split */
+
+BUILD_ASSERT(IS_POWER_OF_TWO(HID_EVENT_QUEUE_DEPTH));
+
+enum hid_event_type
+{
+    HID_EVENT_KEYS = 0,
+    HID_EVENT_CONSUMER,
+    HID_EVENT_SYSTEM,
+};
+
+struct hid_event
+{
+    uint8_t type;   /* enum hid_event_type */
+    bool pressed;
+    uint8_t cnt;    /* Key codes in keys[] (HID_EVENT_KEYS) */
+    uint16_t usage; /* Consumer or system usage */
+    uint8_t keys[HID_EVENT_KEYS_MAX];
+};
+
+struct hid_event_slot
+{
+    atomic_t seq; /* Position + 1 when readable, position + depth when free */
+    struct hid_event ev;
+};
+
+static struct hid_event_slot hid_events[HID_EVENT_QUEUE_DEPTH];
+static atomic_t hid_event_tail;      /* Next position to claim */
+static atomic_t hid_event_head;      /* Next position to read, HID TX thread */
+static ATOMIC_DEFINE(keys_release_parked, KEY_CTRL_CODE_MAX + 1);
+static atomic_t ctrl_release_parked; /* Bit 0: consumer, bit 1 + n: system usage n */
+static atomic_t release_parked;      /* Set while a parked release is not applied */
+static atomic_t events_rejected;     /* Presses refused by a full ring */
+
+#define HID_TX_THREAD_STACK_SIZE CONFIG_APP_HID_TX_THREAD_STACK_SIZE
+#define HID_TX_THREAD_PRIO 0 /* Same as the button thread, which posts a scan's events first */
+
+static K_SEM_DEFINE(hid_tx_sem, 0, 1); /* Events posted, reports sent or a host left */
+K_THREAD_STACK_DEFINE(hid_tx_thread_stack, HID_TX_THREAD_STACK_SIZE);
+static struct k_thread hid_tx_thread_data;
+
+static void hid_tx_thread_fn(void *p1, void *p2, void *p3);
+
+/*
+ * Report coalescing: the first change after a quiet period is sent at once,
+ * changes arriving within the following connection interval are merged into
+ * one report sent when the interval ends. hid_state_mutex serialises the
+ * HID TX thread with the Bluetooth callbacks that set up, switch and free
+ * connection contexts; it is always taken before a connection context and
+ * never held while waiting.
+ */
+static K_MUTEX_DEFINE(hid_state_mutex);
+static bool report_pending;
+static int64_t coalesce_window_end; /* Uptime ticks */
+static int64_t hid_tx_retry_at;     /* Uptime ticks of the next drain retry, 0 if none */
+static struct hid_tx_stats tx_stats;
+
+/*
+ * Host lock LEDs (output report bits), cached in the connection context.
+ * The user LED shows Caps Lock of the host that wrote its LEDs last and is
+ * only touched when that bit changes.
+ */
+static atomic_t lock_leds_owner = ATOMIC_INIT(-1); /* bt_conn_index(), -1 if none */
+static atomic_t lock_leds_shown;                   /* Output report bits of the owner */
+
+/*
+ * Asynchronous TX: every report is a snapshot of the key state queued per
+ * connection and handed to the stack while fewer than HID_TX_INFLIGHT_MAX
+ * notifications are outstanding; the notification-sent callback kicks the
+ * HID TX thread. The last queue slot is reserved for snapshots that only
+ * release keys, and a release arriving on a full queue is merged into a
+ * release tail, so a release is never dropped. Presses wait in the HID TX
+ * thread for a free slot while producers keep posting events.
+ */
+#define HID_TX_QUEUE_DEPTH CONFIG_APP_HID_TX_QUEUE_DEPTH
+#define HID_TX_INFLIGHT_MAX 2 /* Notifications outstanding per connection */
+#define HID_TX_RETRY_MS 5     /* Retry delay when the stack is out of buffers */
+
+struct hid_tx_slot
+{
+	struct keyboard_state state;
+	bool release; /* Only clears keys relative to the previous snapshot */
+};
+
+struct hid_tx_queue
+{
+	struct hid_tx_slot slot[HID_TX_QUEUE_DEPTH];
+	struct keyboard_state last_queued;
+	uint8_t head;
+	uint8_t count;
+	uint8_t in_flight;
+};
+
+/*
+ * Per-connection HID context, kept by the bt_conn_ctx library and looked up
+ * by bt_conn_index(). Every host has its own key state, so a host that
+ * connects while keys are held never sees their release without the press,
+ * and a disconnect only drops that host's keys. Contexts are only touched
+ * between bt_conn_ctx_get*() and bt_conn_ctx_release().
+ */
+struct hid_conn
+{
+	struct bt_conn *conn;
+	bool in_boot_mode;
+	struct keyboard_state state;     /* Keys held for this host */
+	struct keyboard_state last_sent; /* State carried by the last report */
+	struct hid_tx_queue tx;
+	uint8_t lock_leds; /* Last output report (Num/Caps/Scroll Lock bits) */
+};
+
+BT_CONN_CTX_DEF(hid_conns, CONFIG_BT_MAX_CONN, sizeof(struct hid_conn));
+
+/* Sent callbacks not yet accounted by the drain, by bt_conn_index() */
+static atomic_t hid_tx_completed[CONFIG_BT_MAX_CONN];
+
+#if CONFIG_APP_AIR_MOUSE
+/*
+ * Air mouse: motion deltas are accumulated and sent at most once per
+ * report period and never while the previous mouse notification is still
+ * outstanding, so several IMU blocks collapse into one report per
+ * connection event.
+ */
+#define MOUSE_REPORT_PERIOD_US (USEC_PER_SEC / CONFIG_APP_AIR_MOUSE_RATE_HZ)
+
+static struct k_spinlock mouse_lock; /* Guards the deltas and mouse_next_send */
+static int32_t mouse_dx, mouse_dy; /* Counts not reported yet */
+static atomic_t mouse_in_flight;   /* Bit i: report outstanding on bt_conn_index() i */
+static int64_t mouse_next_send;    /* Uptime ticks of the earliest next report */
+
+static void mouse_report_fn(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(mouse_report_work, mouse_report_fn);
+#endif
+
+#if CONFIG_APP_HID_CONSUMER
+/*
+ * Consumer and system control: each report has its own state and goes out
+ * on its own, from the HID TX thread, only when that state changes. The
+ * stack queues the notifications in order, so no snapshot queue is needed.
+ * A report the stack has no buffer for is marked pending and sent again,
+ * with the state current by then, on the HID TX thread's retry deadline
+ * for up to CONFIG_APP_HID_TX_BACKPRESSURE_MS; the thread never waits for
+ * it. All of it belongs to the HID TX thread.
+ */
+#define CTRL_REP_CONSUMER BIT(0)
+#define CTRL_REP_SYSTEM BIT(1)
+
+static uint16_t consumer_usage; /* Held consumer usage, 0 if none */
+static uint8_t system_bits;     /* Bit n: system usage SYSTEM_USAGE_MIN + n held */
+static uint8_t ctrl_pending;    /* CTRL_REP_* waiting for a buffer */
+static int64_t ctrl_retry_at;   /* Uptime ticks of the next retry, 0 if none */
+static int64_t ctrl_give_up;    /* Uptime ticks at which pending reports are dropped */
+#endif
+
+/* Input report lengths, in INPUT_REP_*_IDX order */
+#if CONFIG_APP_HID_NKRO
+#define HID_INP_LEN_NKRO , INPUT_REPORT_NKRO_LEN
+#else
+#define HID_INP_LEN_NKRO
+#endif
+#if CONFIG_APP_AIR_MOUSE
+#define HID_INP_LEN_MOUSE , INPUT_REPORT_MOUSE_LEN
+#else
+#define HID_INP_LEN_MOUSE
+#endif
+#if CONFIG_APP_HID_CONSUMER
+#define HID_INP_LEN_CTRL , INPUT_REPORT_CONSUMER_LEN, INPUT_REPORT_SYSTEM_LEN
+#else
+#define HID_INP_LEN_CTRL
+#endif
+
 BT_HIDS_DEF(hids_obj,
             OUTPUT_REPORT_MAX_LEN,
-            INPUT_REPORT_KEYS_MAX_LEN);
+            INPUT_REPORT_KEYS_MAX_LEN HID_INP_LEN_NKRO HID_INP_LEN_MOUSE HID_INP_LEN_CTRL);
 
 /*
-Function : caps_lock_handler
+Function : lock_leds_apply
 
 Description : 
-    Handles the state change of the Caps Lock key by checking the output 
-    report data from the host. Currently only retrieves the Caps Lock state.
+    Applies a host LED output report (Num/Caps/Scroll Lock bits) in O(1):
+    caches it for the connection and drives the user LED only when the
+    Caps Lock bit it shows changes. No formatting or logging beyond debug
+    level on this path.
 
 Parameter : 
-    rep : Pointer to the HID output report structure containing LED states
+    rep  : Pointer to the HID output report structure containing LED states
+    conn : Pointer to the Bluetooth connection that wrote the report
 
 Return : 
     void
 
 Example Call : 
-    caps_lock_handler(rep);
+    lock_leds_apply(rep, conn);
+*/
+static void lock_leds_apply(const struct bt_hids_rep *rep, struct bt_conn *conn)
+{
+    uint8_t idx = bt_conn_index(conn);
+    struct hid_conn *hc;
+    uint8_t leds;
+    uint8_t prev;
+    atomic_val_t owner;
+
+    if (!rep->data || !rep->size)
+    {
+        return;
+    }
+
+    hc = bt_conn_ctx_get(&hid_conns, conn);
+    if (!hc)
+    {
+        return;
+    }
+    leds = rep->data[0];
+    prev = hc->lock_leds;
+    hc->lock_leds = leds;
+    bt_conn_ctx_release(&hid_conns, hc);
+
+    owner = atomic_set(&lock_leds_owner, idx);
+    if (owner == idx && prev == leds)
+    {
+        return;
+    }
+
+    LOG_DBG("Lock LEDs 0x%02X (conn %u)", leds, idx);
+    atomic_set(&lock_leds_shown, leds);
+    user_led_lock_set(leds & OUTPUT_REPORT_BIT_MASK_CAPS_LOCK);
+}
+
+/*
+Function : hid_lock_leds_get
+
+Description : 
+    Returns the host lock LED bits shown on the device: the last output
+    report of the host that wrote one most recently.
+
+Parameter : 
+    None
+
+Return : 
+    uint8_t : Output report bits (bit 0 Num, 1 Caps, 2 Scroll Lock),
+              0 if no connected host wrote its LEDs
+
+Example Call : 
+    bool caps = hid_lock_leds_get() & 0x02;
 */
-static void caps_lock_handler(const struct bt_hids_rep *rep)
+uint8_t hid_lock_leds_get(void)
 {
-    uint8_t report_val = ((*rep->data) & OUTPUT_REPORT_BIT_MASK_CAPS_LOCK) ? 1 : 0;
-    (void)report_val; /* silence -Wunused-variable for now */
+    return (uint8_t)atomic_get(&lock_leds_shown);
 }
 
 /*
@@ -102,12 +390,89 @@ static uint8_t button_ctrl_code(uint8_t key)
 	return 0;
 }
 
+/*
+Function : key_report_sent
+
+Description : 
+    Notification completion callback for keyboard input reports. Credits
+    the connection's TX queue and wakes the HID TX thread. Also marks the end
+    of the key event trace when latency tracing is enabled.
+
+Parameter : 
+    conn      : Pointer to the Bluetooth connection the report was sent on
+    user_data : Unused
+
+Return : 
+    void
+
+Example Call : 
+    passed to bt_hids_inp_rep_send(..., key_report_sent);
+*/
+static void key_report_sent(struct bt_conn *conn, void *user_data)
+{
+    ARG_UNUSED(user_data);
+
+    latency_trace_stamp(LATENCY_STAGE_SENT);
+    energy_notify_sent();
+
+    atomic_inc(&hid_tx_completed[bt_conn_index(conn)]);
+    k_sem_give(&hid_tx_sem);
+}
+
+/*
+Function : key_report_6kro_build
+
+Description : 
+    Synthesizes a 6KRO keyboard report (modifier byte, reserved byte and
+    six key slots) from the key bitmap. When more than six non-control keys
+    are held every slot carries ErrorRollOver, as the HID spec requires.
+
+Parameter : 
+    state : Pointer to the keyboard_state structure containing key states
+    data  : Output buffer of INPUT_REPORT_KEYS_MAX_LEN bytes
+
+Return : 
+    void
+
+Example Call : 
+    key_report_6kro_build(&hc->state, data);
+*/
+static void key_report_6kro_build(const struct keyboard_state *state,
+                                  uint8_t *data)
+{
+    uint8_t *key_data = &data[SCAN_CODE_POS];
+    size_t n = 0;
+
+    data[0] = state->keys_bitmap[KEY_BITMAP_CTRL_BYTE];
+    data[1] = 0;
+
+    if (state->keys_cnt > KEY_PRESS_MAX)
+    {
+        memset(key_data, KEY_ERROR_ROLLOVER, KEY_PRESS_MAX);
+        return;
+    }
+
+    memset(key_data, 0, KEY_PRESS_MAX);
+    for (size_t byte = 0; byte < KEY_BITMAP_CTRL_BYTE && n < state->keys_cnt; byte++)
+    {
+        uint8_t bits = state->keys_bitmap[byte];
+
+        while (bits)
+        {
+            key_data[n++] = (uint8_t)((byte * 8) + __builtin_ctz(bits));
+            bits &= bits - 1;
+        }
+    }
+}
+
 /*
 Function : key_report_con_send
 
 Description : 
-    Sends a keyboard input report (either in boot or report mode) to a 
-    connected device using the HID service.
+    Sends a keyboard input report to a connected device using the HID
+    service. Boot mode hosts get the 6KRO boot report; in report mode the
+    NKRO bitmap report is sent when CONFIG_APP_HID_NKRO is enabled,
+    otherwise the 6KRO report.
 
 Parameter : 
     state     : Pointer to the keyboard_state structure containing key states
@@ -118,7 +483,7 @@ Return :
     int : 0 on success, negative error code on failure
 
 Example Call : 
-    key_report_con_send(&hid_keyboard_state, false, conn);
+    key_report_con_send(&hc->state, false, conn);
 */
 int key_report_con_send(const struct keyboard_state *state,
                         bool boot_mode,
@@ -126,29 +491,28 @@ int key_report_con_send(const struct keyboard_state *state,
 {
     int err = 0;
     uint8_t data[INPUT_REPORT_KEYS_MAX_LEN];
-    uint8_t *key_data;
-    const uint8_t *key_state;
-    size_t n;
-
-    data[0] = state->ctrl_keys_state;
-    data[1] = 0;
-    key_data = &data[2];
-    key_state = state->keys_state;
+    bt_gatt_complete_func_t sent_cb = key_report_sent;
 
-    for (n = 0; n < KEY_PRESS_MAX; ++n)
+#if CONFIG_APP_HID_NKRO
+    if (!boot_mode)
     {
-        *key_data++ = *key_state++;
+        return bt_hids_inp_rep_send(&hids_obj, conn,
+                                    INPUT_REP_NKRO_IDX, state->keys_bitmap,
+                                    sizeof(state->keys_bitmap), sent_cb);
     }
+#endif
+
+    key_report_6kro_build(state, data);
     if (boot_mode)
     {
         err = bt_hids_boot_kb_inp_rep_send(&hids_obj, conn, data,
-                                           sizeof(data), NULL);
+                                           sizeof(data), sent_cb);
     }
     else
     {
         err = bt_hids_inp_rep_send(&hids_obj, conn,
                                    INPUT_REP_KEYS_IDX, data,
-                                   sizeof(data), NULL);
+                                   sizeof(data), sent_cb);
     }
     return err;
 }
@@ -158,27 +522,81 @@ int key_report_con_send(const struct keyboard_state *state,
 Function : connect_bt_hid
 
 Description : 
-    Notifies the HID service that a new device has connected.
+    Notifies the HID service that a new device has connected and sets up
+    its HID context: report mode, no keys held, empty TX queue.
 
 Parameter : 
     conn : Pointer to the Bluetooth connection structure
 
 Return : 
-    int : 0 on success, negative error code on failure
+    int : 0 on success, -ENOMEM if every HID client slot is taken,
+          other negative error code on failure
 
 Example Call : 
     connect_bt_hid(conn);
 */
 int connect_bt_hid(struct bt_conn *conn)
 {
-    return bt_hids_connected(&hids_obj, conn);
+    struct hid_conn *hc;
+    int err;
+
+    if (bt_conn_ctx_count(&hid_conns) >= CONFIG_BT_HIDS_MAX_CLIENT_COUNT)
+    {
+        return -ENOMEM;
+    }
+
+    err = bt_hids_connected(&hids_obj, conn);
+    if (err)
+    {
+        return err;
+    }
+
+    k_mutex_lock(&hid_state_mutex, K_FOREVER);
+    hc = bt_conn_ctx_alloc(&hid_conns, conn);
+    if (hc)
+    {
+        memset(hc, 0, sizeof(*hc));
+        hc->conn = conn;
+        atomic_clear(&hid_tx_completed[bt_conn_index(conn)]);
+        bt_conn_ctx_release(&hid_conns, hc);
+    }
+    k_mutex_unlock(&hid_state_mutex);
+
+    if (!hc)
+    {
+        (void)bt_hids_disconnected(&hids_obj, conn);
+        return -ENOMEM;
+    }
+    return 0;
+}
+
+/*
+Function : hid_conn_count
+
+Description : 
+    Returns the number of connected HID clients.
+
+Parameter : 
+    None
+
+Return : 
+    size_t : Connections with a HID context
+
+Example Call : 
+    if (hid_conn_count() < CONFIG_BT_HIDS_MAX_CLIENT_COUNT) { ... }
+*/
+size_t hid_conn_count(void)
+{
+    return bt_conn_ctx_count(&hid_conns);
 }
 
 /*
 Function : disconnect_bt_hid
 
 Description : 
-    Notifies the HID service that a device has disconnected.
+    Notifies the HID service that a device has disconnected and frees its
+    HID context, dropping the keys held for that host and its queued
+    reports. Calling it again for the same connection does nothing.
 
 Parameter : 
     conn : Pointer to the Bluetooth connection structure
@@ -191,15 +609,69 @@ Example Call :
 */
 int disconnect_bt_hid(struct bt_conn *conn)
 {
+    struct hid_tx_stats stats;
+    uint8_t idx = bt_conn_index(conn);
+
+    k_mutex_lock(&hid_state_mutex, K_FOREVER);
+    if (bt_conn_ctx_free(&hid_conns, conn))
+    {
+        k_mutex_unlock(&hid_state_mutex);
+        return 0; /* no HID context: already torn down */
+    }
+    atomic_clear(&hid_tx_completed[idx]);
+#if CONFIG_APP_AIR_MOUSE
+    atomic_clear_bit(&mouse_in_flight, idx);
+#endif
+    k_mutex_unlock(&hid_state_mutex);
+    k_sem_give(&hid_tx_sem); /* a press waiting for this host's queue can go */
+
+    if (atomic_cas(&lock_leds_owner, idx, -1))
+    {
+        atomic_clear(&lock_leds_shown);
+        user_led_lock_set(false); /* host gone, its lock state with it */
+    }
+
+    hid_tx_stats_get(&stats);
+    LOG_INF("HID reports sent %u merged %u flushed %u dropped %u waits %u rejected %u\n",
+            stats.sent, stats.merged, stats.flushed, stats.dropped, stats.waits,
+            stats.rejected);
+
     return bt_hids_disconnected(&hids_obj, conn);
 }
 
+/*
+Function : hid_tx_stats_get
+
+Description : 
+    Copies the report TX counters: reports sent, state changes merged into
+    a pending report, pending reports flushed early to keep press/release
+    ordering, reports dropped on send errors or a stalled TX queue, presses
+    held back by a full TX queue and presses refused by a full event ring.
+
+Parameter : 
+    out : Output counters
+
+Return : 
+    void
+
+Example Call : 
+    struct hid_tx_stats stats;
+    hid_tx_stats_get(&stats);
+*/
+void hid_tx_stats_get(struct hid_tx_stats *out)
+{
+    k_mutex_lock(&hid_state_mutex, K_FOREVER);
+    *out = tx_stats;
+    k_mutex_unlock(&hid_state_mutex);
+    out->rejected = (uint32_t)atomic_get(&events_rejected);
+}
+
 /*
 Function : hids_boot_kb_outp_rep_handler
 
 Description : 
-    Callback handler for processing Boot Keyboard output reports. Logs 
-    events and handles Caps Lock state when written.
+    Callback handler for processing Boot Keyboard output reports. Applies
+    the host lock LEDs when written.
 
 Parameter : 
     rep   : Pointer to HID output report
@@ -217,17 +689,13 @@ static void hids_boot_kb_outp_rep_handler(struct bt_hids_rep *rep,
                                           struct bt_conn *conn,
                                           bool write)
 {
-    char addr[BT_ADDR_LE_STR_LEN];
-
     if (!write)
     {
-        LOG_INF("Output report read\n");
+        LOG_DBG("Output report read");
         return;
     };
 
-    bt_addr_le_to_str(bt_conn_get_dst(conn), addr, sizeof(addr));
-    LOG_INF("Boot Keyboard Output report has been received %s\n", addr);
-    caps_lock_handler(rep);
+    lock_leds_apply(rep, conn);
 }
 
 /*
@@ -235,7 +703,7 @@ Function : hids_pm_evt_handler
 
 Description : 
     Handles HID protocol mode events (boot mode entered, report mode entered). 
-    Updates the connection mode state accordingly.
+    Updates the protocol mode in the connection's HID context.
 
 Parameter : 
     evt  : Protocol mode event type
@@ -250,48 +718,39 @@ Example Call :
 static void hids_pm_evt_handler(enum bt_hids_pm_evt evt,
                                 struct bt_conn *conn)
 {
-    char addr[BT_ADDR_LE_STR_LEN];
-    size_t i;
+    struct hid_conn *hc;
 
-    for (i = 0; i < CONFIG_BT_HIDS_MAX_CLIENT_COUNT; i++)
+    if ((evt != BT_HIDS_PM_EVT_BOOT_MODE_ENTERED) &&
+        (evt != BT_HIDS_PM_EVT_REPORT_MODE_ENTERED))
     {
-        if (conn_mode[i].conn == conn)
-        {
-            break;
-        }
+        return;
     }
 
-    if (i >= CONFIG_BT_HIDS_MAX_CLIENT_COUNT)
+    k_mutex_lock(&hid_state_mutex, K_FOREVER);
+    hc = bt_conn_ctx_get(&hid_conns, conn);
+    if (hc)
     {
-        LOG_INF("Cannot find connection handle when processing PM");
-        return;
+        hc->in_boot_mode = (evt == BT_HIDS_PM_EVT_BOOT_MODE_ENTERED);
+        bt_conn_ctx_release(&hid_conns, hc);
     }
+    k_mutex_unlock(&hid_state_mutex);
 
-    bt_addr_le_to_str(bt_conn_get_dst(conn), addr, sizeof(addr));
-
-    switch (evt)
+    if (!hc)
     {
-    case BT_HIDS_PM_EVT_BOOT_MODE_ENTERED:
-        LOG_INF("Boot mode entered %s\n", addr);
-        conn_mode[i].in_boot_mode = true;
-        break;
-
-    case BT_HIDS_PM_EVT_REPORT_MODE_ENTERED:
-        LOG_INF("Report mode entered %s\n", addr);
-        conn_mode[i].in_boot_mode = false;
-        break;
-
-    default:
-        break;
+        LOG_INF("Cannot find connection handle when processing PM");
+        return;
     }
+    LOG_INF("%s mode entered (conn %u)\n",
+            (evt == BT_HIDS_PM_EVT_BOOT_MODE_ENTERED) ? "Boot" : "Report",
+            bt_conn_index(conn));
 }
 
 /*
 Function : hids_outp_rep_handler
 
 Description : 
-    Callback handler for processing standard HID output reports. Logs events 
-    and handles Caps Lock state when written.
+    Callback handler for processing standard HID output reports. Applies
+    the host lock LEDs when written.
 
 Parameter : 
     rep   : Pointer to HID output report
@@ -309,17 +768,13 @@ static void hids_outp_rep_handler(struct bt_hids_rep *rep,
                                   struct bt_conn *conn,
                                   bool write)
 {
-    char addr[BT_ADDR_LE_STR_LEN];
-
     if (!write)
     {
-        LOG_INF("Output report read\n");
+        LOG_DBG("Output report read");
         return;
     };
 
-    bt_addr_le_to_str(bt_conn_get_dst(conn), addr, sizeof(addr));
-    LOG_INF("Output report has been received %s\n", addr);
-    caps_lock_handler(rep);
+    lock_leds_apply(rep, conn);
 }
 
 /*
@@ -328,7 +783,7 @@ Function : hid_init
 Description : 
     Initializes the HID service by setting up input/output report structures, 
     report map, protocol mode handlers, and registering the HID device with 
-    the Bluetooth stack.
+    the Bluetooth stack. Starts the HID TX thread.
 
 Parameter : 
     None
@@ -379,6 +834,19 @@ void hid_init(void)
         0x29, 0x65, /* Usage Maximum (101) */
         0x81, 0x00, /* Input (Data, Array) Key array(6 bytes) */
 
+#if CONFIG_APP_HID_NKRO
+    /* NKRO keys: one bit per usage 0x00-0xE7 */
+        0x85, INPUT_REP_NKRO_REF_ID,
+        0x05, 0x07, /* Usage Page (Key Codes) */
+        0x19, 0x00, /* Usage Minimum (0) */
+        0x29, 0xe7, /* Usage Maximum (231) */
+        0x15, 0x00, /* Logical Minimum (0) */
+        0x25, 0x01, /* Logical Maximum (1) */
+        0x75, 0x01, /* Report Size (1) */
+        0x95, 0xe8, /* Report Count (232) */
+        0x81, 0x02, /* Input (Data, Variable, Absolute) Key bitmap(29 bytes) */
+#endif
+
     /* LED */
 #if OUTPUT_REP_KEYS_REF_ID
         0x85, OUTPUT_REP_KEYS_REF_ID,
@@ -395,7 +863,68 @@ void hid_init(void)
         0x91, 0x01, /* Output (Data, Variable, Absolute), */
         /* Led report padding */
 
-        0xC0 /* End Collection (Application) */
+        0xC0, /* End Collection (Application) */
+
+#if CONFIG_APP_AIR_MOUSE
+        0x05, 0x01, /* Usage Page (Generic Desktop) */
+        0x09, 0x02, /* Usage (Mouse) */
+        0xA1, 0x01, /* Collection (Application) */
+        0x85, INPUT_REP_MOUSE_REF_ID,
+        0x09, 0x01, /* Usage (Pointer) */
+        0xA1, 0x00, /* Collection (Physical) */
+        0x05, 0x09, /* Usage Page (Buttons) */
+        0x19, 0x01, /* Usage Minimum (1) */
+        0x29, 0x03, /* Usage Maximum (3) */
+        0x15, 0x00, /* Logical Minimum (0) */
+        0x25, 0x01, /* Logical Maximum (1) */
+        0x75, 0x01, /* Report Size (1) */
+        0x95, 0x03, /* Report Count (3) */
+        0x81, 0x02, /* Input (Data, Variable, Absolute) buttons */
+        0x75, 0x05, /* Report Size (5) */
+        0x95, 0x01, /* Report Count (1) */
+        0x81, 0x01, /* Input (Constant) button padding */
+        0x05, 0x01, /* Usage Page (Generic Desktop) */
+        0x09, 0x30, /* Usage (X) */
+        0x09, 0x31, /* Usage (Y) */
+        0x16, 0x01, 0x80, /* Logical Minimum (-32767) */
+        0x26, 0xFF, 0x7F, /* Logical Maximum (32767) */
+        0x75, 0x10, /* Report Size (16) */
+        0x95, 0x02, /* Report Count (2) */
+        0x81, 0x06, /* Input (Data, Variable, Relative) X, Y */
+        0xC0,       /* End Collection (Physical) */
+        0xC0,       /* End Collection (Application) */
+#endif
+
+#if CONFIG_APP_HID_CONSUMER
+        0x05, 0x0C, /* Usage Page (Consumer) */
+        0x09, 0x01, /* Usage (Consumer Control) */
+        0xA1, 0x01, /* Collection (Application) */
+        0x85, INPUT_REP_CONSUMER_REF_ID,
+        0x15, 0x00, /* Logical Minimum (0) */
+        0x26, 0xFF, 0x03, /* Logical Maximum (1023) */
+        0x19, 0x00, /* Usage Minimum (0) */
+        0x2A, 0xFF, 0x03, /* Usage Maximum (1023) */
+        0x75, 0x10, /* Report Size (16) */
+        0x95, 0x01, /* Report Count (1) */
+        0x81, 0x00, /* Input (Data, Array) consumer usage */
+        0xC0,       /* End Collection (Application) */
+
+        0x05, 0x01, /* Usage Page (Generic Desktop) */
+        0x09, 0x80, /* Usage (System Control) */
+        0xA1, 0x01, /* Collection (Application) */
+        0x85, INPUT_REP_SYSTEM_REF_ID,
+        0x19, SYSTEM_USAGE_MIN, /* Usage Minimum (System Power Down) */
+        0x29, SYSTEM_USAGE_MAX, /* Usage Maximum (System Wake Up) */
+        0x15, 0x00, /* Logical Minimum (0) */
+        0x25, 0x01, /* Logical Maximum (1) */
+        0x75, 0x01, /* Report Size (1) */
+        0x95, 0x03, /* Report Count (3) */
+        0x81, 0x02, /* Input (Data, Variable, Absolute) system bits */
+        0x75, 0x05, /* Report Size (5) */
+        0x95, 0x01, /* Report Count (1) */
+        0x81, 0x01, /* Input (Constant) padding */
+        0xC0,       /* End Collection (Application) */
+#endif
     };
 
     hids_init_obj.rep_map.data = report_map;
@@ -412,6 +941,36 @@ void hid_init(void)
     hids_inp_rep->id = INPUT_REP_KEYS_REF_ID;
     hids_init_obj.inp_rep_group_init.cnt++;
 
+#if CONFIG_APP_HID_NKRO
+    hids_inp_rep =
+        &hids_init_obj.inp_rep_group_init.reports[INPUT_REP_NKRO_IDX];
+    hids_inp_rep->size = INPUT_REPORT_NKRO_LEN;
+    hids_inp_rep->id = INPUT_REP_NKRO_REF_ID;
+    hids_init_obj.inp_rep_group_init.cnt++;
+#endif
+
+#if CONFIG_APP_AIR_MOUSE
+    hids_inp_rep =
+        &hids_init_obj.inp_rep_group_init.reports[INPUT_REP_MOUSE_IDX];
+    hids_inp_rep->size = INPUT_REPORT_MOUSE_LEN;
+    hids_inp_rep->id = INPUT_REP_MOUSE_REF_ID;
+    hids_init_obj.inp_rep_group_init.cnt++;
+#endif
+
+#if CONFIG_APP_HID_CONSUMER
+    hids_inp_rep =
+        &hids_init_obj.inp_rep_group_init.reports[INPUT_REP_CONSUMER_IDX];
+    hids_inp_rep->size = INPUT_REPORT_CONSUMER_LEN;
+    hids_inp_rep->id = INPUT_REP_CONSUMER_REF_ID;
+    hids_init_obj.inp_rep_group_init.cnt++;
+
+    hids_inp_rep =
+        &hids_init_obj.inp_rep_group_init.reports[INPUT_REP_SYSTEM_IDX];
+    hids_inp_rep->size = INPUT_REPORT_SYSTEM_LEN;
+    hids_inp_rep->id = INPUT_REP_SYSTEM_REF_ID;
+    hids_init_obj.inp_rep_group_init.cnt++;
+#endif
+
     hids_outp_rep =
         &hids_init_obj.outp_rep_group_init.reports[OUTPUT_REP_KEYS_IDX];
     hids_outp_rep->size = OUTPUT_REPORT_MAX_LEN;
@@ -425,185 +984,1604 @@ void hid_init(void)
 
     err = bt_hids_init(&hids_obj, &hids_init_obj);
     __ASSERT(err == 0, "HIDS initialization failed\n");
+
+    for (size_t i = 0; i < HID_EVENT_QUEUE_DEPTH; i++)
+    {
+        atomic_set(&hid_events[i].seq, (atomic_val_t)i);
+    }
+    k_thread_create(&hid_tx_thread_data, hid_tx_thread_stack,
+                    K_THREAD_STACK_SIZEOF(hid_tx_thread_stack), hid_tx_thread_fn,
+                    NULL, NULL, NULL, HID_TX_THREAD_PRIO, 0, K_NO_WAIT);
+    k_thread_name_set(&hid_tx_thread_data, "hid_tx");
 }
 
 /*
 Function : hid_kbd_state_key_set
 
 Description : 
-    Updates the internal keyboard state by setting a key as pressed. Handles 
-    both control and standard keys. Fails if all key slots are busy.
+    Updates a keyboard state by setting a key as pressed in the key
+    bitmap. Handles both control and standard keys in O(1). Without
+    CONFIG_APP_HID_NKRO the 6KRO limit still applies to standard keys.
 
 Parameter : 
-    key : HID key code to set
+    state : Keyboard state of one connection
+    key   : HID key code to set
 
 Return : 
-    int : 0 on success, -EBUSY if no free slots available
+    int : 0 on success, -EINVAL for a code above 0xE7,
+          -EBUSY if six keys are already held in 6KRO-only builds
 
 Example Call : 
-    hid_kbd_state_key_set(key);
+    hid_kbd_state_key_set(&hc->state, key);
 */
-static int hid_kbd_state_key_set(uint8_t key)
+static int hid_kbd_state_key_set(struct keyboard_state *state, uint8_t key)
 {
-	uint8_t ctrl_mask = button_ctrl_code(key);
+	uint8_t *byte;
+	uint8_t mask;
+
+	if (key > KEY_CTRL_CODE_MAX)
+	{
+		return -EINVAL;
+	}
+	if (key == 0)
+	{
+		/* Usage 0 means "no key" */
+		return 0;
+	}
 
-	if (ctrl_mask)
+	byte = &state->keys_bitmap[key / 8];
+	mask = BIT(key % 8);
+	if (*byte & mask)
 	{
-		hid_keyboard_state.ctrl_keys_state |= ctrl_mask;
 		return 0;
 	}
-	for (size_t i = 0; i < KEY_PRESS_MAX; ++i)
+	if (!button_ctrl_code(key))
 	{
-		if (hid_keyboard_state.keys_state[i] == 0)
+		if (!IS_ENABLED(CONFIG_APP_HID_NKRO) &&
+		    state->keys_cnt >= KEY_PRESS_MAX)
 		{
-			hid_keyboard_state.keys_state[i] = key;
-			return 0;
+			/* All slots busy */
+			return -EBUSY;
 		}
+		state->keys_cnt++;
 	}
-	/* All slots busy */
-	return -EBUSY;
+	*byte |= mask;
+	return 0;
 }
 
 /*
 Function : hid_kbd_state_key_clear
 
 Description : 
-    Updates the internal keyboard state by clearing a previously pressed key. 
-    Handles both control and standard keys. Fails if key is not found.
+    Updates a keyboard state by clearing a previously pressed key from the
+    key bitmap. Handles both control and standard keys in O(1).
 
 Parameter : 
-    key : HID key code to clear
+    state : Keyboard state of one connection
+    key   : HID key code to clear
 
 Return : 
-    int : 0 on success, -EINVAL if key not found
+    int : 0 on success, -EINVAL for a code above 0xE7
 
 Example Call : 
-    hid_kbd_state_key_clear(key);
+    hid_kbd_state_key_clear(&hc->state, key);
 */
-static int hid_kbd_state_key_clear(uint8_t key)
+static int hid_kbd_state_key_clear(struct keyboard_state *state, uint8_t key)
 {
-	uint8_t ctrl_mask = button_ctrl_code(key);
+	uint8_t *byte;
+	uint8_t mask;
+
+	if (key > KEY_CTRL_CODE_MAX)
+	{
+		return -EINVAL;
+	}
+	if (key == 0)
+	{
+		/* Usage 0 means "no key" */
+		return 0;
+	}
 
-	if (ctrl_mask)
+	byte = &state->keys_bitmap[key / 8];
+	mask = BIT(key % 8);
+	if (!(*byte & mask))
 	{
-		hid_keyboard_state.ctrl_keys_state &= ~ctrl_mask;
+		/* Key not found */
 		return 0;
 	}
-	for (size_t i = 0; i < KEY_PRESS_MAX; ++i)
+	*byte &= ~mask;
+	if (!button_ctrl_code(key))
 	{
-		if (hid_keyboard_state.keys_state[i] == key)
-		{
-			hid_keyboard_state.keys_state[i] = 0;
-			return 0;
-		}
+		state->keys_cnt--;
 	}
-	/* Key not found */
 	return 0;
 }
 
 /*
-Function : key_report_send
+Function : hid_tx_is_release
 
 Description : 
-    Sends the current keyboard state as an HID report to all connected 
-    clients. Iterates through all active connections.
+    Checks whether going from one key state to another only releases keys.
 
 Parameter : 
-    None
+    prev : Earlier key state
+    next : Later key state
 
 Return : 
-    int : 0 on success, negative error code on failure
+    bool : true if next has no key set that prev did not have
 
 Example Call : 
-    key_report_send();
+    bool release = hid_tx_is_release(&q->last_queued, &hc->state);
 */
-static int key_report_send(void)
+static bool hid_tx_is_release(const struct keyboard_state *prev,
+							  const struct keyboard_state *next)
 {
-	for (size_t i = 0; i < CONFIG_BT_HIDS_MAX_CLIENT_COUNT; i++)
+	for (size_t i = 0; i < KEY_BITMAP_LEN; i++)
 	{
-		if (conn_mode[i].conn)
+		if (next->keys_bitmap[i] & ~prev->keys_bitmap[i])
 		{
-			int err;
-
-			err = key_report_con_send(&hid_keyboard_state,
-									  conn_mode[i].in_boot_mode,
-									  conn_mode[i].conn);
-			if (err)
-			{
-				LOG_INF("Key report send error: %d\n", err);
-				return err;
-			}
+			return false;
 		}
 	}
-	return 0;
+	return true;
 }
 
 /*
-Function : hid_buttons_press
+Function : hid_tx_enqueue
 
 Description : 
-    Marks one or more keys as pressed in the keyboard state and sends an 
-    updated HID report to connected devices.
+    Queues a snapshot of a connection's key state on its TX queue. A
+    snapshot that presses any key may not take the last slot. A release
+    snapshot may, and on a full queue it is merged into the tail when the
+    tail itself only releases keys, which loses no edge. Caller must hold
+    hid_state_mutex and the connection context.
 
 Parameter : 
-    keys : Pointer to an array of key codes
-    cnt  : Number of key codes in the array
+    hc : HID context of the connection
 
 Return : 
-    int : 0 on success, negative error code on failure
+    int : 0 on success, -ENOBUFS if the snapshot could not be queued
 
 Example Call : 
-    uint8_t keys[] = {0x04, 0x05};
-    hid_buttons_press(keys, 2);
+    err = hid_tx_enqueue(hc);
 */
-int hid_buttons_press(const uint8_t *keys, size_t cnt)
+static int hid_tx_enqueue(struct hid_conn *hc)
+{
+	struct hid_tx_queue *q = &hc->tx;
+	bool release = hid_tx_is_release(&q->last_queued, &hc->state);
+	uint8_t limit = release ? HID_TX_QUEUE_DEPTH : HID_TX_QUEUE_DEPTH - 1;
+	struct hid_tx_slot *tail;
+
+	if (q->count < limit)
+	{
+		tail = &q->slot[(q->head + q->count) % HID_TX_QUEUE_DEPTH];
+		tail->state = hc->state;
+		tail->release = release;
+		q->count++;
+	}
+	else
+	{
+		tail = &q->slot[(q->head + q->count - 1) % HID_TX_QUEUE_DEPTH];
+		if (!release || (q->count == 0) || !tail->release)
+		{
+			return -ENOBUFS;
+		}
+		tail->state = hc->state;
+		tx_stats.merged++;
+	}
+
+	q->last_queued = hc->state;
+	return 0;
+}
+
+/*
+Function : hid_tx_drain_conn
+
+Description : 
+    Hands queued snapshots of one connection to the stack while fewer than
+    HID_TX_INFLIGHT_MAX notifications are outstanding. When the stack is
+    out of buffers the head stays queued and is retried on the next sent
+    callback, or after HID_TX_RETRY_MS if nothing is in flight. Any other
+    error drops the snapshot. Caller must hold hid_state_mutex and the
+    connection context.
+
+Parameter : 
+    hc : HID context of the connection
+
+Return : 
+    void
+
+Example Call : 
+    hid_tx_drain_conn(hc);
+*/
+static void hid_tx_drain_conn(struct hid_conn *hc)
 {
-	while (cnt--)
+	struct hid_tx_queue *q = &hc->tx;
+
+	while (q->count && (q->in_flight < HID_TX_INFLIGHT_MAX))
 	{
 		int err;
 
-		err = hid_kbd_state_key_set(*keys++);
+		err = key_report_con_send(&q->slot[q->head].state,
+								  hc->in_boot_mode,
+								  hc->conn);
+		if ((err == -ENOMEM) || (err == -ENOBUFS) || (err == -EAGAIN))
+		{
+			if ((q->in_flight == 0) && (hid_tx_retry_at == 0))
+			{
+				hid_tx_retry_at = k_uptime_ticks() + k_ms_to_ticks_ceil64(HID_TX_RETRY_MS);
+			}
+			break;
+		}
+
+		q->head = (q->head + 1) % HID_TX_QUEUE_DEPTH;
+		q->count--;
 		if (err)
 		{
-			LOG_INF("Cannot set selected key.\n");
-			return err;
+			LOG_DBG("Key report send error: %d", err);
+			latency_trace_abort();
+			tx_stats.dropped++;
+			continue;
 		}
+		q->in_flight++;
+		tx_stats.sent++;
 	}
+}
+
+/*
+Function : hid_tx_press_slot_free
+
+Description : 
+    Checks whether every connected client has room in its TX queue for a
+    snapshot that presses a key. Caller must hold hid_state_mutex.
+
+Parameter : 
+    None
+
+Return : 
+    bool : true if a press can be queued on every connection
+
+Example Call : 
+    while (!hid_tx_press_slot_free()) { ... }
+*/
+static bool hid_tx_press_slot_free(void)
+{
+	bool free = true;
+
+	for (uint8_t id = 0; (id < CONFIG_BT_MAX_CONN) && free; id++)
+	{
+		const struct bt_conn_ctx *ctx = bt_conn_ctx_get_by_id(&hid_conns, id);
 
-	return key_report_send();
+		if (ctx)
+		{
+			free = ((struct hid_conn *)ctx->data)->tx.count < HID_TX_QUEUE_DEPTH - 1;
+			bt_conn_ctx_release(&hid_conns, ctx->data);
+		}
+	}
+	return free;
 }
 
 /*
-Function : hid_buttons_release
+Function : key_report_send_now
 
 Description : 
-    Marks one or more keys as released in the keyboard state and sends an 
-    updated HID report to connected devices.
+    Queues the key state of every connected client as an HID report,
+    starts draining the queues and opens a new coalescing window of one
+    connection interval. A snapshot that cannot be queued is counted as
+    dropped and the remaining clients are still served. Caller must hold
+    hid_state_mutex.
 
 Parameter : 
-    keys : Pointer to an array of key codes
-    cnt  : Number of key codes in the array
+    now : Current uptime in ticks
+
+Return : 
+    int : 0 on success, -ENOBUFS if a client queue was full
+
+Example Call : 
+    key_report_send_now(k_uptime_ticks());
+*/
+static int key_report_send_now(int64_t now)
+{
+	uint32_t interval_us = 0;
+	int ret = 0;
+
+	report_pending = false;
+	for (uint8_t id = 0; id < CONFIG_BT_MAX_CONN; id++)
+	{
+		const struct bt_conn_ctx *ctx = bt_conn_ctx_get_by_id(&hid_conns, id);
+		struct bt_conn_info info;
+		struct hid_conn *hc;
+
+		if (!ctx)
+		{
+			continue;
+		}
+		hc = ctx->data;
+
+		if (hid_tx_enqueue(hc))
+		{
+			LOG_DBG("Key report queue full");
+			latency_trace_abort();
+			tx_stats.dropped++;
+			ret = -ENOBUFS;
+		}
+		else
+		{
+			hid_tx_drain_conn(hc);
+		}
+		hc->last_sent = hc->state;
+
+		if (bt_conn_get_info(hc->conn, &info) == 0)
+		{
+			interval_us = MAX(interval_us, BT_CONN_INTERVAL_TO_US(info.le.interval));
+		}
+		bt_conn_ctx_release(&hid_conns, ctx->data);
+	}
+
+	coalesce_window_end = now + k_us_to_ticks_ceil64(interval_us);
+	return ret;
+}
+
+/*
+Function : key_report_order_guard
+
+Description : 
+    Keeps press/release ordering intact while a report is pending. If a
+    change about to be applied would return a key to the state a host
+    last saw (e.g. a release of a press not yet sent), the pending report
+    is flushed first so the keystroke is not merged away. Caller must hold
+    hid_state_mutex.
+
+Parameter : 
+    keys    : HID key codes about to change
+    cnt     : Number of key codes
+    pressed : New state of the keys
+
+Return : 
+    void
+
+Example Call : 
+    key_report_order_guard(keys, 1, true);
+*/
+static void key_report_order_guard(const uint8_t *keys, size_t cnt, bool pressed)
+{
+	bool flush = false;
+
+	if (!report_pending)
+	{
+		return;
+	}
+
+	for (uint8_t id = 0; (id < CONFIG_BT_MAX_CONN) && !flush; id++)
+	{
+		const struct bt_conn_ctx *ctx = bt_conn_ctx_get_by_id(&hid_conns, id);
+		const struct hid_conn *hc;
+
+		if (!ctx)
+		{
+			continue;
+		}
+		hc = ctx->data;
+		for (size_t k = 0; (k < cnt) && !flush; k++)
+		{
+			uint8_t key = keys[k];
+			uint8_t mask = BIT(key % 8);
+			bool sent, cur;
+
+			if (key > KEY_CTRL_CODE_MAX)
+			{
+				continue;
+			}
+			sent = hc->last_sent.keys_bitmap[key / 8] & mask;
+			cur = hc->state.keys_bitmap[key / 8] & mask;
+			flush = (cur != pressed) && (sent == pressed);
+		}
+		bt_conn_ctx_release(&hid_conns, ctx->data);
+	}
+
+	if (flush)
+	{
+		tx_stats.flushed++;
+		(void)key_report_send_now(k_uptime_ticks());
+	}
+}
+
+/*
+Function : key_report_send
+
+Description : 
+    Reports the current keyboard state. Outside a coalescing window the
+    report goes out immediately; inside one it is deferred to the end of
+    the window, when the HID TX thread wakes up to send it, and further
+    changes are merged into it. Caller must hold hid_state_mutex.
+
+Parameter : 
+    None
 
 Return : 
     int : 0 on success, negative error code on failure
 
 Example Call : 
-    uint8_t keys[] = {0x04, 0x05};
-    hid_buttons_release(keys, 2);
+    key_report_send();
 */
-int hid_buttons_release(const uint8_t *keys, size_t cnt)
+static int key_report_send(void)
 {
-	while (cnt--)
+	int64_t now = k_uptime_ticks();
+
+	if (!IS_ENABLED(CONFIG_APP_HID_COALESCE) || now >= coalesce_window_end)
 	{
-		int err;
+		return key_report_send_now(now);
+	}
 
-		err = hid_kbd_state_key_clear(*keys++);
-		if (err)
+	if (report_pending)
+	{
+		tx_stats.merged++;
+		return 0;
+	}
+
+	report_pending = true;
+	return 0;
+}
+
+/*
+Function : hid_keys_apply
+
+Description : 
+    Applies a key event taken from the event ring to the key state of
+    every connected host and reports the result to them. Runs in the HID
+    TX thread, the only writer of the key state. A press is not applied
+    while a TX queue has no room for it; the thread retries it as
+    notifications complete.
+
+Parameter : 
+    ev : Key event (HID_EVENT_KEYS)
+
+Return : 
+    int : 0 on success, -EAGAIN if a press found a TX queue full,
+          other negative error code on failure
+
+Example Call : 
+    err = hid_keys_apply(&ev);
+*/
+static int hid_keys_apply(const struct hid_event *ev)
+{
+	int err = 0;
+
+	k_mutex_lock(&hid_state_mutex, K_FOREVER);
+	if (ev->pressed && !hid_tx_press_slot_free())
+	{
+		k_mutex_unlock(&hid_state_mutex);
+		return -EAGAIN;
+	}
+
+	key_report_order_guard(ev->keys, ev->cnt, ev->pressed);
+	for (uint8_t id = 0; id < CONFIG_BT_MAX_CONN; id++)
+	{
+		const struct bt_conn_ctx *ctx = bt_conn_ctx_get_by_id(&hid_conns, id);
+		struct hid_conn *hc;
+
+		if (!ctx)
+		{
+			continue;
+		}
+		hc = ctx->data;
+		for (size_t k = 0; k < ev->cnt; k++)
+		{
+			int key_err = ev->pressed ? hid_kbd_state_key_set(&hc->state, ev->keys[k])
+									  : hid_kbd_state_key_clear(&hc->state, ev->keys[k]);
+
+			if (key_err)
+			{
+				err = key_err;
+				break;
+			}
+		}
+		bt_conn_ctx_release(&hid_conns, ctx->data);
+	}
+
+	if (err)
+	{
+		if (ev->pressed)
+		{
+			LOG_INF("Cannot set selected key.\n");
+		}
+		else
 		{
 			LOG_DBG("Cannot clear selected key. %d\n", err);
-			return err;
+		}
+		latency_trace_abort();
+	}
+	else
+	{
+		latency_trace_stamp(LATENCY_STAGE_REPORT);
+		err = key_report_send();
+	}
+	k_mutex_unlock(&hid_state_mutex);
+	return err;
+}
+
+/*
+Function : hid_event_put
+
+Description : 
+    Claims a position in the event ring and publishes an event there.
+    Lock-free and safe from any thread or interrupt; never blocks. A
+    press is refused while a release is parked or when the ring is down
+    to its release reserve.
+
+Parameter : 
+    ev : Event to post
+
+Return : 
+    int : 0 on success, -ENOBUFS if the event did not fit
+
+Example Call : 
+    err = hid_event_put(&ev);
+*/
+static int hid_event_put(const struct hid_event *ev)
+{
+	struct hid_event_slot *slot;
+	uint32_t pos;
+
+	if (ev->pressed &&
+		(atomic_get(&release_parked) ||
+		 ((uint32_t)atomic_get(&hid_event_tail) - (uint32_t)atomic_get(&hid_event_head) >=
+		  HID_EVENT_QUEUE_DEPTH - HID_EVENT_RELEASE_RESERVE)))
+	{
+		return -ENOBUFS;
+	}
+
+	pos = (uint32_t)atomic_get(&hid_event_tail);
+	for (;;)
+	{
+		int32_t diff;
+
+		slot = &hid_events[pos % HID_EVENT_QUEUE_DEPTH];
+		diff = (int32_t)((uint32_t)atomic_get(&slot->seq) - pos);
+		if ((diff == 0) && atomic_cas(&hid_event_tail, pos, pos + 1))
+		{
+			break;
+		}
+		if (diff < 0)
+		{
+			return -ENOBUFS; /* consumer a full lap behind */
+		}
+		pos = (uint32_t)atomic_get(&hid_event_tail);
+	}
+
+	slot->ev = *ev;
+	atomic_set(&slot->seq, pos + 1);
+	return 0;
+}
+
+/*
+Function : hid_event_get
+
+Description : 
+    Takes the oldest published event from the ring. HID TX thread only.
+
+Parameter : 
+    ev : Output event
+
+Return : 
+    bool : true if an event was taken, false if the ring is empty
+
+Example Call : 
+    while (hid_event_get(&ev)) { ... }
+*/
+static bool hid_event_get(struct hid_event *ev)
+{
+	uint32_t pos = (uint32_t)atomic_get(&hid_event_head);
+	struct hid_event_slot *slot = &hid_events[pos % HID_EVENT_QUEUE_DEPTH];
+
+	if ((int32_t)((uint32_t)atomic_get(&slot->seq) - (pos + 1)) < 0)
+	{
+		return false;
+	}
+
+	*ev = slot->ev;
+	atomic_set(&slot->seq, pos + HID_EVENT_QUEUE_DEPTH);
+	atomic_set(&hid_event_head, pos + 1);
+	return true;
+}
+
+/*
+Function : hid_event_post
+
+Description : 
+    Posts an event for the HID TX thread and wakes it. A release that
+    does not fit in the ring is parked instead, so it is never lost.
+
+Parameter : 
+    ev : Event to post
+
+Return : 
+    int : 0 on success, -ENOBUFS if a press did not fit
+
+Example Call : 
+    err = hid_event_post(&ev);
+*/
+static int hid_event_post(const struct hid_event *ev)
+{
+	if (hid_event_put(ev))
+	{
+		if (ev->pressed)
+		{
+			atomic_inc(&events_rejected);
+			latency_trace_abort();
+			return -ENOBUFS;
+		}
+
+		switch (ev->type)
+		{
+		case HID_EVENT_KEYS:
+			for (size_t k = 0; k < ev->cnt; k++)
+			{
+				atomic_set_bit(keys_release_parked, ev->keys[k]);
+			}
+			break;
+		case HID_EVENT_CONSUMER:
+			atomic_or(&ctrl_release_parked, BIT(0));
+			break;
+		default:
+			atomic_or(&ctrl_release_parked, BIT(1 + ev->usage - SYSTEM_USAGE_MIN));
+			break;
+		}
+		atomic_set(&release_parked, 1);
+	}
+
+	k_sem_give(&hid_tx_sem);
+	return 0;
+}
+
+/*
+Function : hid_key_event_post
+
+Description : 
+    Posts a press or release of one or more keys, split into events of
+    at most HID_EVENT_KEYS_MAX keys.
+
+Parameter : 
+    keys    : Pointer to an array of key codes
+    cnt     : Number of key codes in the array
+    pressed : true to press the keys, false to release them
+
+Return : 
+    int : 0 on success, -EINVAL for a code above 0xE7,
+          -ENOBUFS if a press did not fit in the event ring
+
+Example Call : 
+    hid_key_event_post(keys, 2, true);
+*/
+static int hid_key_event_post(const uint8_t *keys, size_t cnt, bool pressed)
+{
+	struct hid_event ev = {
+		.type = HID_EVENT_KEYS,
+		.pressed = pressed,
+	};
+
+	for (size_t k = 0; k < cnt; k++)
+	{
+		if (keys[k] > KEY_CTRL_CODE_MAX)
+		{
+			return -EINVAL;
 		}
 	}
 
-	return key_report_send();
-}
\ No newline at end of file
+	while (cnt)
+	{
+		int err;
+
+		ev.cnt = MIN(cnt, HID_EVENT_KEYS_MAX);
+		memcpy(ev.keys, keys, ev.cnt);
+		err = hid_event_post(&ev);
+		if (err)
+		{
+			return err;
+		}
+		keys += ev.cnt;
+		cnt -= ev.cnt;
+	}
+	return 0;
+}
+
+/*
+Function : hid_buttons_press
+
+Description : 
+    Marks one or more keys as pressed in the keyboard state and sends an
+    updated HID report to connected devices. The press is posted to the
+    HID TX thread; the caller never blocks.
+
+Parameter : 
+    keys : Pointer to an array of key codes
+    cnt  : Number of key codes in the array
+
+Return : 
+    int : 0 on success, negative error code on failure
+
+Example Call : 
+    uint8_t keys[] = {0x04, 0x05};
+    hid_buttons_press(keys, 2);
+*/
+int hid_buttons_press(const uint8_t *keys, size_t cnt)
+{
+	return hid_key_event_post(keys, cnt, true);
+}
+
+/*
+Function : hid_buttons_release
+
+Description : 
+    Marks one or more keys as released in the keyboard state and sends an
+    updated HID report to connected devices. The release is posted to the
+    HID TX thread; the caller never blocks.
+
+Parameter : 
+    keys : Pointer to an array of key codes
+    cnt  : Number of key codes in the array
+
+Return : 
+    int : 0 on success, negative error code on failure
+
+Example Call : 
+    uint8_t keys[] = {0x04, 0x05};
+    hid_buttons_release(keys, 2);
+*/
+int hid_buttons_release(const uint8_t *keys, size_t cnt)
+{
+	return hid_key_event_post(keys, cnt, false);
+}
+
+#if CONFIG_APP_HID_CONSUMER || CONFIG_APP_AIR_MOUSE
+/*
+Function : hid_report_conns_get
+
+Description : 
+    Collects the connected clients in report mode, each with a reference
+    taken, so reports that only exist in report mode can be sent without
+    holding a connection context. The caller unrefs every entry.
+
+Parameter : 
+    conns : Output array of CONFIG_BT_MAX_CONN entries
+
+Return : 
+    size_t : Number of connections returned
+
+Example Call : 
+    size_t n = hid_report_conns_get(conns);
+*/
+static size_t hid_report_conns_get(struct bt_conn *conns[CONFIG_BT_MAX_CONN])
+{
+	size_t n = 0;
+
+	for (uint8_t id = 0; id < CONFIG_BT_MAX_CONN; id++)
+	{
+		const struct bt_conn_ctx *ctx = bt_conn_ctx_get_by_id(&hid_conns, id);
+		const struct hid_conn *hc;
+
+		if (!ctx)
+		{
+			continue;
+		}
+		hc = ctx->data;
+		if (!hc->in_boot_mode)
+		{
+			conns[n++] = bt_conn_ref(hc->conn);
+		}
+		bt_conn_ctx_release(&hid_conns, ctx->data);
+	}
+	return n;
+}
+#endif
+
+#if CONFIG_APP_HID_CONSUMER
+/*
+Function : ctrl_report_sent
+
+Description : 
+    Notification completion callback for consumer and system control
+    reports. Marks the end of the key event trace.
+
+Parameter : 
+    conn      : Pointer to the Bluetooth connection the report was sent on
+    user_data : Unused
+
+Return : 
+    void
+
+Example Call : 
+    passed to bt_hids_inp_rep_send(..., ctrl_report_sent);
+*/
+static void ctrl_report_sent(struct bt_conn *conn, void *user_data)
+{
+	ARG_UNUSED(conn);
+	ARG_UNUSED(user_data);
+
+	latency_trace_stamp(LATENCY_STAGE_SENT);
+	energy_notify_sent();
+}
+
+/*
+Function : ctrl_report_send
+
+Description : 
+    Sends the current consumer or system control report to every report
+    mode client; boot mode hosts have no such report. If the stack is out
+    of buffers for any of them the report is left pending and sent again
+    by ctrl_report_retry(); it is never waited for. HID TX thread only.
+
+Parameter : 
+    rep : CTRL_REP_CONSUMER or CTRL_REP_SYSTEM
+
+Return : 
+    int : 0 if sent or pending, negative error code of the last failed send
+
+Example Call : 
+    err = ctrl_report_send(CTRL_REP_SYSTEM);
+*/
+static int ctrl_report_send(uint8_t rep)
+{
+	uint8_t data[INPUT_REPORT_CONSUMER_LEN];
+	struct bt_conn *conns[CONFIG_BT_MAX_CONN];
+	uint8_t rep_idx = INPUT_REP_SYSTEM_IDX;
+	uint8_t len = INPUT_REPORT_SYSTEM_LEN;
+	bool busy = false;
+	size_t n;
+	int ret = 0;
+
+	if (rep == CTRL_REP_CONSUMER)
+	{
+		rep_idx = INPUT_REP_CONSUMER_IDX;
+		len = INPUT_REPORT_CONSUMER_LEN;
+		sys_put_le16(consumer_usage, data);
+	}
+	else
+	{
+		data[0] = system_bits;
+	}
+
+	n = hid_report_conns_get(conns);
+	latency_trace_stamp(LATENCY_STAGE_REPORT);
+	for (size_t i = 0; i < n; i++)
+	{
+		int err = bt_hids_inp_rep_send(&hids_obj, conns[i], rep_idx,
+									   data, len, ctrl_report_sent);
+
+		if ((err == -ENOMEM) || (err == -ENOBUFS) || (err == -EAGAIN))
+		{
+			busy = true; /* hosts that took it get the same state again */
+		}
+		else if (err)
+		{
+			LOG_DBG("Control report %u send error: %d", rep_idx, err);
+			latency_trace_abort();
+			ret = err;
+		}
+		bt_conn_unref(conns[i]);
+	}
+
+	if (busy)
+	{
+		int64_t now = k_uptime_ticks();
+
+		if (!ctrl_pending)
+		{
+			ctrl_give_up = now + k_ms_to_ticks_ceil64(CONFIG_APP_HID_TX_BACKPRESSURE_MS);
+		}
+		ctrl_pending |= rep;
+		ctrl_retry_at = now + k_ms_to_ticks_ceil64(HID_TX_RETRY_MS);
+	}
+	else
+	{
+		ctrl_pending &= ~rep;
+		if (!ctrl_pending)
+		{
+			ctrl_retry_at = 0;
+		}
+	}
+	return ret;
+}
+
+/*
+Function : ctrl_report_retry
+
+Description : 
+    Run by the HID TX thread on every wakeup. Sends the pending control
+    reports again once their retry time has come, or drops them when
+    CONFIG_APP_HID_TX_BACKPRESSURE_MS has passed since the stack first
+    ran out of buffers for them.
+
+Parameter : 
+    now : Current uptime in ticks
+
+Return : 
+    void
+
+Example Call : 
+    ctrl_report_retry(k_uptime_ticks());
+*/
+static void ctrl_report_retry(int64_t now)
+{
+	uint8_t pending = ctrl_pending;
+
+	if (!pending || (now < ctrl_retry_at))
+	{
+		return;
+	}
+	if (now >= ctrl_give_up)
+	{
+		LOG_DBG("Control report dropped, no buffers");
+		latency_trace_abort();
+		ctrl_pending = 0;
+		ctrl_retry_at = 0;
+		return;
+	}
+
+	if (pending & CTRL_REP_CONSUMER)
+	{
+		(void)ctrl_report_send(CTRL_REP_CONSUMER);
+	}
+	if (pending & CTRL_REP_SYSTEM)
+	{
+		(void)ctrl_report_send(CTRL_REP_SYSTEM);
+	}
+}
+
+/*
+Function : hid_consumer_apply
+
+Description : 
+    Applies a consumer event taken from the event ring and sends the
+    consumer report if that changed its state. The report holds one
+    usage: a press replaces the usage held before, and a release of a
+    usage that is not held does nothing. HID TX thread only.
+
+Parameter : 
+    usage   : Consumer usage (HID_CONSUMER_*), 1..CONSUMER_USAGE_MAX
+    pressed : true to press, false to release
+
+Return : 
+    int : 0 on success, negative error code if the report could not be sent
+
+Example Call : 
+    hid_consumer_apply(HID_CONSUMER_VOLUME_UP, true);
+*/
+static int hid_consumer_apply(uint16_t usage, bool pressed)
+{
+	if (pressed ? (consumer_usage == usage) : (consumer_usage != usage))
+	{
+		return 0;
+	}
+	consumer_usage = pressed ? usage : 0;
+	return ctrl_report_send(CTRL_REP_CONSUMER);
+}
+
+/*
+Function : hid_consumer_post
+
+Description : 
+    Posts a consumer press or release to the HID TX thread.
+
+Parameter : 
+    usage   : Consumer usage (HID_CONSUMER_*), 1..CONSUMER_USAGE_MAX
+    pressed : true to press, false to release
+
+Return : 
+    int : 0 on success, -EINVAL for an out of range usage,
+          -ENOBUFS if a press did not fit in the event ring
+
+Example Call : 
+    hid_consumer_post(HID_CONSUMER_VOLUME_UP, true);
+*/
+static int hid_consumer_post(uint16_t usage, bool pressed)
+{
+	struct hid_event ev = {
+		.type = HID_EVENT_CONSUMER,
+		.pressed = pressed,
+		.usage = usage,
+	};
+
+	if ((usage == 0) || (usage > CONSUMER_USAGE_MAX))
+	{
+		return -EINVAL;
+	}
+	return hid_event_post(&ev);
+}
+
+/*
+Function : hid_consumer_press
+
+Description : 
+    Presses a consumer (media) usage. Only the consumer report is sent.
+
+Parameter : 
+    usage : Consumer usage (HID_CONSUMER_*)
+
+Return : 
+    int : 0 on success, negative error code on failure
+
+Example Call : 
+    hid_consumer_press(HID_CONSUMER_MUTE);
+*/
+int hid_consumer_press(uint16_t usage)
+{
+	return hid_consumer_post(usage, true);
+}
+
+/*
+Function : hid_consumer_release
+
+Description : 
+    Releases a consumer (media) usage. Only the consumer report is sent.
+
+Parameter : 
+    usage : Consumer usage (HID_CONSUMER_*)
+
+Return : 
+    int : 0 on success, negative error code on failure
+
+Example Call : 
+    hid_consumer_release(HID_CONSUMER_MUTE);
+*/
+int hid_consumer_release(uint16_t usage)
+{
+	return hid_consumer_post(usage, false);
+}
+
+/*
+Function : hid_system_apply
+
+Description : 
+    Applies a system control event taken from the event ring and sends
+    the system report if that changed its state. HID TX thread only.
+
+Parameter : 
+    usage   : System usage (HID_SYSTEM_*), SYSTEM_USAGE_MIN..SYSTEM_USAGE_MAX
+    pressed : true to press, false to release
+
+Return : 
+    int : 0 on success, negative error code if the report could not be sent
+
+Example Call : 
+    hid_system_apply(HID_SYSTEM_SLEEP, true);
+*/
+static int hid_system_apply(uint8_t usage, bool pressed)
+{
+	uint8_t bits = pressed ? (system_bits | BIT(usage - SYSTEM_USAGE_MIN))
+						   : (system_bits & ~BIT(usage - SYSTEM_USAGE_MIN));
+
+	if (bits == system_bits)
+	{
+		return 0;
+	}
+	system_bits = bits;
+	return ctrl_report_send(CTRL_REP_SYSTEM);
+}
+
+/*
+Function : hid_system_post
+
+Description : 
+    Posts a system control press or release to the HID TX thread.
+
+Parameter : 
+    usage   : System usage (HID_SYSTEM_*), SYSTEM_USAGE_MIN..SYSTEM_USAGE_MAX
+    pressed : true to press, false to release
+
+Return : 
+    int : 0 on success, -EINVAL for an out of range usage,
+          -ENOBUFS if a press did not fit in the event ring
+
+Example Call : 
+    hid_system_post(HID_SYSTEM_SLEEP, true);
+*/
+static int hid_system_post(uint8_t usage, bool pressed)
+{
+	struct hid_event ev = {
+		.type = HID_EVENT_SYSTEM,
+		.pressed = pressed,
+		.usage = usage,
+	};
+
+	if ((usage < SYSTEM_USAGE_MIN) || (usage > SYSTEM_USAGE_MAX))
+	{
+		return -EINVAL;
+	}
+	return hid_event_post(&ev);
+}
+
+/*
+Function : hid_system_press
+
+Description : 
+    Presses a system control usage. Only the system report is sent.
+
+Parameter : 
+    usage : System usage (HID_SYSTEM_*)
+
+Return : 
+    int : 0 on success, negative error code on failure
+
+Example Call : 
+    hid_system_press(HID_SYSTEM_SLEEP);
+*/
+int hid_system_press(uint8_t usage)
+{
+	return hid_system_post(usage, true);
+}
+
+/*
+Function : hid_system_release
+
+Description : 
+    Releases a system control usage. Only the system report is sent.
+
+Parameter : 
+    usage : System usage (HID_SYSTEM_*)
+
+Return : 
+    int : 0 on success, negative error code on failure
+
+Example Call : 
+    hid_system_release(HID_SYSTEM_SLEEP);
+*/
+int hid_system_release(uint8_t usage)
+{
+	return hid_system_post(usage, false);
+}
+#endif
+
+/*
+Function : hid_release_parked_apply
+
+Description : 
+    Applies the releases that were parked because the event ring was full.
+    Called by the HID TX thread once the ring is drained, after every
+    event posted before them; presses are refused until then.
+
+Parameter : 
+    None
+
+Return : 
+    void
+
+Example Call : 
+    hid_release_parked_apply();
+*/
+static void hid_release_parked_apply(void)
+{
+	struct hid_event ev = {
+		.type = HID_EVENT_KEYS,
+		.pressed = false,
+	};
+	atomic_val_t ctrl;
+
+	if (!atomic_clear(&release_parked))
+	{
+		return;
+	}
+
+	for (int key = 0; key <= KEY_CTRL_CODE_MAX; key++)
+	{
+		if (atomic_test_and_clear_bit(keys_release_parked, key))
+		{
+			ev.keys[ev.cnt++] = (uint8_t)key;
+		}
+		if ((ev.cnt == HID_EVENT_KEYS_MAX) || ((key == KEY_CTRL_CODE_MAX) && ev.cnt))
+		{
+			(void)hid_keys_apply(&ev);
+			ev.cnt = 0;
+		}
+	}
+
+	ctrl = atomic_clear(&ctrl_release_parked);
+#if CONFIG_APP_HID_CONSUMER
+	if ((ctrl & BIT(0)) && consumer_usage)
+	{
+		(void)hid_consumer_apply(consumer_usage, false);
+	}
+	for (uint8_t usage = SYSTEM_USAGE_MIN; usage <= SYSTEM_USAGE_MAX; usage++)
+	{
+		if (ctrl & BIT(1 + usage - SYSTEM_USAGE_MIN))
+		{
+			(void)hid_system_apply(usage, false);
+		}
+	}
+#else
+	ARG_UNUSED(ctrl);
+#endif
+}
+
+/*
+Function : hid_event_apply
+
+Description : 
+    Applies one event taken from the event ring. HID TX thread only.
+
+Parameter : 
+    ev : Event to apply
+
+Return : 
+    int : 0 on success, -EAGAIN if a key press found a TX queue full,
+          other negative error code on failure
+
+Example Call : 
+    err = hid_event_apply(&ev);
+*/
+static int hid_event_apply(const struct hid_event *ev)
+{
+	switch (ev->type)
+	{
+	case HID_EVENT_KEYS:
+		return hid_keys_apply(ev);
+#if CONFIG_APP_HID_CONSUMER
+	case HID_EVENT_CONSUMER:
+		return hid_consumer_apply(ev->usage, ev->pressed);
+	case HID_EVENT_SYSTEM:
+		return hid_system_apply((uint8_t)ev->usage, ev->pressed);
+#endif
+	default:
+		return -EINVAL;
+	}
+}
+
+/*
+Function : hid_tx_service
+
+Description : 
+    Run by the HID TX thread on every wakeup. Accounts the completed
+    notifications of every connection, drains their queues and sends the
+    coalesced report once its window has ended.
+
+Parameter : 
+    now : Current uptime in ticks
+
+Return : 
+    void
+
+Example Call : 
+    hid_tx_service(k_uptime_ticks());
+*/
+static void hid_tx_service(int64_t now)
+{
+	k_mutex_lock(&hid_state_mutex, K_FOREVER);
+	hid_tx_retry_at = 0;
+	for (uint8_t id = 0; id < CONFIG_BT_MAX_CONN; id++)
+	{
+		const struct bt_conn_ctx *ctx = bt_conn_ctx_get_by_id(&hid_conns, id);
+		struct hid_conn *hc;
+		atomic_val_t done;
+
+		if (!ctx)
+		{
+			continue;
+		}
+		hc = ctx->data;
+		done = atomic_clear(&hid_tx_completed[id]);
+		hc->tx.in_flight = (done >= hc->tx.in_flight) ? 0 : (hc->tx.in_flight - done);
+		hid_tx_drain_conn(hc);
+		bt_conn_ctx_release(&hid_conns, ctx->data);
+	}
+	if (report_pending && (now >= coalesce_window_end))
+	{
+		(void)key_report_send_now(now);
+	}
+	k_mutex_unlock(&hid_state_mutex);
+}
+
+/*
+Function : hid_tx_timeout
+
+Description : 
+    Time the HID TX thread may sleep when nothing wakes it: until the
+    coalescing window ends, the next drain or control report retry, or a
+    held press is given up. The deadlines are HID TX thread state.
+
+Parameter : 
+    stall_end : Uptime ticks at which the held press is dropped, 0 if none
+
+Return : 
+    k_timeout_t : Absolute timeout, K_FOREVER if nothing is due
+
+Example Call : 
+    k_sem_take(&hid_tx_sem, hid_tx_timeout(0));
+*/
+static k_timeout_t hid_tx_timeout(int64_t stall_end)
+{
+	int64_t deadline = stall_end ? stall_end : INT64_MAX;
+
+	if (report_pending)
+	{
+		deadline = MIN(deadline, coalesce_window_end);
+	}
+	if (hid_tx_retry_at)
+	{
+		deadline = MIN(deadline, hid_tx_retry_at);
+	}
+#if CONFIG_APP_HID_CONSUMER
+	if (ctrl_retry_at)
+	{
+		deadline = MIN(deadline, ctrl_retry_at);
+	}
+#endif
+	return (deadline == INT64_MAX) ? K_FOREVER : K_TIMEOUT_ABS_TICKS(deadline);
+}
+
+/*
+Function : hid_tx_thread_fn
+
+Description : 
+    HID TX thread: the single writer of the keyboard and control report
+    state. Woken by posted events, sent notifications and disconnects, it
+    services the TX queues and applies the posted events in order. A
+    press that finds a TX queue full is held, with the events behind it,
+    for up to CONFIG_APP_HID_TX_BACKPRESSURE_MS and then dropped; the
+    producers keep posting meanwhile.
+
+Parameter : 
+    p1, p2, p3 : Unused
+
+Return : 
+    void (never returns)
+
+Example Call : 
+    started by hid_init()
+*/
+static void hid_tx_thread_fn(void *p1, void *p2, void *p3)
+{
+	struct hid_event ev;
+	bool held = false;     /* ev is a press waiting for TX queue space */
+	int64_t stall_end = 0; /* Uptime ticks at which the held press is dropped */
+
+	ARG_UNUSED(p1);
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+
+	for (;;)
+	{
+		(void)k_sem_take(&hid_tx_sem, hid_tx_timeout(held ? stall_end : 0));
+		hid_tx_service(k_uptime_ticks());
+#if CONFIG_APP_HID_CONSUMER
+		ctrl_report_retry(k_uptime_ticks());
+#endif
+
+		for (;;)
+		{
+			int64_t now;
+
+			if (!held)
+			{
+				if (!hid_event_get(&ev))
+				{
+					hid_release_parked_apply();
+					break;
+				}
+				stall_end = 0;
+			}
+
+			held = false;
+			if (hid_event_apply(&ev) != -EAGAIN)
+			{
+				continue;
+			}
+
+			now = k_uptime_ticks();
+			k_mutex_lock(&hid_state_mutex, K_FOREVER);
+			if (stall_end == 0)
+			{
+				stall_end = now + k_ms_to_ticks_ceil64(CONFIG_APP_HID_TX_BACKPRESSURE_MS);
+				tx_stats.waits++;
+			}
+			if (now < stall_end)
+			{
+				held = true;
+			}
+			else
+			{
+				LOG_DBG("Key report queue stalled");
+				latency_trace_abort();
+				tx_stats.dropped++;
+			}
+			k_mutex_unlock(&hid_state_mutex);
+
+			if (held)
+			{
+				break;
+			}
+		}
+	}
+}
+
+#if CONFIG_APP_AIR_MOUSE
+/*
+Function : mouse_report_kick
+
+Description : 
+    Schedules the mouse report work for the earliest time the next report
+    may go out. Does nothing if it is already scheduled.
+
+Parameter : 
+    None
+
+Return : 
+    void
+
+Example Call : 
+    mouse_report_kick();
+*/
+static void mouse_report_kick(void)
+{
+	int64_t now = k_uptime_ticks();
+	k_spinlock_key_t key;
+	int64_t next;
+
+	key = k_spin_lock(&mouse_lock);
+	next = mouse_next_send;
+	k_spin_unlock(&mouse_lock, key);
+
+	k_work_schedule(&mouse_report_work, (next > now) ? K_TICKS(next - now) : K_NO_WAIT);
+}
+
+/*
+Function : mouse_report_sent
+
+Description : 
+    Notification completion callback for mouse reports. Frees the
+    connection for the next report and sends what accumulated meanwhile.
+
+Parameter : 
+    conn      : Pointer to the Bluetooth connection the report was sent on
+    user_data : Unused
+
+Return : 
+    void
+
+Example Call : 
+    passed to bt_hids_inp_rep_send(..., mouse_report_sent);
+*/
+static void mouse_report_sent(struct bt_conn *conn, void *user_data)
+{
+	k_spinlock_key_t key;
+	bool pending;
+
+	ARG_UNUSED(user_data);
+
+	energy_notify_sent();
+	atomic_clear_bit(&mouse_in_flight, bt_conn_index(conn));
+	key = k_spin_lock(&mouse_lock);
+	pending = (mouse_dx || mouse_dy);
+	k_spin_unlock(&mouse_lock, key);
+	if (pending)
+	{
+		mouse_report_kick();
+	}
+}
+
+/*
+Function : mouse_report_fn
+
+Description : 
+    Sends the accumulated motion as one mouse report to every report mode
+    client, once none of them has a mouse report outstanding. The next
+    report is held back for the longer of the report period and the
+    connection interval. Deltas beyond the int16 range stay accumulated
+    for the following report.
+
+Parameter : 
+    work : Pointer to the work item (unused)
+
+Return : 
+    void
+
+Example Call : 
+    Called by the system workqueue
+*/
+static void mouse_report_fn(struct k_work *work)
+{
+	uint8_t data[INPUT_REPORT_MOUSE_LEN];
+	struct bt_conn *conns[CONFIG_BT_MAX_CONN];
+	uint32_t interval_us = MOUSE_REPORT_PERIOD_US;
+	bool eligible;
+	size_t n;
+	bool sent = false;
+	k_spinlock_key_t key;
+	int16_t dx;
+	int16_t dy;
+
+	ARG_UNUSED(work);
+
+	if (atomic_get(&mouse_in_flight))
+	{
+		return; /* mouse_report_sent() kicks again */
+	}
+
+	key = k_spin_lock(&mouse_lock);
+	dx = (int16_t)CLAMP(mouse_dx, -INT16_MAX, INT16_MAX);
+	dy = (int16_t)CLAMP(mouse_dy, -INT16_MAX, INT16_MAX);
+	k_spin_unlock(&mouse_lock, key);
+
+	if (!dx && !dy)
+	{
+		return;
+	}
+
+	data[0] = 0; /* no mouse buttons */
+	sys_put_le16(dx, &data[1]);
+	sys_put_le16(dy, &data[3]);
+
+	n = hid_report_conns_get(conns);
+	eligible = (n > 0);
+	for (size_t i = 0; i < n; i++)
+	{
+		uint8_t idx = bt_conn_index(conns[i]);
+		struct bt_conn_info info;
+
+		atomic_set_bit(&mouse_in_flight, idx);
+		if (bt_hids_inp_rep_send(&hids_obj, conns[i], INPUT_REP_MOUSE_IDX,
+								 data, sizeof(data), mouse_report_sent))
+		{
+			atomic_clear_bit(&mouse_in_flight, idx);
+		}
+		else
+		{
+			sent = true;
+			if (bt_conn_get_info(conns[i], &info) == 0)
+			{
+				interval_us = MAX(interval_us, BT_CONN_INTERVAL_TO_US(info.le.interval));
+			}
+		}
+		bt_conn_unref(conns[i]);
+	}
+
+	key = k_spin_lock(&mouse_lock);
+	if (sent || !eligible)
+	{
+		/* Reported, or only boot mode hosts that have no mouse report */
+		mouse_dx -= dx;
+		mouse_dy -= dy;
+	}
+	mouse_next_send = k_uptime_ticks() + k_us_to_ticks_ceil64(interval_us);
+	k_spin_unlock(&mouse_lock, key);
+
+	if (!sent && eligible)
+	{
+		mouse_report_kick(); /* out of buffers: retry next period */
+	}
+}
+
+/*
+Function : hid_mouse_move
+
+Description : 
+    Adds relative motion to the pending mouse report and schedules it.
+    Safe to call from any thread; motion while no host is connected is
+    discarded.
+
+Parameter : 
+    dx : Horizontal motion, mouse counts (positive = right)
+    dy : Vertical motion, mouse counts (positive = down)
+
+Return : 
+    int : 0 on success, -ENOTCONN if no host is connected
+
+Example Call : 
+    hid_mouse_move(12, -3);
+*/
+int hid_mouse_move(int16_t dx, int16_t dy)
+{
+	k_spinlock_key_t key;
+
+	if (!isBle_connected)
+	{
+		return -ENOTCONN;
+	}
+
+	key = k_spin_lock(&mouse_lock);
+	mouse_dx = CLAMP(mouse_dx + dx, -(INT16_MAX * 4), INT16_MAX * 4);
+	mouse_dy = CLAMP(mouse_dy + dy, -(INT16_MAX * 4), INT16_MAX * 4);
+	k_spin_unlock(&mouse_lock, key);
+
+	mouse_report_kick();
+	return 0;
+}
+#endif
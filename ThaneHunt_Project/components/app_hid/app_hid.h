@@ -17,15 +17,42 @@ Developer : Engineer Akbar Shah
 #ifndef APP_HID_H
 #define APP_HID_H
 
+#include <stdint.h>
+
 struct keyboard_state;
 
+/* Report coalescing and TX pipeline counters */
+struct hid_tx_stats
+{
+	uint32_t sent;     /* Reports handed to the stack */
+	uint32_t merged;   /* State changes merged into a pending report */
+	uint32_t flushed;  /* Pending reports sent early to keep ordering */
+	uint32_t dropped;  /* Reports lost to send errors or a stalled TX queue */
+	uint32_t waits;    /* Presses held back by a full TX queue */
+	uint32_t rejected; /* Presses refused by a full input event ring */
+};
+
 void hid_init(void);
 int connect_bt_hid(struct bt_conn *conn);
 int disconnect_bt_hid(struct bt_conn *conn);
+size_t hid_conn_count(void);
 int key_report_con_send(const struct keyboard_state *state,
 						bool boot_mode,
 						struct bt_conn *conn);
 int hid_buttons_release(const uint8_t *keys, size_t cnt);
 int hid_buttons_press(const uint8_t *keys, size_t cnt);
+void hid_tx_stats_get(struct hid_tx_stats *out);
+uint8_t hid_lock_leds_get(void);
+
+#if CONFIG_APP_AIR_MOUSE
+int hid_mouse_move(int16_t dx, int16_t dy);
+#endif
+
+#if CONFIG_APP_HID_CONSUMER
+int hid_consumer_press(uint16_t usage);
+int hid_consumer_release(uint16_t usage);
+int hid_system_press(uint8_t usage);
+int hid_system_release(uint8_t usage);
+#endif
 
 #endif // APP_HID_H
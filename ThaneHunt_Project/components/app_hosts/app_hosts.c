@@ -0,0 +1,515 @@
+/*
+Name : app_hosts
+
+Description :
+    Multi-host support for the BLE HID keyboard. Up to
+    CONFIG_APP_HOST_SLOTS bonded hosts are kept in numbered slots stored in
+    settings, one of them active. Advertising is directed at the active
+    host's bond so it reconnects right away (unless the host uses a
+    resolvable private address, see struct host_slot), other bonded hosts
+    are turned away, and a key chord cycles the active slot.
+
+Date : 2026-10-14
+
+Developer : Engineer Akbar Shah
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/bluetooth/hci.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/settings/settings.h>
+#include <zephyr/sys/printk.h>
+
+#include "app_adv.h"
+#include "app_ble.h"
+#include "app_hosts.h"
+#include "app_store.h"
+
+LOG_MODULE_REGISTER(APP_HOSTS);
+
+#define HOST_SLOTS CONFIG_APP_HOST_SLOTS
+#define HOST_SETTINGS_ROOT "app/host"
+
+BUILD_ASSERT(HOST_SLOTS <= CONFIG_BT_MAX_PAIRED, "More host slots than bonds");
+
+/*
+ * Host bonded in a slot, stored as is under "app/host/<slot>". A host that
+ * connected from a resolvable private address would not recognise
+ * advertising directed at its identity address, so it only gets the
+ * accept-list stage.
+ */
+struct host_slot
+{
+    bt_addr_le_t addr; /* Identity address, BT_ADDR_LE_ANY if empty */
+    bool rpa;          /* Host connects with a resolvable private address */
+};
+
+static struct host_slot host_slot[HOST_SLOTS];
+static atomic_t active_slot; /* Written by the button thread, read from BT callbacks */
+
+/* Key ids currently held, and those whose press the switch chord consumed */
+static uint32_t keys_held;
+static uint32_t keys_consumed;
+
+static void switch_work_fn(struct k_work *work);
+static K_WORK_DEFINE(switch_work, switch_work_fn);
+
+/*
+Function : host_slot_find
+
+Description :
+    Looks up the slot a host address is bonded in.
+
+Parameter :
+    addr : Identity address of the host
+
+Return :
+    int : Slot index, or -ENOENT if the host has no slot
+
+Example Call :
+    int slot = host_slot_find(bt_conn_get_dst(conn));
+*/
+static int host_slot_find(const bt_addr_le_t *addr)
+{
+    for (int i = 0; i < HOST_SLOTS; i++)
+    {
+        if (bt_addr_le_eq(&host_slot[i].addr, addr))
+        {
+            return i;
+        }
+    }
+    return -ENOENT;
+}
+
+/*
+Function : host_slot_save
+
+Description :
+    Writes one slot, or the active slot index when slot is negative, to
+    settings. Goes through the store batch, so an unchanged value is not
+    written again.
+
+Parameter :
+    slot : Slot index, or -1 for the active slot index
+
+Return :
+    void
+
+Example Call :
+    host_slot_save(slot);
+*/
+static void host_slot_save(int slot)
+{
+    char key[sizeof(HOST_SETTINGS_ROOT "/active")];
+    uint8_t active;
+    int err;
+
+    if (slot < 0)
+    {
+        active = (uint8_t)atomic_get(&active_slot);
+        err = store_save(HOST_SETTINGS_ROOT "/active", &active, sizeof(active));
+    }
+    else
+    {
+        snprintk(key, sizeof(key), HOST_SETTINGS_ROOT "/%d", slot);
+        err = store_save(key, &host_slot[slot], sizeof(host_slot[slot]));
+    }
+
+    if (err)
+    {
+        LOG_ERR("Failed to store host slot (err %d)", err);
+    }
+}
+
+/*
+Function : hosts_settings_set
+
+Description :
+    Settings handler loading the "app/host/<slot>" addresses and the
+    "app/host/active" slot index.
+
+Parameter :
+    name    : Key below "app/host"
+    len     : Size of the stored value
+    read_cb : Settings read callback
+    cb_arg  : Argument of read_cb
+
+Return :
+    int : 0 on success, negative error code on failure
+
+Example Call :
+    called by settings_load()
+*/
+static int hosts_settings_set(const char *name, size_t len,
+                              settings_read_cb read_cb, void *cb_arg)
+{
+    const char *next;
+    uint8_t active;
+    ssize_t rc;
+
+    if (settings_name_steq(name, "active", &next) && !next)
+    {
+        if (len != sizeof(active))
+        {
+            return -EINVAL;
+        }
+        rc = read_cb(cb_arg, &active, sizeof(active));
+        atomic_set(&active_slot, (rc == sizeof(active) && active < HOST_SLOTS) ? active : 0);
+        return (rc < 0) ? (int)rc : 0;
+    }
+
+    char *end;
+    unsigned long slot = strtoul(name, &end, 10);
+
+    if ((end == name) || (*end != '\0') || (slot >= HOST_SLOTS) ||
+        (len != sizeof(struct host_slot)))
+    {
+        return -EINVAL;
+    }
+    rc = read_cb(cb_arg, &host_slot[slot], sizeof(host_slot[slot]));
+    return (rc < 0) ? (int)rc : 0;
+}
+
+/*
+Function : bond_check
+
+Description :
+    bt_foreach_bond() callback marking the slot of every existing bond.
+
+Parameter :
+    info      : Bond information
+    user_data : Bitmask of slots that still have a bond
+
+Return :
+    void
+
+Example Call :
+    bt_foreach_bond(BT_ID_DEFAULT, bond_check, &valid);
+*/
+static void bond_check(const struct bt_bond_info *info, void *user_data)
+{
+    uint32_t *valid = user_data;
+    int slot = host_slot_find(&info->addr);
+
+    if (slot >= 0)
+    {
+        *valid |= BIT(slot);
+    }
+}
+
+/*
+Function : hosts_settings_commit
+
+Description :
+    Runs after settings were loaded. Empties slots whose bond was removed
+    by the stack so advertising is never directed at a forgotten host.
+
+Parameter :
+    None
+
+Return :
+    int : Always 0
+
+Example Call :
+    called by settings_load()
+*/
+static int hosts_settings_commit(void)
+{
+    uint32_t valid = 0;
+
+    bt_foreach_bond(BT_ID_DEFAULT, bond_check, &valid);
+    for (int i = 0; i < HOST_SLOTS; i++)
+    {
+        if (!(valid & BIT(i)) && !bt_addr_le_eq(&host_slot[i].addr, BT_ADDR_LE_ANY))
+        {
+            host_slot[i] = (struct host_slot){.addr = *BT_ADDR_LE_ANY};
+            host_slot_save(i);
+        }
+    }
+    LOG_INF("Active host slot %u\n", (uint8_t)atomic_get(&active_slot));
+    return 0;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(app_host, HOST_SETTINGS_ROOT, NULL,
+                               hosts_settings_set, hosts_settings_commit, NULL);
+
+/*
+Function : hosts_active_peer
+
+Description :
+    Returns the bonded address of the active host, used as the target of
+    directed advertising and the accept list.
+
+Parameter :
+    peer : Output address
+    rpa  : Set to true if the host connects with a resolvable private
+           address, i.e. must not be the target of directed advertising
+
+Return :
+    bool : true if the active slot holds a bond, false if it is empty
+
+Example Call :
+    bt_addr_le_t peer;
+    bool rpa;
+    if (hosts_active_peer(&peer, &rpa)) { ... }
+*/
+bool hosts_active_peer(bt_addr_le_t *peer, bool *rpa)
+{
+    const struct host_slot *host = &host_slot[atomic_get(&active_slot)];
+
+    if (bt_addr_le_eq(&host->addr, BT_ADDR_LE_ANY))
+    {
+        return false;
+    }
+    bt_addr_le_copy(peer, &host->addr);
+    *rpa = host->rpa;
+    return true;
+}
+
+/*
+Function : switch_disconnect
+
+Description :
+    bt_conn_foreach() callback dropping the current link ahead of a host
+    switch.
+
+Parameter :
+    conn : Pointer to the Bluetooth connection
+    data : Set to true when a link was found
+
+Return :
+    void
+
+Example Call :
+    bool connected = false;
+    bt_conn_foreach(BT_CONN_TYPE_LE, switch_disconnect, &connected);
+*/
+static void switch_disconnect(struct bt_conn *conn, void *data)
+{
+    bool *connected = data;
+
+    *connected = true;
+    (void)bt_conn_disconnect(conn, BT_HCI_ERR_REMOTE_USER_TERM_CONN);
+}
+
+/*
+Function : switch_work_fn
+
+Description :
+    Moves the keyboard to the newly selected host: drops the current link,
+    whose disconnected callback restarts advertising towards the new
+    active host, or restarts advertising directly if nothing is connected.
+
+Parameter :
+    work : Pointer to the work item (unused)
+
+Return :
+    void
+
+Example Call :
+    k_work_submit(&switch_work);
+*/
+static void switch_work_fn(struct k_work *work)
+{
+    bool connected = false;
+
+    ARG_UNUSED(work);
+
+    bt_conn_foreach(BT_CONN_TYPE_LE, switch_disconnect, &connected);
+    if (!connected)
+    {
+        advertising_start();
+    }
+}
+
+/*
+Function : hosts_select
+
+Description :
+    Makes a slot the active host and switches the link to it. An empty
+    slot leaves the keyboard advertising for a new host to pair into it.
+
+Parameter :
+    slot : Host slot index
+
+Return :
+    void
+
+Example Call :
+    hosts_select(1);
+*/
+void hosts_select(uint8_t slot)
+{
+    if (slot >= HOST_SLOTS || atomic_set(&active_slot, slot) == slot)
+    {
+        return;
+    }
+
+    host_slot_save(-1);
+    LOG_INF("Switching to host slot %u\n", slot);
+    k_work_submit(&switch_work);
+}
+
+/*
+Function : hosts_switch_next
+
+Description :
+    Cycles the active host to the next slot.
+
+Parameter :
+    None
+
+Return :
+    void
+
+Example Call :
+    hosts_switch_next();
+*/
+void hosts_switch_next(void)
+{
+    hosts_select((atomic_get(&active_slot) + 1) % HOST_SLOTS);
+}
+
+/*
+Function : hosts_chord_update
+
+Description :
+    Tracks held keys and cycles the active host when every key of
+    CONFIG_APP_HOST_SWITCH_CHORD becomes held. The key press completing the
+    chord is consumed, and so is the release of that key, so the keymap
+    and the host never see half of a keystroke.
+
+Parameter :
+    key_id  : Key id of the event
+    pressed : true for a press, false for a release
+
+Return :
+    bool : true if the event was consumed by the chord
+
+Example Call :
+    if (hosts_chord_update(ev->key_id, ev->pressed)) { return; }
+*/
+bool hosts_chord_update(uint8_t key_id, bool pressed)
+{
+    const uint32_t chord = CONFIG_APP_HOST_SWITCH_CHORD;
+
+    if (key_id >= 32)
+    {
+        return false;
+    }
+    if (!pressed)
+    {
+        bool consumed = (keys_consumed & BIT(key_id)) != 0;
+
+        keys_held &= ~BIT(key_id);
+        keys_consumed &= ~BIT(key_id);
+        return consumed;
+    }
+
+    keys_held |= BIT(key_id);
+    if (chord && (chord & BIT(key_id)) && ((keys_held & chord) == chord))
+    {
+        keys_consumed |= BIT(key_id);
+        hosts_switch_next();
+        return true;
+    }
+    return false;
+}
+
+/*
+Function : hosts_connected
+
+Description :
+    Connection callback turning away bonded hosts other than the active
+    one, so a host that is not selected cannot grab the keyboard while it
+    advertises.
+
+Parameter :
+    conn : Pointer to the new Bluetooth connection
+    err  : Connection error code
+
+Return :
+    void
+
+Example Call :
+    registered as .connected in BT_CONN_CB_DEFINE
+*/
+static void hosts_connected(struct bt_conn *conn, uint8_t err)
+{
+    int slot;
+
+    if (err)
+    {
+        return;
+    }
+
+    slot = host_slot_find(bt_conn_get_dst(conn));
+    if (slot >= 0 && slot != atomic_get(&active_slot))
+    {
+        LOG_INF("Host slot %d is not active, disconnecting\n", slot);
+        (void)bt_conn_disconnect(conn, BT_HCI_ERR_REMOTE_USER_TERM_CONN);
+    }
+}
+
+/*
+Function : hosts_security_changed
+
+Description :
+    Security callback storing the host in the active slot once the link is
+    encrypted with a bond, along with whether it connected from a
+    resolvable private address. A bond previously held in that slot is
+    removed. A host already bonded into another slot is left alone, since
+    hosts_connected() is dropping its link.
+
+Parameter :
+    conn  : Pointer to the Bluetooth connection
+    level : New security level
+    err   : Security error code
+
+Return :
+    void
+
+Example Call :
+    registered as .security_changed in BT_CONN_CB_DEFINE
+*/
+static void hosts_security_changed(struct bt_conn *conn, bt_security_t level,
+                                   enum bt_security_err err)
+{
+    const bt_addr_le_t *peer = bt_conn_get_dst(conn);
+    uint8_t active = (uint8_t)atomic_get(&active_slot);
+    int slot;
+
+    if (err || level < BT_SECURITY_L2 || !bt_le_bond_exists(BT_ID_DEFAULT, peer))
+    {
+        return;
+    }
+
+    slot = host_slot_find(peer);
+    if (slot >= 0)
+    {
+        if (slot == active)
+        {
+            host_slot[slot].rpa = ble_peer_rpa(conn);
+            host_slot_save(slot); /* the store batch drops an unchanged value */
+        }
+        return; /* a non-active host is being disconnected by hosts_connected() */
+    }
+    if (!bt_addr_le_eq(&host_slot[active].addr, BT_ADDR_LE_ANY))
+    {
+        (void)bt_unpair(BT_ID_DEFAULT, &host_slot[active].addr);
+    }
+
+    bt_addr_le_copy(&host_slot[active].addr, peer);
+    host_slot[active].rpa = ble_peer_rpa(conn);
+    host_slot_save(active);
+    LOG_INF("Host bonded into slot %u\n", active);
+}
+
+BT_CONN_CB_DEFINE(hosts_conn_callbacks) = {
+    .connected = hosts_connected,
+    .security_changed = hosts_security_changed,
+};
@@ -0,0 +1,43 @@
+/*
+Name : app_hosts
+
+Description :
+    Multi-host support for the BLE HID keyboard. Up to
+    CONFIG_APP_HOST_SLOTS bonded hosts are kept in numbered slots stored in
+    settings, one of them active. Advertising is directed at the active
+    host's bond so it reconnects right away, other bonded hosts are turned
+    away, and a key chord cycles the active slot.
+
+Date : 2026-10-14
+
+Developer : Engineer Akbar Shah
+*/
+
+#ifndef APP_HOSTS_H
+#define APP_HOSTS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <zephyr/bluetooth/addr.h>
+
+#if CONFIG_APP_MULTI_HOST
+bool hosts_active_peer(bt_addr_le_t *peer, bool *rpa);
+void hosts_select(uint8_t slot);
+void hosts_switch_next(void);
+bool hosts_chord_update(uint8_t key_id, bool pressed);
+#else
+static inline bool hosts_active_peer(bt_addr_le_t *peer, bool *rpa)
+{
+    (void)peer;
+    (void)rpa;
+    return false;
+}
+static inline bool hosts_chord_update(uint8_t key_id, bool pressed)
+{
+    (void)key_id;
+    (void)pressed;
+    return false;
+}
+#endif
+
+#endif // APP_HOSTS_H
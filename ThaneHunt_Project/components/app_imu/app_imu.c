@@ -3,8 +3,20 @@ Name : app_imu
 
 Description :
     LSM6DSO IMU interface for Zephyr RTOS over I2C. This module initializes
-    the sensor, periodically reads raw accelerometer/gyroscope samples in a
-    dedicated thread, and logs the raw LSB values for debugging/bring-up.
+    the sensor and runs a dedicated acquisition thread, woken by the INT1
+    interrupt (or a poll tick on boards without the INT1 line wired). In
+    FIFO mode the sensor batches accel/gyro samples in its on-chip FIFO and
+    raises INT1 at a watermark; the thread drains the whole FIFO in burst
+    reads. Samples are packed into blocks from a fixed pool and handed to
+    the consumer without copying; the raw LSB values are logged once per
+    second for debugging/bring-up. With the air mouse enabled, a fixed
+    point stage removes the gyro bias, low-pass filters the rates with a
+    Q15 FIR (DSP SIMD on Cortex-M33) and integrates them into mouse deltas
+    for the HID mouse report. Before system-off the accelerometer can be
+    left in ultra-low-power mode with its wake-up interrupt on INT1, so that
+    picking the device up wakes the SoC. The same state is used for the
+    connected-sleep power tier, where motion brings the device back to
+    active.
 
 Date : 2025-09-14
 
@@ -17,6 +29,25 @@ Developer : Engineer Akbar Shah
 #include <zephyr/drivers/i2c.h>
 #include <zephyr/logging/log.h>
 #include <zephyr/devicetree.h>
+#include <zephyr/drivers/gpio.h>
+
+#include "app_energy.h"
+#include "app_sleep.h"
+#include "app_wake.h"
+
+#if CONFIG_APP_AIR_MOUSE
+#include <stdlib.h>
+#include <string.h>
+
+#include "app_hid.h"
+
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+#include <cmsis_core.h>
+#define MOTION_USE_DSP 1
+#else
+#define MOTION_USE_DSP 0
+#endif
+#endif
 
 LOG_MODULE_REGISTER(APP_IMU, LOG_LEVEL_INF);
 
@@ -26,28 +57,153 @@ LOG_MODULE_REGISTER(APP_IMU, LOG_LEVEL_INF);
 #define LSM6DSO_REG_WHO_AM_I 0x0F // Identification register
 #define LSM6DSO_WHO_AM_I_VAL 0x6A // Expected WHO_AM_I value
 
+#define LSM6DSO_REG_FIFO_CTRL1 0x07 // FIFO watermark [7:0]
+#define LSM6DSO_REG_FIFO_CTRL2 0x08 // FIFO watermark [8] in bit 0
+#define LSM6DSO_REG_FIFO_CTRL3 0x09 // Batch data rate: BDR_GY [7:4], BDR_XL [3:0]
+#define LSM6DSO_REG_FIFO_CTRL4 0x0A // FIFO mode [2:0]
+#define LSM6DSO_FIFO_MODE_BYPASS 0x00
+#define LSM6DSO_FIFO_MODE_CONTINUOUS 0x06
+
+#define LSM6DSO_REG_INT1_CTRL 0x0D  // INT1 pin routing
+#define LSM6DSO_INT1_DRDY_XL 0x01   // Accelerometer data-ready on INT1
+#define LSM6DSO_INT1_FIFO_TH 0x08   // FIFO watermark on INT1
+
+#define LSM6DSO_REG_CTRL3_C 0x12     // Control register 3
+#define LSM6DSO_CTRL3_C_BDU 0x40     // Block data update
+#define LSM6DSO_CTRL3_C_IF_INC 0x04  // Register address auto-increment
+
+#define LSM6DSO_REG_FIFO_STATUS1 0x3A  // Unread FIFO words [7:0]
+#define LSM6DSO_FIFO_STATUS2_DIFF 0x03 // Unread FIFO words [9:8]
+#define LSM6DSO_FIFO_STATUS2_OVR 0x08  // FIFO overrun (latched)
+
+#define LSM6DSO_REG_FIFO_DATA_OUT_TAG 0x78 // Tag byte + 6 data bytes per FIFO word
+#define LSM6DSO_FIFO_WORD_LEN 7
+#define LSM6DSO_FIFO_TAG_GYRO 0x01  // TAG_SENSOR [7:3]: gyroscope NC
+#define LSM6DSO_FIFO_TAG_ACCEL 0x02 // TAG_SENSOR [7:3]: accelerometer NC
+
 #define LSM6DSO_REG_CTRL1_XL 0x10 // Accelerometer control register
 #define LSM6DSO_REG_CTRL2_G 0x11  // Gyroscope control register
+#define LSM6DSO_REG_CTRL5_C 0x14  // Control register 5
+#define LSM6DSO_CTRL5_C_XL_ULP_EN 0x80 // Accelerometer ultra-low-power mode (gyro off only)
+
+// Wake-up (activity) detection
+#define LSM6DSO_REG_WAKE_UP_SRC 0x1B // Wake-up source, reading it clears the latch
+#define LSM6DSO_REG_TAP_CFG0 0x56    // LIR in bit 0: latched interrupts
+#define LSM6DSO_TAP_CFG0_LIR 0x01
+#define LSM6DSO_REG_TAP_CFG2 0x58 // INTERRUPTS_ENABLE in bit 7
+#define LSM6DSO_TAP_CFG2_INT_EN 0x80
+#define LSM6DSO_REG_WAKE_UP_THS 0x5B // WK_THS [5:0], 1 LSB = FS_XL / 64
+#define LSM6DSO_REG_WAKE_UP_DUR 0x5C // WAKE_DUR [6:5], in ODR periods
+#define LSM6DSO_REG_MD1_CFG 0x5E     // Embedded function routing to INT1
+#define LSM6DSO_MD1_CFG_INT1_WU 0x20
+#define LSM6DSO_WAKE_ODR_CODE 0x1 // 12.5 Hz in ultra-low-power mode
 // Accelerometer/gyroscope data output registers (low byte first)
 #define LSM6DSO_REG_OUTX_L_XL 0x28 // Accelerometer X axis low byte
 #define LSM6DSO_REG_OUTX_L_G 0x22  // Gyroscope X axis low byte
 
 #define LSM6DSO_ODR_MASK 0xF0 /* ODR bits are [7:4]; 0000 = power-down */
 
+#define IMU_USER_NODE DT_PATH(zephyr_user)
+#define IMU_HAS_INT1 DT_NODE_HAS_PROP(IMU_USER_NODE, imu_int1_gpios)
+
+#if CONFIG_APP_IMU_FIFO
+#define IMU_ODR_CODE 0x4 // 104 Hz, for ODR_XL/ODR_G and the FIFO batch rates
+#define IMU_ODR_HZ 104
+#define IMU_FIFO_WTM CONFIG_APP_IMU_FIFO_WATERMARK // FIFO words (accel + gyro)
+#define IMU_FIFO_BURST_WORDS 32                    // FIFO words per I2C burst
+#define IMU_POLL_PERIOD_MS ((IMU_FIFO_WTM * 1000) / (2 * IMU_ODR_HZ))
+#define IMU_LOG_EVERY IMU_ODR_HZ // Log one sample per second of data
+#else
+#define IMU_ODR_CODE 0x1 // 12.5 Hz
+#define IMU_ODR_HZ 13
+#define IMU_POLL_PERIOD_MS 1000 // Poll tick when INT1 is not wired
+#define IMU_LOG_EVERY (IMU_HAS_INT1 ? IMU_ODR_HZ : 1)
+#endif
+
+#define IMU_THREAD_STACK_SIZE CONFIG_APP_IMU_THREAD_STACK_SIZE
+#define IMU_THREAD_PRIO 5 /* below the button thread, HID latency comes first */
+#define IMU_BLOCK_COUNT 4 /* blocks in the pool, shared by producer and consumer */
+
 const struct device *i2c_dev = DEVICE_DT_GET(DT_ALIAS(lsm6ds0i2c));
 
+#if IMU_HAS_INT1
+static const struct gpio_dt_spec imu_int1 = GPIO_DT_SPEC_GET(IMU_USER_NODE, imu_int1_gpios);
+static struct gpio_callback imu_int1_cb;
+#else
+static void imu_poll_expiry(struct k_timer *timer);
+K_TIMER_DEFINE(imu_poll_timer, imu_poll_expiry, NULL);
+#endif
+
 bool imu_power_down = false;
+static bool imu_wake_armed; /* wake-up interrupt routed to INT1 */
+
+static void imu_tier_enter(enum power_tier tier);
+static void imu_tier_exit(enum power_tier tier);
+
+static struct power_hook imu_power_hook = {
+    .enter = imu_tier_enter,
+    .exit = imu_tier_exit,
+};
+
+static void lsm6dso_display_raw_data(const struct lsm6dso_raw_data *raw_data);
+static void imu_thread_fn(void *p1, void *p2, void *p3);
 
-struct lsm6dso_raw_data
+#if CONFIG_APP_AIR_MOUSE
+/*
+ * Motion stage, per axis: gyro zero-rate bias removal, dead zone, 8-tap
+ * Q15 low-pass FIR, then integration into mouse counts with the fraction
+ * carried over (Q16). The sensor is assumed flat with X forward: yaw
+ * (gyro Z) moves the cursor horizontally, pitch (gyro Y) vertically.
+ */
+#define MOTION_FIR_TAPS 8
+#define MOTION_GAIN CONFIG_APP_AIR_MOUSE_GAIN /* Q16 mouse counts per gyro LSB per sample */
+#define MOTION_DEADZONE 40                    /* LSB (~0.35 dps) treated as no motion */
+#define MOTION_REST_LIMIT 300                 /* LSB (~2.6 dps) under which the bias is tracked */
+#define MOTION_BIAS_SHIFT 6                   /* Bias EMA weight 1/64 */
+
+/* Hamming windowed low-pass, Q15, taps sum to 32768 (unity DC gain) */
+static const int16_t motion_fir[MOTION_FIR_TAPS] __aligned(4) = {
+    1092, 2545, 5003, 7744, 7744, 5003, 2545, 1092,
+};
+
+struct motion_axis
 {
-    int16_t accel_x;
-    int16_t accel_y;
-    int16_t accel_z;
-    int16_t gyro_x;
-    int16_t gyro_y;
-    int16_t gyro_z;
+    int16_t hist[MOTION_FIR_TAPS] __aligned(4); /* Filter input, newest last */
+    int32_t bias_q8;                             /* Zero-rate offset, Q8 LSB */
+    int32_t acc_q16;                             /* Counts not output yet, Q16 */
+    bool seeded;
 };
 
+static struct motion_axis motion_x;
+static struct motion_axis motion_y;
+#endif
+
+static k_tid_t imu_thread_tid;
+static struct k_thread imu_thread_data;
+K_THREAD_STACK_DEFINE(imu_thread_stack, IMU_THREAD_STACK_SIZE);
+
+/* Given by the INT1 interrupt or the poll tick, taken by the IMU thread */
+static K_SEM_DEFINE(imu_data_sem, 0, 1);
+
+/*
+ * Zero-copy sample handoff: the thread fills a block from the pool and
+ * queues the pointer; the consumer returns it with imu_block_release().
+ */
+K_MEM_SLAB_DEFINE_STATIC(imu_block_slab, sizeof(struct imu_block), IMU_BLOCK_COUNT, 4);
+static K_FIFO_DEFINE(imu_block_fifo);
+static struct imu_block *imu_block_cur; /* block being filled, thread only */
+
+#if CONFIG_APP_IMU_FIFO
+/* Burst buffer for raw FIFO words, thread only */
+static uint8_t imu_fifo_buf[IMU_FIFO_BURST_WORDS * LSM6DSO_FIFO_WORD_LEN];
+
+/* Sample being assembled from its accel and gyro FIFO words */
+static struct lsm6dso_raw_data imu_pending;
+static uint8_t imu_pending_mask;
+#define IMU_PENDING_ACCEL BIT(0)
+#define IMU_PENDING_GYRO BIT(1)
+#endif
+
 /*
 Function : lsm6dso_i2c_reg_write_byte
 
@@ -113,18 +269,243 @@ Example Call :
     uint8_t buf[6];
     int ret = lsm6dso_i2c_reg_read_bytes(i2c_dev, LSM6DSO_REG_OUTX_L_XL, buf, 6);
 */
-static int lsm6dso_i2c_reg_read_bytes(const struct device *i2c_dev, uint8_t reg_addr, uint8_t *data, uint8_t len)
+static int lsm6dso_i2c_reg_read_bytes(const struct device *i2c_dev, uint8_t reg_addr, uint8_t *data, uint16_t len)
 {
     return i2c_burst_read(i2c_dev, LSM6DSO_I2C_ADDR, reg_addr, data, len);
 }
 
+#if CONFIG_APP_AIR_MOUSE
+/*
+Function : motion_fir_apply
+
+Description :
+    Runs the Q15 FIR over an axis history. With the DSP extension two
+    16-bit taps are multiplied and accumulated per __SMLAD; the result is
+    saturated back to Q15 with __SSAT.
+
+Parameter :
+    hist : Filter history, MOTION_FIR_TAPS samples, 4-byte aligned
+
+Return :
+    int16_t : Filtered rate, gyro LSB
+
+Example Call :
+    int16_t rate = motion_fir_apply(ax->hist);
+*/
+static int16_t motion_fir_apply(const int16_t *hist)
+{
+    int32_t acc = 0;
+
+#if MOTION_USE_DSP
+    const uint32_t *h = (const uint32_t *)hist;
+    const uint32_t *c = (const uint32_t *)motion_fir;
+
+    for (size_t i = 0; i < MOTION_FIR_TAPS / 2; i++)
+    {
+        acc = (int32_t)__SMLAD(h[i], c[i], (uint32_t)acc);
+    }
+    return (int16_t)__SSAT(acc >> 15, 16);
+#else
+    for (size_t i = 0; i < MOTION_FIR_TAPS; i++)
+    {
+        acc += (int32_t)hist[i] * motion_fir[i];
+    }
+    acc >>= 15;
+    return (int16_t)CLAMP(acc, INT16_MIN, INT16_MAX);
+#endif
+}
+
+/*
+Function : motion_axis_update
+
+Description :
+    Feeds one raw gyro rate into an axis: removes the zero-rate bias
+    (learned while the rate stays small), applies the dead zone, filters
+    and integrates the result.
+
+Parameter :
+    ax  : Axis state
+    raw : Raw gyro rate, LSB
+
+Return :
+    void
+
+Example Call :
+    motion_axis_update(&motion_x, -sample->gyro_z);
+*/
+static void motion_axis_update(struct motion_axis *ax, int16_t raw)
+{
+    int32_t rate_q8;
+    int32_t rate;
+
+    if (!ax->seeded)
+    {
+        ax->bias_q8 = (int32_t)raw << 8; /* assume the device is still at start */
+        ax->seeded = true;
+    }
+
+    rate_q8 = ((int32_t)raw << 8) - ax->bias_q8;
+    if (abs(rate_q8) < (MOTION_REST_LIMIT << 8))
+    {
+        ax->bias_q8 += rate_q8 >> MOTION_BIAS_SHIFT;
+    }
+
+    rate = rate_q8 >> 8;
+    if (abs(rate) < MOTION_DEADZONE)
+    {
+        rate = 0;
+    }
+
+    memmove(&ax->hist[0], &ax->hist[1], (MOTION_FIR_TAPS - 1) * sizeof(ax->hist[0]));
+    ax->hist[MOTION_FIR_TAPS - 1] = (int16_t)CLAMP(rate, INT16_MIN, INT16_MAX);
+
+    ax->acc_q16 += (int32_t)motion_fir_apply(ax->hist) * MOTION_GAIN;
+}
+
+/*
+Function : motion_axis_take
+
+Description :
+    Takes the whole mouse counts integrated on an axis, keeping the
+    fraction for the next report.
+
+Parameter :
+    ax : Axis state
+
+Return :
+    int16_t : Mouse counts
+
+Example Call :
+    int16_t dx = motion_axis_take(&motion_x);
+*/
+static int16_t motion_axis_take(struct motion_axis *ax)
+{
+    int32_t counts = ax->acc_q16 / 65536; /* rounds toward zero for both signs */
+
+    ax->acc_q16 -= counts * 65536;
+    return (int16_t)CLAMP(counts, -INT16_MAX, INT16_MAX);
+}
+
+/*
+Function : motion_flush
+
+Description :
+    Hands the motion integrated since the last call to the HID mouse
+    report. Cursor motion counts as user activity for the idle timer and
+    the connection parameter policy.
+
+Parameter :
+    void
+
+Return :
+    void
+
+Example Call :
+    motion_flush();
+*/
+static void motion_flush(void)
+{
+    int16_t dx = motion_axis_take(&motion_x);
+    int16_t dy = motion_axis_take(&motion_y);
+
+    if (dx || dy)
+    {
+        if (hid_mouse_move(dx, dy) == 0)
+        {
+            reset_idle_timer();
+        }
+    }
+}
+#endif
+
+/*
+Function : imu_block_publish
+
+Description :
+    Queues the block being filled to the consumer, if it holds any sample.
+
+Parameter :
+    void
+
+Return :
+    void
+
+Example Call :
+    imu_block_publish();
+*/
+static void imu_block_publish(void)
+{
+    if (imu_block_cur && imu_block_cur->count)
+    {
+        imu_block_cur->timestamp = k_uptime_get_32();
+        k_fifo_put(&imu_block_fifo, imu_block_cur);
+        imu_block_cur = NULL;
+    }
+}
+
+/*
+Function : imu_sample_push
+
+Description :
+    Appends one sample to the block being filled, publishing it when full.
+    A new block is taken from the pool; when the consumer holds on to every
+    block, the oldest queued block is reclaimed so the newest data wins.
+    Also logs one sample out of IMU_LOG_EVERY.
+
+Parameter :
+    sample : Sample to append
+
+Return :
+    void
+
+Example Call :
+    imu_sample_push(&sample);
+*/
+static void imu_sample_push(const struct lsm6dso_raw_data *sample)
+{
+    static uint8_t log_cnt;
+
+    if (!imu_block_cur)
+    {
+        if (k_mem_slab_alloc(&imu_block_slab, (void **)&imu_block_cur, K_NO_WAIT) != 0)
+        {
+            imu_block_cur = k_fifo_get(&imu_block_fifo, K_NO_WAIT);
+            if (!imu_block_cur)
+            {
+                return; /* every block is held by the consumer */
+            }
+            LOG_DBG("IMU consumer too slow, oldest block dropped");
+        }
+        imu_block_cur->count = 0;
+    }
+
+#if CONFIG_APP_AIR_MOUSE
+    motion_axis_update(&motion_x, -sample->gyro_z);
+    motion_axis_update(&motion_y, sample->gyro_y);
+#endif
+
+    imu_block_cur->samples[imu_block_cur->count++] = *sample;
+    if (imu_block_cur->count == IMU_BLOCK_SAMPLES)
+    {
+        imu_block_publish();
+    }
+
+    if (++log_cnt >= IMU_LOG_EVERY)
+    {
+        log_cnt = 0;
+        lsm6dso_display_raw_data(sample);
+    }
+}
+
+#if !CONFIG_APP_IMU_FIFO
 /*
 Function : lsm6dso_fetch_raw_data
 
 Description :
     Fetches raw 16-bit accelerometer and gyroscope samples (XYZ each) from
-    the LSM6DSO and packs them into the provided struct. Data is read in LSB
-    (little-endian) order.
+    the LSM6DSO and packs them into the provided struct. The gyroscope and
+    accelerometer output registers are contiguous, so both are read in one
+    12-byte burst. Data is read in LSB (little-endian) order.
 
 Parameter :
     i2c_dev      : Pointer to the I2C device instance
@@ -139,36 +520,29 @@ Example Call :
 */
 static int lsm6dso_fetch_raw_data(const struct device *i2c_dev, struct lsm6dso_raw_data *raw_data_out)
 {
-    uint8_t accel_data[6];
-    uint8_t gyro_data[6];
+    uint8_t data[12];
+    const uint8_t *gyro_data = &data[0];
+    const uint8_t *accel_data = &data[LSM6DSO_REG_OUTX_L_XL - LSM6DSO_REG_OUTX_L_G];
     int ret;
 
-    // Read accelerometer data (6 bytes)
-    ret = lsm6dso_i2c_reg_read_bytes(i2c_dev, LSM6DSO_REG_OUTX_L_XL, accel_data, 6);
+    // Read gyroscope + accelerometer data (12 bytes)
+    ret = lsm6dso_i2c_reg_read_bytes(i2c_dev, LSM6DSO_REG_OUTX_L_G, data, sizeof(data));
     if (ret != 0)
     {
-        LOG_ERR("Failed to read accelerometer data (err: %d).", ret);
+        LOG_ERR("Failed to read accelerometer/gyroscope data (err: %d).", ret);
         return ret;
     }
     // Raw data is 16-bit signed integer, low byte first
     raw_data_out->accel_x = (int16_t)(accel_data[0] | (accel_data[1] << 8));
     raw_data_out->accel_y = (int16_t)(accel_data[2] | (accel_data[3] << 8));
     raw_data_out->accel_z = (int16_t)(accel_data[4] | (accel_data[5] << 8));
-
-    // Read gyroscope data (6 bytes)
-    ret = lsm6dso_i2c_reg_read_bytes(i2c_dev, LSM6DSO_REG_OUTX_L_G, gyro_data, 6);
-    if (ret != 0)
-    {
-        LOG_ERR("Failed to read gyroscope data (err: %d).", ret);
-        return ret;
-    }
-    // Raw data is 16-bit signed integer, low byte first
     raw_data_out->gyro_x = (int16_t)(gyro_data[0] | (gyro_data[1] << 8));
     raw_data_out->gyro_y = (int16_t)(gyro_data[2] | (gyro_data[3] << 8));
     raw_data_out->gyro_z = (int16_t)(gyro_data[4] | (gyro_data[5] << 8));
 
     return 0;
 }
+#endif
 
 /*
 Function : lsm6dso_display_raw_data
@@ -189,11 +563,164 @@ Example Call :
 */
 static void lsm6dso_display_raw_data(const struct lsm6dso_raw_data *raw_data)
 {
-    LOG_INF("LSM6DSO ACCEL + GYRP: [AX:%d AY:%d AZ:%d] [GX:%d GY:%d GZ:%d]",
+    LOG_DBG("LSM6DSO ACCEL + GYRO: [AX:%d AY:%d AZ:%d] [GX:%d GY:%d GZ:%d]",
             raw_data->accel_x, raw_data->accel_y, raw_data->accel_z, raw_data->gyro_x, raw_data->gyro_y, raw_data->gyro_z);
-            k_msleep(500); // Slow down logging for readability
+}
+
+#if CONFIG_APP_IMU_FIFO
+/*
+Function : lsm6dso_fifo_config
+
+Description :
+    Sets up the on-chip FIFO: block data update, the watermark, accel and
+    gyro batched at the output data rate, and continuous mode (oldest data
+    is overwritten when the FIFO is full). Passing through bypass mode
+    first discards whatever the FIFO held.
+
+Parameter :
+    i2c_dev : Pointer to the I2C device instance
+
+Return :
+    int : 0 on success, negative errno on first failure
+
+Example Call :
+    int ret = lsm6dso_fifo_config(i2c_dev);
+*/
+static int lsm6dso_fifo_config(const struct device *i2c_dev)
+{
+    const uint8_t regs[][2] = {
+        {LSM6DSO_REG_CTRL3_C, LSM6DSO_CTRL3_C_BDU | LSM6DSO_CTRL3_C_IF_INC},
+        {LSM6DSO_REG_FIFO_CTRL4, LSM6DSO_FIFO_MODE_BYPASS},
+        {LSM6DSO_REG_FIFO_CTRL1, IMU_FIFO_WTM & 0xFF},
+        {LSM6DSO_REG_FIFO_CTRL2, (IMU_FIFO_WTM >> 8) & 0x01},
+        {LSM6DSO_REG_FIFO_CTRL3, (IMU_ODR_CODE << 4) | IMU_ODR_CODE},
+        {LSM6DSO_REG_FIFO_CTRL4, LSM6DSO_FIFO_MODE_CONTINUOUS},
+    };
+    int ret;
+
+    for (size_t i = 0; i < ARRAY_SIZE(regs); i++)
+    {
+        ret = lsm6dso_i2c_reg_write_byte(i2c_dev, regs[i][0], regs[i][1]);
+        if (ret)
+        {
+            LOG_ERR("Failed to write FIFO register 0x%02x (err: %d)", regs[i][0], ret);
+            return ret;
+        }
+    }
+    return 0;
 }
 
+/*
+Function : imu_fifo_word_parse
+
+Description :
+    Decodes one tagged FIFO word. Accel and gyro words of the same batch
+    are combined into one sample, which is pushed into the current block
+    once both halves are in.
+
+Parameter :
+    word : Pointer to the 7-byte FIFO word (tag + X/Y/Z, low byte first)
+
+Return :
+    void
+
+Example Call :
+    imu_fifo_word_parse(&imu_fifo_buf[i * LSM6DSO_FIFO_WORD_LEN]);
+*/
+static void imu_fifo_word_parse(const uint8_t *word)
+{
+    uint8_t tag = word[0] >> 3;
+    int16_t x = (int16_t)(word[1] | (word[2] << 8));
+    int16_t y = (int16_t)(word[3] | (word[4] << 8));
+    int16_t z = (int16_t)(word[5] | (word[6] << 8));
+
+    if (tag == LSM6DSO_FIFO_TAG_ACCEL)
+    {
+        imu_pending.accel_x = x;
+        imu_pending.accel_y = y;
+        imu_pending.accel_z = z;
+        imu_pending_mask |= IMU_PENDING_ACCEL;
+    }
+    else if (tag == LSM6DSO_FIFO_TAG_GYRO)
+    {
+        imu_pending.gyro_x = x;
+        imu_pending.gyro_y = y;
+        imu_pending.gyro_z = z;
+        imu_pending_mask |= IMU_PENDING_GYRO;
+    }
+    else
+    {
+        return; /* timestamp/temperature words are not batched, ignore */
+    }
+
+    if (imu_pending_mask != (IMU_PENDING_ACCEL | IMU_PENDING_GYRO))
+    {
+        return;
+    }
+    imu_pending_mask = 0;
+
+    imu_sample_push(&imu_pending);
+}
+
+/*
+Function : imu_fifo_drain
+
+Description :
+    Reads the number of unread FIFO words and drains them all, up to
+    IMU_FIFO_BURST_WORDS per I2C transaction. Reading past the last data
+    register wraps back to FIFO_DATA_OUT_TAG, so consecutive words come out
+    of a single burst read.
+
+Parameter :
+    void
+
+Return :
+    int : Number of FIFO words read, or negative errno on failure
+
+Example Call :
+    int words = imu_fifo_drain();
+*/
+static int imu_fifo_drain(void)
+{
+    uint8_t status[2];
+    uint16_t words;
+    int total = 0;
+    int ret;
+
+    ret = lsm6dso_i2c_reg_read_bytes(i2c_dev, LSM6DSO_REG_FIFO_STATUS1, status, sizeof(status));
+    if (ret)
+    {
+        return ret;
+    }
+
+    words = status[0] | ((status[1] & LSM6DSO_FIFO_STATUS2_DIFF) << 8);
+    if (status[1] & LSM6DSO_FIFO_STATUS2_OVR)
+    {
+        LOG_WRN("LSM6DSO FIFO overrun, samples lost");
+    }
+
+    while (words)
+    {
+        uint16_t n = MIN(words, IMU_FIFO_BURST_WORDS);
+
+        ret = lsm6dso_i2c_reg_read_bytes(i2c_dev, LSM6DSO_REG_FIFO_DATA_OUT_TAG, imu_fifo_buf,
+                                         n * LSM6DSO_FIFO_WORD_LEN);
+        if (ret)
+        {
+            return ret;
+        }
+
+        for (uint16_t i = 0; i < n; i++)
+        {
+            imu_fifo_word_parse(&imu_fifo_buf[i * LSM6DSO_FIFO_WORD_LEN]);
+        }
+        words -= n;
+        total += n;
+    }
+    return total;
+}
+#endif
+
 /*
 Function : lsm6dso_accel_power_down
 
@@ -274,6 +801,13 @@ int lsm6dso_accel_gyro_power_down(void)
 {
     int ret;
     imu_power_down = true;
+    energy_state_set(ENERGY_STATE_IMU, false);
+
+#if IMU_HAS_INT1
+    (void)gpio_pin_interrupt_configure_dt(&imu_int1, GPIO_INT_DISABLE);
+#else
+    k_timer_stop(&imu_poll_timer);
+#endif
 
     ret = lsm6dso_accel_power_down(i2c_dev);
     if (ret)
@@ -286,12 +820,293 @@ int lsm6dso_accel_gyro_power_down(void)
     return 0;
 }
 
+/*
+Function : lsm6dso_wake_disarm
+
+Description :
+    Undoes the wake-on-motion setup. The sensor keeps its registers while
+    the SoC is in system-off, so this runs on every init: the accelerometer
+    is stopped to leave ultra-low-power mode, the wake-up interrupt is
+    unrouted and the latched wake-up event is cleared.
+
+Parameter :
+    i2c_dev : Pointer to the I2C device instance
+
+Return :
+    int : 0 on success, negative errno on failure
+
+Example Call :
+    ret = lsm6dso_wake_disarm(i2c_dev);
+*/
+static int lsm6dso_wake_disarm(const struct device *i2c_dev)
+{
+    const uint8_t regs[][2] = {
+        {LSM6DSO_REG_CTRL1_XL, 0x00}, /* XL_ULP_EN may only change in power-down */
+        {LSM6DSO_REG_CTRL5_C, 0x00},
+        {LSM6DSO_REG_MD1_CFG, 0x00},
+        {LSM6DSO_REG_TAP_CFG2, 0x00},
+        {LSM6DSO_REG_TAP_CFG0, 0x00},
+    };
+    uint8_t src;
+    int ret;
+
+    for (size_t i = 0; i < ARRAY_SIZE(regs); i++)
+    {
+        ret = lsm6dso_i2c_reg_write_byte(i2c_dev, regs[i][0], regs[i][1]);
+        if (ret)
+        {
+            return ret;
+        }
+    }
+    return lsm6dso_i2c_reg_read_byte(i2c_dev, LSM6DSO_REG_WAKE_UP_SRC, &src);
+}
+
+#if IMU_WAKE_ON_MOTION
+/*
+Function : imu_wake_on_motion_arm
+
+Description :
+    Prepares the IMU as a wake source for system-off. Sampling stops, the
+    gyroscope and the FIFO are turned off and the accelerometer runs at
+    12.5 Hz in ultra-low-power mode. Its wake-up interrupt (slope above
+    CONFIG_APP_IMU_WAKE_THRESHOLD) is latched on INT1 until the next init.
+    Call imu_wake_sense_arm() right before sys_poweroff() to make INT1 a
+    GPIO sense wake source.
+
+Parameter :
+    void
+
+Return :
+    int : 0 on success, negative errno on failure
+
+Example Call :
+    err = imu_wake_on_motion_arm();
+*/
+int imu_wake_on_motion_arm(void)
+{
+    const uint8_t regs[][2] = {
+        {LSM6DSO_REG_INT1_CTRL, 0x00},
+        {LSM6DSO_REG_FIFO_CTRL4, LSM6DSO_FIFO_MODE_BYPASS},
+        {LSM6DSO_REG_CTRL2_G, 0x00},
+        {LSM6DSO_REG_CTRL1_XL, 0x00},
+        {LSM6DSO_REG_CTRL5_C, LSM6DSO_CTRL5_C_XL_ULP_EN},
+        {LSM6DSO_REG_WAKE_UP_DUR, 0x00}, /* one sample over the threshold */
+        {LSM6DSO_REG_WAKE_UP_THS, CONFIG_APP_IMU_WAKE_THRESHOLD & 0x3F},
+        {LSM6DSO_REG_TAP_CFG0, LSM6DSO_TAP_CFG0_LIR},
+        {LSM6DSO_REG_TAP_CFG2, LSM6DSO_TAP_CFG2_INT_EN},
+        {LSM6DSO_REG_MD1_CFG, LSM6DSO_MD1_CFG_INT1_WU},
+        {LSM6DSO_REG_CTRL1_XL, LSM6DSO_WAKE_ODR_CODE << 4}, /* ±2 g */
+    };
+    uint8_t src;
+    int ret;
+
+    imu_power_down = true;
+    energy_state_set(ENERGY_STATE_IMU, false); /* ultra-low-power wake mode counts as off */
+    wake_ctx_get()->imu_flags |= WAKE_IMU_ARMED; /* the next init undoes even a partial setup */
+    (void)gpio_pin_interrupt_configure_dt(&imu_int1, GPIO_INT_DISABLE);
+
+    for (size_t i = 0; i < ARRAY_SIZE(regs); i++)
+    {
+        ret = lsm6dso_i2c_reg_write_byte(i2c_dev, regs[i][0], regs[i][1]);
+        if (ret)
+        {
+            LOG_ERR("Failed to write wake register 0x%02x (err: %d)", regs[i][0], ret);
+            return ret;
+        }
+    }
+
+    /* Drop a wake-up event latched by the reconfiguration itself */
+    ret = lsm6dso_i2c_reg_read_byte(i2c_dev, LSM6DSO_REG_WAKE_UP_SRC, &src);
+    if (ret)
+    {
+        return ret;
+    }
+
+    /* INT1 now signals motion: back on edges, handled by imu_int1_isr() */
+    imu_wake_armed = true;
+    return gpio_pin_interrupt_configure_dt(&imu_int1, GPIO_INT_EDGE_TO_ACTIVE);
+}
+
+/*
+Function : imu_wake_sense_arm
+
+Description :
+    Arms INT1 as a level interrupt, which sets the GPIO SENSE that wakes
+    the SoC from system-off. The wake-up event is latched, so the line
+    would keep interrupting once it is active: call this with interrupts
+    locked, immediately before sys_poweroff(). Does nothing unless
+    imu_wake_on_motion_arm() succeeded.
+
+Parameter :
+    void
+
+Return :
+    void
+
+Example Call :
+    imu_wake_sense_arm();
+*/
+void imu_wake_sense_arm(void)
+{
+    if (!imu_wake_armed)
+    {
+        return;
+    }
+    gpio_remove_callback_dt(&imu_int1, &imu_int1_cb);
+    (void)gpio_pin_interrupt_configure_dt(&imu_int1, GPIO_INT_LEVEL_ACTIVE);
+}
+#endif
+
+#if IMU_HAS_INT1
+/*
+Function : imu_int1_isr
+
+Description :
+    INT1 interrupt. Only wakes the IMU thread; the data is read over I2C
+    in thread context.
+
+Parameter :
+    port : GPIO port device (unused)
+    cb   : GPIO callback (unused)
+    pins : Pin mask that triggered (unused)
+
+Return :
+    void
+
+Example Call :
+    registered with gpio_add_callback()
+*/
+static void imu_int1_isr(const struct device *port, struct gpio_callback *cb, gpio_port_pins_t pins)
+{
+    ARG_UNUSED(port);
+    ARG_UNUSED(cb);
+    ARG_UNUSED(pins);
+
+    if (imu_wake_armed)
+    {
+        reset_idle_timer(); /* motion in connected-sleep */
+        return;
+    }
+    k_sem_give(&imu_data_sem);
+}
+
+/*
+Function : imu_sample_signal_start
+
+Description :
+    Routes the accelerometer data-ready signal (or, in FIFO mode, the FIFO
+    watermark) to INT1 and arms the INT1 GPIO interrupt. Both signals stay
+    active until the data is read, so one event is posted up front to pick
+    up data that may already be pending and would otherwise never produce
+    an edge.
+
+Parameter :
+    void
+
+Return :
+    int : 0 on success, negative errno on failure
+
+Example Call :
+    int ret = imu_sample_signal_start();
+*/
+static int imu_sample_signal_start(void)
+{
+    int ret;
+
+    if (!gpio_is_ready_dt(&imu_int1))
+    {
+        LOG_ERR("IMU INT1 GPIO is not ready");
+        return -ENODEV;
+    }
+
+    ret = gpio_pin_configure_dt(&imu_int1, GPIO_INPUT);
+    if (ret)
+    {
+        return ret;
+    }
+
+    gpio_init_callback(&imu_int1_cb, imu_int1_isr, BIT(imu_int1.pin));
+    ret = gpio_add_callback_dt(&imu_int1, &imu_int1_cb);
+    if (ret)
+    {
+        return ret;
+    }
+
+    ret = lsm6dso_i2c_reg_write_byte(i2c_dev, LSM6DSO_REG_INT1_CTRL,
+                                     IS_ENABLED(CONFIG_APP_IMU_FIFO) ? LSM6DSO_INT1_FIFO_TH : LSM6DSO_INT1_DRDY_XL);
+    if (ret)
+    {
+        LOG_ERR("Failed to set INT1_CTRL register (err: %d)", ret);
+        return ret;
+    }
+
+    ret = gpio_pin_interrupt_configure_dt(&imu_int1, GPIO_INT_EDGE_TO_ACTIVE);
+    if (ret)
+    {
+        return ret;
+    }
+
+    k_sem_give(&imu_data_sem);
+    return 0;
+}
+#else
+/*
+Function : imu_poll_expiry
+
+Description :
+    Poll tick used when the board does not wire the IMU INT1 line. Wakes
+    the IMU thread to read a sample, or in FIFO mode to drain the FIFO
+    about once per watermark period.
+
+Parameter :
+    timer : Pointer to the poll timer (unused)
+
+Return :
+    void
+
+Example Call :
+    invoked by k_timer every IMU_POLL_PERIOD_MS
+*/
+static void imu_poll_expiry(struct k_timer *timer)
+{
+    ARG_UNUSED(timer);
+
+    k_sem_give(&imu_data_sem);
+}
+
+/*
+Function : imu_sample_signal_start
+
+Description :
+    Starts the periodic poll tick standing in for the data-ready interrupt.
+
+Parameter :
+    void
+
+Return :
+    int : 0 always
+
+Example Call :
+    int ret = imu_sample_signal_start();
+*/
+static int imu_sample_signal_start(void)
+{
+    k_timer_start(&imu_poll_timer, K_MSEC(IMU_POLL_PERIOD_MS), K_MSEC(IMU_POLL_PERIOD_MS));
+    return 0;
+}
+#endif
+
 /*
 Function : imu_lsm6dso_init
 
 Description :
-    Probes the LSM6DSO by reading WHO_AM_I and configures basic ODR/range
-    for accelerometer and gyroscope (12.5 Hz, ±2g and 250 dps).
+    Probes the LSM6DSO by reading WHO_AM_I, configures basic ODR/range
+    for accelerometer and gyroscope (12.5 Hz, or 104 Hz batched in the
+    FIFO in FIFO mode; ±2g and 250 dps), then starts the acquisition
+    thread and the INT1 interrupt (or poll tick) that wakes it. On a
+    resume from system-off the wake context says whether the sensor was
+    already probed and whether wake-on-motion was left set up, and those
+    steps are skipped when they are not needed.
 
 Parameter :
     void
@@ -304,6 +1119,7 @@ Example Call :
 */
 int imu_lsm6dso_init(void)
 {
+    struct wake_ctx *ctx = wake_ctx_get();
     uint8_t who_am_i = 0;
     int ret;
 
@@ -314,70 +1130,264 @@ int imu_lsm6dso_init(void)
     }
     LOG_INF("I2C device %s is ready.", i2c_dev->name);
 
-    // Verify device ID
-    ret = lsm6dso_i2c_reg_read_byte(i2c_dev, LSM6DSO_REG_WHO_AM_I, &who_am_i);
-    if (ret != 0)
+    // Verify device ID; the sensor stays powered through system-off, so a resume skips it
+    if (!wake_ctx_resumed() || !(ctx->imu_flags & WAKE_IMU_PRESENT))
     {
-        LOG_ERR("Failed to read WHO_AM_I register (err: %d)", ret);
-        return ret;
+        ret = lsm6dso_i2c_reg_read_byte(i2c_dev, LSM6DSO_REG_WHO_AM_I, &who_am_i);
+        if (ret != 0)
+        {
+            LOG_ERR("Failed to read WHO_AM_I register (err: %d)", ret);
+            return ret;
+        }
+        if (who_am_i != LSM6DSO_WHO_AM_I_VAL)
+        {
+            LOG_ERR("Invalid WHO_AM_I: 0x%02x, expected 0x%02x", who_am_i, LSM6DSO_WHO_AM_I_VAL);
+            return -ENODEV;
+        }
+        LOG_INF("LSM6DSO WHO_AM_I check passed. ID: 0x%02x", who_am_i);
+        ctx->imu_flags |= WAKE_IMU_PRESENT;
     }
-    if (who_am_i != LSM6DSO_WHO_AM_I_VAL)
+
+    // Undo a wake-on-motion setup, unless the context says none was left
+    imu_wake_armed = false;
+    if (!wake_ctx_resumed() || (ctx->imu_flags & WAKE_IMU_ARMED))
     {
-        LOG_ERR("Invalid WHO_AM_I: 0x%02x, expected 0x%02x", who_am_i, LSM6DSO_WHO_AM_I_VAL);
-        return -ENODEV;
+        ret = lsm6dso_wake_disarm(i2c_dev);
+        if (ret != 0)
+        {
+            LOG_ERR("Failed to clear wake-on-motion setup (err: %d)", ret);
+            return ret;
+        }
+        ctx->imu_flags &= ~WAKE_IMU_ARMED;
+    }
+
+#if CONFIG_APP_IMU_FIFO
+    ret = lsm6dso_fifo_config(i2c_dev);
+    if (ret != 0)
+    {
+        return ret;
     }
-    LOG_INF("LSM6DSO WHO_AM_I check passed. ID: 0x%02x", who_am_i);
+#endif
 
-    // Set accelerometer ODR (12.5 Hz) and 2g range (0x20)
-    ret = lsm6dso_i2c_reg_write_byte(i2c_dev, LSM6DSO_REG_CTRL1_XL, 0x20);
+    // Set accelerometer ODR and 2g range
+    ret = lsm6dso_i2c_reg_write_byte(i2c_dev, LSM6DSO_REG_CTRL1_XL, IMU_ODR_CODE << 4);
     if (ret != 0)
     {
         LOG_ERR("Failed to set CTRL1_XL register (err: %d)", ret);
         return ret;
     }
 
-    // Set gyroscope ODR (12.5 Hz) and 250dps range (0x20)
-    ret = lsm6dso_i2c_reg_write_byte(i2c_dev, LSM6DSO_REG_CTRL2_G, 0x20);
+    // Set gyroscope ODR and 250dps range
+    ret = lsm6dso_i2c_reg_write_byte(i2c_dev, LSM6DSO_REG_CTRL2_G, IMU_ODR_CODE << 4);
     if (ret != 0)
     {
         LOG_ERR("Failed to set CTRL2_G register (err: %d)", ret);
         return ret;
     }
 
-    LOG_INF("LSM6DSO initialized successfully.");
+    if (!imu_thread_tid)
+    {
+        imu_thread_tid = k_thread_create(&imu_thread_data, imu_thread_stack,
+                                         K_THREAD_STACK_SIZEOF(imu_thread_stack), imu_thread_fn,
+                                         NULL, NULL, NULL, IMU_THREAD_PRIO, 0, K_NO_WAIT);
+        k_thread_name_set(imu_thread_tid, "imu_thread");
+        power_hook_register(&imu_power_hook);
+    }
+    imu_power_down = false;
+    energy_state_set(ENERGY_STATE_IMU, true);
+
+    ret = imu_sample_signal_start();
+    if (ret != 0)
+    {
+        LOG_ERR("Failed to start IMU data-ready signal (err: %d)", ret);
+        return ret;
+    }
+
+    LOG_INF("LSM6DSO initialized successfully (%s%s).", IS_ENABLED(CONFIG_APP_IMU_FIFO) ? "FIFO, " : "",
+            IMU_HAS_INT1 ? "INT1" : "polled");
     return 0;
 }
 
 /*
-Function : imu_readDisplay_raw_data
+Function : imu_tier_enter
 
 Description :
-    Reads raw accelerometer and gyroscope data from the LSM6DSO and logs it.
-    This function is intended to be called periodically from a dedicated
-    thread to demonstrate sensor operation.
+    Power tier entry hook. Connected-sleep gates the IMU: the gyroscope
+    stops and the accelerometer is left in its wake-on-motion state, or
+    the sensor is powered down where wake-on-motion is not available.
+    System-off keeps that state.
 
 Parameter :
+    tier : Tier being entered
+
+Return :
     void
 
+Example Call :
+    registered with power_hook_register()
+*/
+static void imu_tier_enter(enum power_tier tier)
+{
+    int err = -ENOTSUP;
+
+    if (tier != POWER_TIER_CONN_SLEEP)
+    {
+        return;
+    }
+
+    if (IMU_WAKE_ON_MOTION)
+    {
+        err = imu_wake_on_motion_arm();
+        if (err)
+        {
+            LOG_ERR("Failed to arm LSM6DSO wake-on-motion (err: %d)", err);
+        }
+        else
+        {
+            LOG_INF("LSM6DSO armed for wake-on-motion");
+        }
+    }
+    if (err)
+    {
+        err = lsm6dso_accel_gyro_power_down();
+        if (err)
+        {
+            LOG_ERR("Failed to power down LSM6DSO (err: %d)", err);
+        }
+        LOG_INF("LSM6DSO powered down");
+    }
+}
+
+/*
+Function : imu_tier_exit
+
+Description :
+    Power tier exit hook. Leaving connected-sleep configures the sensor
+    again and resumes acquisition.
+
+Parameter :
+    tier : Tier being left
+
 Return :
     void
 
 Example Call :
-    imu_readDisplay_raw_data();
+    registered with power_hook_register()
 */
-void imu_readDisplay_raw_data(void)
+static void imu_tier_exit(enum power_tier tier)
 {
+    int err;
 
-    struct lsm6dso_raw_data sensor_data;
+    if (tier != POWER_TIER_CONN_SLEEP)
+    {
+        return;
+    }
 
-    // Fetch raw data
-    if (lsm6dso_fetch_raw_data(i2c_dev, &sensor_data) == 0)
+    err = imu_lsm6dso_init();
+    if (err)
     {
-        // Display raw data
-        lsm6dso_display_raw_data(&sensor_data);
+        LOG_ERR("Failed to resume LSM6DSO (err: %d)", err);
     }
-    else
+}
+
+/*
+Function : imu_thread_fn
+
+Description :
+    IMU acquisition thread. Sleeps until INT1 (or the poll tick) fires,
+    then drains the FIFO, or reads one sample, and publishes the block.
+    The I2C transfers run on the TWIM's EasyDMA while this thread is
+    pended, so the CPU can sleep and no other thread ever waits on the
+    bus.
+
+Parameter :
+    p1, p2, p3 : Unused thread arguments
+
+Return :
+    void
+
+Example Call :
+    started by imu_lsm6dso_init()
+*/
+static void imu_thread_fn(void *p1, void *p2, void *p3)
+{
+    ARG_UNUSED(p1);
+    ARG_UNUSED(p2);
+    ARG_UNUSED(p3);
+
+    for (;;)
     {
-        LOG_ERR("Failed to fetch data.");
+        k_sem_take(&imu_data_sem, K_FOREVER);
+
+        if (imu_power_down)
+        {
+            continue;
+        }
+
+#if CONFIG_APP_IMU_FIFO
+        int ret = imu_fifo_drain();
+
+        if (ret < 0)
+        {
+            LOG_ERR("Failed to drain FIFO (err: %d).", ret);
+        }
+#else
+        struct lsm6dso_raw_data sensor_data;
+
+        // Fetch raw data (also clears the latched DRDY)
+        if (lsm6dso_fetch_raw_data(i2c_dev, &sensor_data) == 0)
+        {
+            imu_sample_push(&sensor_data);
+        }
+        else
+        {
+            LOG_ERR("Failed to fetch data.");
+        }
+#endif
+        imu_block_publish();
+#if CONFIG_APP_AIR_MOUSE
+        motion_flush();
+#endif
     }
-}
\ No newline at end of file
+}
+
+/*
+Function : imu_block_get
+
+Description :
+    Takes the oldest published sample block. The block stays owned by the
+    caller until it is handed back with imu_block_release().
+
+Parameter :
+    timeout : Maximum time to wait for a block
+
+Return :
+    struct imu_block * : Sample block, or NULL on timeout
+
+Example Call :
+    struct imu_block *blk = imu_block_get(K_FOREVER);
+*/
+struct imu_block *imu_block_get(k_timeout_t timeout)
+{
+    return k_fifo_get(&imu_block_fifo, timeout);
+}
+
+/*
+Function : imu_block_release
+
+Description :
+    Returns a block obtained from imu_block_get() to the pool.
+
+Parameter :
+    block : Block to release
+
+Return :
+    void
+
+Example Call :
+    imu_block_release(blk);
+*/
+void imu_block_release(struct imu_block *block)
+{
+    k_mem_slab_free(&imu_block_slab, block);
+}
@@ -3,8 +3,15 @@ Name : app_imu
 
 Description : 
     LSM6DSO IMU interface for Zephyr RTOS over I2C. This module initializes
-    the sensor, periodically reads raw accelerometer/gyroscope samples in a
-    dedicated thread, and logs the raw LSB values for debugging/bring-up.
+    the sensor and runs a dedicated acquisition thread, woken by the INT1
+    interrupt (or a poll tick on boards without the INT1 line wired). In
+    FIFO mode the sensor batches accel/gyro samples in its on-chip FIFO and
+    raises INT1 at a watermark; the thread drains the whole FIFO in burst
+    reads. Samples are packed into blocks from a fixed pool and handed to
+    the consumer without copying; the raw LSB values are logged once per
+    second for debugging/bring-up. Before system-off the accelerometer can be
+    left in ultra-low-power mode with its wake-up interrupt on INT1, so that
+    picking the device up wakes the SoC.
 
 Date : 2025-09-14
 
@@ -15,11 +22,53 @@ Developer : Engineer Akbar Shah
 #define APP_IMU_H
 
 #include <stdbool.h>
+#include <stdint.h>
+#include <errno.h>
+#include <zephyr/kernel.h>
+#include <zephyr/devicetree.h>
+
+#define IMU_BLOCK_SAMPLES 32 /* samples per handoff block */
+
+/* One raw accelerometer + gyroscope sample, LSB units */
+struct lsm6dso_raw_data
+{
+    int16_t accel_x;
+    int16_t accel_y;
+    int16_t accel_z;
+    int16_t gyro_x;
+    int16_t gyro_y;
+    int16_t gyro_z;
+};
+
+/* Block of consecutive samples handed from the IMU thread to the consumer */
+struct imu_block
+{
+    void *fifo_reserved; /* first word reserved for k_fifo */
+    uint32_t timestamp;  /* k_uptime_get_32() when the block was published */
+    uint16_t count;      /* valid entries in samples[] */
+    struct lsm6dso_raw_data samples[IMU_BLOCK_SAMPLES];
+};
 
 extern bool imu_power_down;
 
 int imu_lsm6dso_init(void);
-void imu_readDisplay_raw_data(void);
 int lsm6dso_accel_gyro_power_down(void);
+struct imu_block *imu_block_get(k_timeout_t timeout);
+void imu_block_release(struct imu_block *block);
+
+#if CONFIG_APP_IMU_WAKE_ON_MOTION && DT_NODE_HAS_PROP(DT_PATH(zephyr_user), imu_int1_gpios)
+#define IMU_WAKE_ON_MOTION 1
+int imu_wake_on_motion_arm(void);
+void imu_wake_sense_arm(void);
+#else
+#define IMU_WAKE_ON_MOTION 0
+static inline int imu_wake_on_motion_arm(void)
+{
+    return -ENOTSUP;
+}
+static inline void imu_wake_sense_arm(void)
+{
+}
+#endif
 
 #endif // APP_IMU_H
@@ -4,7 +4,8 @@ Name : app_keycodes
 Description : 
     Defines USB HID keyboard usage codes (Usage Page 0x07) for letters, 
     numbers, control keys, and symbols. Provides named macros for use in 
-    the BLE HID keyboard application to send standard keypress events.
+    the BLE HID keyboard application to send standard keypress events,
+    plus the consumer (0x0C) and system control usages for media keys.
 
 Date : 2025-09-14
 
@@ -223,5 +224,19 @@ Developer : Engineer Akbar Shah
 #define HID_MOD_RALT                 (1u << 6)
 #define HID_MOD_RGUI                 (1u << 7)
 
+/* USB HID Usage Page 0x0C: Consumer (Consumer Control report) */
+#define HID_CONSUMER_SCAN_NEXT       0xB5  /* 181 */
+#define HID_CONSUMER_SCAN_PREVIOUS   0xB6  /* 182 */
+#define HID_CONSUMER_STOP            0xB7  /* 183 */
+#define HID_CONSUMER_PLAY_PAUSE      0xCD  /* 205 */
+#define HID_CONSUMER_MUTE            0xE2  /* 226 */
+#define HID_CONSUMER_VOLUME_UP       0xE9  /* 233 */
+#define HID_CONSUMER_VOLUME_DOWN     0xEA  /* 234 */
+
+/* USB HID Usage Page 0x01: Generic Desktop (System Control report) */
+#define HID_SYSTEM_POWER_DOWN        0x81  /* 129 */
+#define HID_SYSTEM_SLEEP             0x82  /* 130 */
+#define HID_SYSTEM_WAKE_UP           0x83  /* 131 */
+
 
 #endif // APP_KEYCODES_H
@@ -0,0 +1,619 @@
+/*
+Name : app_keymap
+
+Description :
+    Keymap and macro engine. Layers of key actions (plain keys, media and
+    system keys, tap/hold, layer switches, macros) come from the
+    "thanehunt,keymap" devicetree node and are compiled into const tables
+    indexed by key ID; without the node a built-in single layer keeps the
+    previous mapping. The action of
+    a key is resolved when it is pressed, so its release always undoes the
+    same action even if the layer changed in between. Macros are played by
+    a timer-driven sequencer: the timer only wakes the button thread, which
+    runs one step per tick between key events.
+
+Date : 2026-10-14
+
+Developer : Engineer Akbar Shah
+*/
+
+#include <zephyr/kernel.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/util.h>
+#include <dt-bindings/thanehunt/keymap.h>
+
+#include "app_button.h"
+#include "app_hid.h"
+#include "app_keycodes.h"
+#include "app_keymap.h"
+
+LOG_MODULE_REGISTER(APP_KEYMAP);
+
+#define KEYMAP_NODE DT_COMPAT_GET_ANY_STATUS_OKAY(thanehunt_keymap)
+
+#define KM_TYPE(a) ((a) >> 24)
+#define KM_ARG_LO(a) ((uint8_t)((a) & 0xFF))
+#define KM_ARG_HI(a) ((uint8_t)(((a) >> 8) & 0xFF))
+#define KM_ARG16(a) ((uint16_t)((a) & 0xFFFF))
+#define KM_WAIT_MS(s) KM_ARG16(s)
+
+struct keymap_layer
+{
+    const uint32_t *actions; /* one action per key ID */
+    uint16_t count;
+};
+
+struct keymap_macro
+{
+    const uint32_t *steps;
+    uint16_t count;
+};
+
+#if DT_NODE_EXISTS(KEYMAP_NODE)
+#define KEYMAP_TAPPING_TERM_MS DT_PROP(KEYMAP_NODE, tapping_term_ms)
+#define KEYMAP_MACRO_STEP_MS DT_PROP(KEYMAP_NODE, macro_step_ms)
+
+/* const arrays, one per layer / macro child, named by dependency ordinal */
+#define KEYMAP_ARRAY(node, prop)                                         \
+    COND_CODE_1(DT_NODE_HAS_PROP(node, prop),                            \
+                (static const uint32_t _CONCAT(keymap_##prop##_,         \
+                                               DT_DEP_ORD(node))[] =     \
+                     DT_PROP(node, prop);),                              \
+                ())
+#define KEYMAP_LAYER_ARRAY(node) KEYMAP_ARRAY(node, bindings)
+#define KEYMAP_MACRO_ARRAY(node) KEYMAP_ARRAY(node, steps)
+
+#define KEYMAP_ENTRY(node, prop)                                                      \
+    COND_CODE_1(DT_NODE_HAS_PROP(node, prop),                                         \
+                ({_CONCAT(keymap_##prop##_, DT_DEP_ORD(node)), DT_PROP_LEN(node, prop)},), \
+                ())
+#define KEYMAP_LAYER_ENTRY(node) KEYMAP_ENTRY(node, bindings)
+#define KEYMAP_MACRO_ENTRY(node) KEYMAP_ENTRY(node, steps)
+
+/* One member per layer, sized as the layer: the union is as long as the longest */
+#define KEYMAP_LEN(node)                                                            \
+    COND_CODE_1(DT_NODE_HAS_PROP(node, bindings),                                   \
+                (uint8_t _CONCAT(layer_, DT_DEP_ORD(node))[DT_PROP_LEN(node, bindings)];), \
+                ())
+
+DT_FOREACH_CHILD(KEYMAP_NODE, KEYMAP_LAYER_ARRAY)
+DT_FOREACH_CHILD(KEYMAP_NODE, KEYMAP_MACRO_ARRAY)
+
+static const struct keymap_layer keymap_layers[] = {
+    DT_FOREACH_CHILD(KEYMAP_NODE, KEYMAP_LAYER_ENTRY)};
+static const struct keymap_macro keymap_macros[] = {
+    DT_FOREACH_CHILD(KEYMAP_NODE, KEYMAP_MACRO_ENTRY){NULL, 0}};
+
+union keymap_layer_len
+{
+    uint8_t none;
+    DT_FOREACH_CHILD(KEYMAP_NODE, KEYMAP_LEN)
+};
+
+/* Upper bound of the key IDs any layer maps: the longest layer */
+#define KEYMAP_KEYS sizeof(union keymap_layer_len)
+#define KEYMAP_MACRO_COUNT (ARRAY_SIZE(keymap_macros) - 1)
+#else
+#define KEYMAP_TAPPING_TERM_MS 200
+#define KEYMAP_MACRO_STEP_MS 10
+
+/* No keymap node: GPIO key 0 types H, matrix keys A..Z, 1..0 row-major */
+#define KEYMAP_DEFAULT_MATRIX_KEYS 36 /* LISTIFY needs a literal */
+#define KEYMAP_DEFAULT_MATRIX(i, _) KM_KEY(HID_KEY_A + (i))
+
+BUILD_ASSERT(KEYMAP_DEFAULT_MATRIX_KEYS == (HID_KEY_0_PAREN_RIGHT - HID_KEY_A + 1),
+             "Default matrix keys are A..Z, 1..0");
+
+static const uint32_t keymap_default[] = {
+    KM_KEY(HID_KEY_H),
+    LISTIFY(KEYMAP_DEFAULT_MATRIX_KEYS, KEYMAP_DEFAULT_MATRIX, (, )),
+};
+
+static const struct keymap_layer keymap_layers[] = {
+    {keymap_default, ARRAY_SIZE(keymap_default)},
+};
+static const struct keymap_macro keymap_macros[] = {{NULL, 0}};
+
+#define KEYMAP_KEYS ARRAY_SIZE(keymap_default)
+#define KEYMAP_MACRO_COUNT 0
+#endif
+
+#define KEYMAP_LAYERS ARRAY_SIZE(keymap_layers)
+
+BUILD_ASSERT(KEYMAP_LAYERS >= 1 && KEYMAP_LAYERS <= 32, "Keymap needs 1 to 32 layers");
+BUILD_ASSERT(KEYMAP_KEYS <= 256, "Key IDs are 8 bit");
+
+/* Button thread only */
+static uint32_t layer_mask = BIT(0);         /* layer 0 is always active */
+static uint32_t key_action[KEYMAP_KEYS];     /* action resolved at press, KM_NONE if up */
+
+/* Tap/hold key waiting for its tap or hold decision */
+static struct
+{
+    bool active;
+    uint8_t key_id;
+    uint32_t action;
+    uint32_t pressed; /* k_cycle_get_32() of the press */
+} th_pending;
+
+/* Macro sequencer */
+static const struct keymap_macro *macro_cur;
+static uint16_t macro_pos;
+static uint32_t macro_next_ms; /* k_uptime_get_32() of the next step */
+
+static void keymap_timer_expiry(struct k_timer *timer);
+K_TIMER_DEFINE(keymap_timer, keymap_timer_expiry, NULL);
+
+/*
+Function : keymap_timer_expiry
+
+Description :
+    Keymap timer (tapping term, macro step). Only wakes the button thread,
+    which runs keymap_tick() on every wakeup.
+
+Parameter :
+    timer : Pointer to the keymap timer (unused)
+
+Return :
+    void
+
+Example Call :
+    invoked by k_timer
+*/
+static void keymap_timer_expiry(struct k_timer *timer)
+{
+    ARG_UNUSED(timer);
+
+    button_event_signal();
+}
+
+/*
+Function : keymap_timer_arm
+
+Description :
+    Arms the keymap timer for the earliest pending deadline (tapping term
+    of a pending tap/hold key, next macro step), or stops it.
+
+Parameter :
+    None
+
+Return :
+    void
+
+Example Call :
+    keymap_timer_arm();
+*/
+static void keymap_timer_arm(void)
+{
+    uint32_t now = k_uptime_get_32();
+    int32_t wait = INT32_MAX;
+
+    if (th_pending.active)
+    {
+        int32_t held = (int32_t)k_cyc_to_ms_floor32(k_cycle_get_32() - th_pending.pressed);
+
+        wait = MAX(KEYMAP_TAPPING_TERM_MS - held, 0);
+    }
+    if (macro_cur)
+    {
+        wait = MIN(wait, MAX((int32_t)(macro_next_ms - now), 0));
+    }
+
+    if (wait == INT32_MAX)
+    {
+        k_timer_stop(&keymap_timer);
+    }
+    else
+    {
+        k_timer_start(&keymap_timer, K_MSEC(wait), K_NO_WAIT);
+    }
+}
+
+/*
+Function : keymap_resolve
+
+Description :
+    Looks a key up in the active layers, highest first, skipping
+    transparent entries. One table index per active layer.
+
+Parameter :
+    key_id : Key ID carried in the key_event
+
+Return :
+    uint32_t : Key action, KM_NONE if no active layer maps the key
+
+Example Call :
+    uint32_t action = keymap_resolve(ev->key_id);
+*/
+static uint32_t keymap_resolve(uint8_t key_id)
+{
+    for (int l = KEYMAP_LAYERS - 1; l >= 0; l--)
+    {
+        const struct keymap_layer *layer = &keymap_layers[l];
+        uint32_t action;
+
+        if (!(layer_mask & BIT(l)) || key_id >= layer->count)
+        {
+            continue;
+        }
+        action = layer->actions[key_id];
+        if (action != KM_TRANS)
+        {
+            return action;
+        }
+    }
+    return KM_NONE;
+}
+
+/*
+Function : keymap_usage_set
+
+Description :
+    Presses or releases one HID usage.
+
+Parameter :
+    usage : HID usage (HID_KEY_*)
+    down  : true to press, false to release
+
+Return :
+    void
+
+Example Call :
+    keymap_usage_set(HID_KEY_A, true);
+*/
+static void keymap_usage_set(uint8_t usage, bool down)
+{
+    if (usage == HID_KEY_NONE)
+    {
+        return;
+    }
+    LOG_DBG("HID key 0x%02X %s", usage, down ? "down" : "up");
+    if (down)
+    {
+        (void)hid_buttons_press(&usage, 1);
+    }
+    else
+    {
+        (void)hid_buttons_release(&usage, 1);
+    }
+}
+
+/*
+Function : keymap_layer_set
+
+Description :
+    Turns a layer on or off. Layer 0 stays on.
+
+Parameter :
+    layer : Layer index
+    on    : true to activate
+
+Return :
+    void
+
+Example Call :
+    keymap_layer_set(1, true);
+*/
+static void keymap_layer_set(uint8_t layer, bool on)
+{
+    if (layer == 0 || layer >= KEYMAP_LAYERS)
+    {
+        return;
+    }
+    if (on)
+    {
+        layer_mask |= BIT(layer);
+    }
+    else
+    {
+        layer_mask &= ~BIT(layer);
+    }
+}
+
+/*
+Function : keymap_hold_set
+
+Description :
+    Starts or ends the hold side of a tap/hold action: the hold usage for
+    KM_TAP_HOLD, the layer for KM_LAYER_TAP.
+
+Parameter :
+    action : KM_TAP_HOLD or KM_LAYER_TAP action
+    on     : true when the hold starts, false on release
+
+Return :
+    void
+
+Example Call :
+    keymap_hold_set(th_pending.action, true);
+*/
+static void keymap_hold_set(uint32_t action, bool on)
+{
+    if (KM_TYPE(action) == KM_TYPE_TAP_HOLD)
+    {
+        keymap_usage_set(KM_ARG_HI(action), on);
+    }
+    else
+    {
+        keymap_layer_set(KM_ARG_HI(action), on);
+    }
+}
+
+/*
+Function : keymap_hold_resolve
+
+Description :
+    Decides the pending tap/hold key as a hold: its tapping term ran out
+    or another key was pressed while it was held.
+
+Parameter :
+    None
+
+Return :
+    void
+
+Example Call :
+    keymap_hold_resolve();
+*/
+static void keymap_hold_resolve(void)
+{
+    th_pending.active = false;
+    keymap_hold_set(th_pending.action, true);
+}
+
+/*
+Function : keymap_macro_start
+
+Description :
+    Starts playing a macro. One macro plays at a time; a macro key
+    pressed while another macro plays is ignored.
+
+Parameter :
+    idx : Macro index (child order in the keymap node)
+
+Return :
+    void
+
+Example Call :
+    keymap_macro_start(0);
+*/
+static void keymap_macro_start(uint8_t idx)
+{
+    if (idx >= KEYMAP_MACRO_COUNT || macro_cur)
+    {
+        LOG_DBG("Macro %u not started", idx);
+        return;
+    }
+    macro_cur = &keymap_macros[idx];
+    macro_pos = 0;
+    macro_next_ms = k_uptime_get_32();
+}
+
+/*
+Function : keymap_macro_step
+
+Description :
+    Plays the next macro step if it is due. Press, release and tap steps
+    are followed by the macro step delay, wait steps by their own delay.
+
+Parameter :
+    None
+
+Return :
+    void
+
+Example Call :
+    keymap_macro_step();
+*/
+static void keymap_macro_step(void)
+{
+    uint32_t now = k_uptime_get_32();
+    uint32_t step;
+    uint32_t delay = KEYMAP_MACRO_STEP_MS;
+
+    if (!macro_cur || (int32_t)(macro_next_ms - now) > 0)
+    {
+        return;
+    }
+
+    step = macro_cur->steps[macro_pos++];
+    switch (KM_TYPE(step))
+    {
+    case KM_STEP_PRESS_T:
+        keymap_usage_set(KM_ARG_LO(step), true);
+        break;
+    case KM_STEP_RELEASE_T:
+        keymap_usage_set(KM_ARG_LO(step), false);
+        break;
+    case KM_STEP_TAP_T:
+        keymap_tap(KM_ARG_LO(step));
+        break;
+    case KM_STEP_WAIT_T:
+        delay = KM_WAIT_MS(step);
+        break;
+    default:
+        break;
+    }
+
+    if (macro_pos >= macro_cur->count)
+    {
+        macro_cur = NULL;
+        return;
+    }
+    macro_next_ms = now + delay;
+}
+
+/*
+Function : keymap_key_event
+
+Description :
+    Runs one debounced key change through the keymap. A press resolves the
+    key's action in the active layers and a pending tap/hold key becomes
+    a hold; a release undoes the action resolved at press time. Called
+    from the button thread only.
+
+Parameter :
+    key_id    : Key ID carried in the key_event
+    pressed   : true for press, false for release
+    timestamp : k_cycle_get_32() when the change was accepted
+
+Return :
+    bool : true if a key report was issued for this event
+
+Example Call :
+    if (!keymap_key_event(ev->key_id, ev->pressed, ev->timestamp)) { ... }
+*/
+bool keymap_key_event(uint8_t key_id, bool pressed, uint32_t timestamp)
+{
+    bool sent = false;
+    uint32_t action;
+
+    if (key_id >= KEYMAP_KEYS)
+    {
+        return false;
+    }
+
+    if (pressed)
+    {
+        if (th_pending.active)
+        {
+            keymap_hold_resolve(); /* hold on other key press */
+        }
+
+        action = keymap_resolve(key_id);
+        key_action[key_id] = action;
+
+        switch (KM_TYPE(action))
+        {
+        case KM_TYPE_KEY:
+            keymap_usage_set(KM_ARG_LO(action), true);
+            sent = true;
+            break;
+        case KM_TYPE_TAP_HOLD:
+        case KM_TYPE_LAYER_TAP:
+            th_pending.active = true;
+            th_pending.key_id = key_id;
+            th_pending.action = action;
+            th_pending.pressed = timestamp;
+            break;
+        case KM_TYPE_MO:
+            keymap_layer_set(KM_ARG_LO(action), true);
+            break;
+        case KM_TYPE_MACRO:
+            keymap_macro_start(KM_ARG_LO(action));
+            keymap_macro_step();
+            break;
+#if CONFIG_APP_HID_CONSUMER
+        case KM_TYPE_CONSUMER:
+            sent = (hid_consumer_press(KM_ARG16(action)) == 0);
+            break;
+        case KM_TYPE_SYSTEM:
+            sent = (hid_system_press(KM_ARG_LO(action)) == 0);
+            break;
+#endif
+        default:
+            break;
+        }
+    }
+    else
+    {
+        action = key_action[key_id];
+        key_action[key_id] = KM_NONE;
+
+        switch (KM_TYPE(action))
+        {
+        case KM_TYPE_KEY:
+            keymap_usage_set(KM_ARG_LO(action), false);
+            sent = true;
+            break;
+        case KM_TYPE_TAP_HOLD:
+        case KM_TYPE_LAYER_TAP:
+            if (th_pending.active && th_pending.key_id == key_id)
+            {
+                th_pending.active = false;
+                if (k_cyc_to_ms_floor32(timestamp - th_pending.pressed) < KEYMAP_TAPPING_TERM_MS)
+                {
+                    keymap_tap(KM_ARG_LO(action));
+                    sent = true;
+                    break;
+                }
+                keymap_hold_set(action, true); /* term ran out before the tick */
+            }
+            keymap_hold_set(action, false);
+            break;
+        case KM_TYPE_MO:
+            keymap_layer_set(KM_ARG_LO(action), false);
+            break;
+#if CONFIG_APP_HID_CONSUMER
+        case KM_TYPE_CONSUMER:
+            sent = (hid_consumer_release(KM_ARG16(action)) == 0);
+            break;
+        case KM_TYPE_SYSTEM:
+            sent = (hid_system_release(KM_ARG_LO(action)) == 0);
+            break;
+#endif
+        default:
+            break;
+        }
+    }
+
+    keymap_timer_arm();
+    return sent;
+}
+
+/*
+Function : keymap_tick
+
+Description :
+    Runs the keymap deadlines: turns a pending tap/hold key into a hold
+    once its tapping term ran out and plays a due macro step. Called by
+    the button thread on every wakeup; cheap when nothing is pending.
+
+Parameter :
+    None
+
+Return :
+    void
+
+Example Call :
+    keymap_tick();
+*/
+void keymap_tick(void)
+{
+    if (!th_pending.active && !macro_cur)
+    {
+        return;
+    }
+
+    if (th_pending.active &&
+        k_cyc_to_ms_floor32(k_cycle_get_32() - th_pending.pressed) >= KEYMAP_TAPPING_TERM_MS)
+    {
+        keymap_hold_resolve();
+    }
+    keymap_macro_step();
+    keymap_timer_arm();
+}
+
+/*
+Function : keymap_tap
+
+Description :
+    Taps one HID usage: press and release back to back. The HID report
+    path keeps the order, so the host always sees both reports and no
+    delay is needed.
+
+Parameter :
+    usage : HID usage (HID_KEY_*)
+
+Return :
+    void
+
+Example Call :
+    keymap_tap(HID_KEY_SPACE);
+*/
+void keymap_tap(uint8_t usage)
+{
+    keymap_usage_set(usage, true);
+    keymap_usage_set(usage, false);
+}
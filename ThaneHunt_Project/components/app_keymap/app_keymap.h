@@ -0,0 +1,26 @@
+/*
+Name : app_keymap
+
+Description :
+    Keymap and macro engine. Layers of key actions (plain keys, tap/hold,
+    layer switches, macros) come from the "thanehunt,keymap" devicetree
+    node and are compiled into const tables indexed by key ID. Macros are
+    played by a timer-driven sequencer in the button thread, so they never
+    sleep and never hold up other keys.
+
+Date : 2026-10-14
+
+Developer : Engineer Akbar Shah
+*/
+
+#ifndef APP_KEYMAP_H
+#define APP_KEYMAP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+bool keymap_key_event(uint8_t key_id, bool pressed, uint32_t timestamp);
+void keymap_tick(void);
+void keymap_tap(uint8_t usage);
+
+#endif // APP_KEYMAP_H
@@ -0,0 +1,354 @@
+/*
+Name : app_latency
+
+Description :
+    Key-event latency tracing for the BLE HID keyboard. Each keystroke is
+    stamped with the system cycle counter at every stage of its journey
+    (GPIO edge, debounce, button thread, HID report, notification sent) and
+    the completed traces are kept in a ring buffer. Per-stage min/avg/p99/max
+    statistics and a log2 histogram can be read back over the shell.
+
+Date : 2026-10-14
+
+Developer : Engineer Akbar Shah
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/util.h>
+
+#if CONFIG_APP_LATENCY_TRACE_SHELL
+#include <zephyr/shell/shell.h>
+#endif
+
+#include "app_latency.h"
+
+LOG_MODULE_REGISTER(APP_LATENCY);
+
+#define LATENCY_TRACE_DEPTH CONFIG_APP_LATENCY_TRACE_DEPTH
+#define LATENCY_STALE_MS 1000 /* a trace not completed within 1 s is dropped */
+
+/*
+ * The system cycle counter (GRTC on nRF54L) keeps running while the CPU
+ * sleeps between stages, unlike the DWT cycle counter which halts in WFI,
+ * so it is the one used for stamping.
+ */
+struct latency_trace
+{
+    uint32_t stamp[LATENCY_STAGE_COUNT];
+    uint8_t mask; /* BIT(stage) set once the stage has been stamped */
+};
+
+static struct k_spinlock trace_lock;
+static struct latency_trace current;
+static bool trace_active;
+
+/* Completed traces, in microseconds per segment */
+static uint32_t trace_ring[LATENCY_TRACE_DEPTH][LATENCY_SEG_COUNT];
+static uint32_t ring_head;
+static uint32_t ring_count;
+
+/* Scratch buffer used to sort one segment column for the percentile */
+static uint32_t sort_scratch[LATENCY_TRACE_DEPTH];
+static K_MUTEX_DEFINE(stats_mutex);
+
+/*
+Function : trace_commit
+
+Description :
+    Converts the stage stamps of the current trace into per-segment
+    microsecond durations and stores them in the ring buffer, overwriting
+    the oldest entry when the ring is full. Caller must hold trace_lock.
+
+Parameter :
+    None
+
+Return :
+    void
+
+Example Call :
+    trace_commit();
+*/
+static void trace_commit(void)
+{
+    uint32_t *slot = trace_ring[ring_head];
+
+    for (size_t seg = 0; seg < LATENCY_SEG_TOTAL; seg++)
+    {
+        slot[seg] = k_cyc_to_us_floor32(current.stamp[seg + 1] - current.stamp[seg]);
+    }
+    slot[LATENCY_SEG_TOTAL] = k_cyc_to_us_floor32(current.stamp[LATENCY_STAGE_SENT] -
+                                                  current.stamp[LATENCY_STAGE_EDGE]);
+
+    ring_head = (ring_head + 1) % LATENCY_TRACE_DEPTH;
+    if (ring_count < LATENCY_TRACE_DEPTH)
+    {
+        ring_count++;
+    }
+}
+
+/*
+Function : latency_trace_stamp
+
+Description :
+    Records the current cycle counter for the given stage. An EDGE stamp
+    opens a new trace unless one is already in flight (contact bounce keeps
+    the first edge). Every other stage is only accepted once the previous
+    stage has been stamped, so a trace is always in order. The SENT stage
+    closes the trace and commits it to the ring. Safe from ISR context.
+
+Parameter :
+    stage : Stage of the key event path that has just been reached
+
+Return :
+    void
+
+Example Call :
+    latency_trace_stamp(LATENCY_STAGE_EDGE);
+*/
+void latency_trace_stamp(enum latency_stage stage)
+{
+    uint32_t now = k_cycle_get_32();
+    k_spinlock_key_t key = k_spin_lock(&trace_lock);
+
+    if (stage == LATENCY_STAGE_EDGE)
+    {
+        if (!trace_active ||
+            (now - current.stamp[LATENCY_STAGE_EDGE]) > k_ms_to_cyc_ceil32(LATENCY_STALE_MS))
+        {
+            current.stamp[LATENCY_STAGE_EDGE] = now;
+            current.mask = BIT(LATENCY_STAGE_EDGE);
+            trace_active = true;
+        }
+    }
+    else if (trace_active && (stage < LATENCY_STAGE_COUNT) &&
+             !(current.mask & BIT(stage)) && (current.mask & BIT(stage - 1)))
+    {
+        current.stamp[stage] = now;
+        current.mask |= BIT(stage);
+
+        if (stage == LATENCY_STAGE_SENT)
+        {
+            trace_commit();
+            trace_active = false;
+        }
+    }
+
+    k_spin_unlock(&trace_lock, key);
+}
+
+/*
+Function : latency_trace_abort
+
+Description :
+    Drops the trace currently in flight, e.g. when the event is discarded
+    because no host is connected or the report could not be sent.
+
+Parameter :
+    None
+
+Return :
+    void
+
+Example Call :
+    latency_trace_abort();
+*/
+void latency_trace_abort(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&trace_lock);
+
+    trace_active = false;
+    k_spin_unlock(&trace_lock, key);
+}
+
+/*
+Function : latency_trace_reset
+
+Description :
+    Clears the ring buffer of completed traces and any trace in flight.
+
+Parameter :
+    None
+
+Return :
+    void
+
+Example Call :
+    latency_trace_reset();
+*/
+void latency_trace_reset(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&trace_lock);
+
+    trace_active = false;
+    ring_head = 0;
+    ring_count = 0;
+    k_spin_unlock(&trace_lock, key);
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t va = *(const uint32_t *)a;
+    uint32_t vb = *(const uint32_t *)b;
+
+    return (va > vb) - (va < vb);
+}
+
+/*
+Function : latency_trace_stats_get
+
+Description :
+    Computes min/avg/p99/max and a log2(us) histogram for one segment over
+    all traces currently held in the ring buffer.
+
+Parameter :
+    seg : Segment to evaluate
+    out : Output statistics
+
+Return :
+    int : 0 on success, -EINVAL on bad segment, -ENODATA if no trace yet
+
+Example Call :
+    struct latency_stats st;
+    int err = latency_trace_stats_get(LATENCY_SEG_TOTAL, &st);
+*/
+int latency_trace_stats_get(enum latency_segment seg, struct latency_stats *out)
+{
+    uint64_t sum = 0;
+    uint32_t count;
+
+    if (seg >= LATENCY_SEG_COUNT || out == NULL)
+    {
+        return -EINVAL;
+    }
+
+    k_mutex_lock(&stats_mutex, K_FOREVER);
+
+    k_spinlock_key_t key = k_spin_lock(&trace_lock);
+
+    count = ring_count;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        sort_scratch[i] = trace_ring[i][seg];
+    }
+    k_spin_unlock(&trace_lock, key);
+
+    memset(out, 0, sizeof(*out));
+    if (count == 0)
+    {
+        k_mutex_unlock(&stats_mutex);
+        return -ENODATA;
+    }
+
+    qsort(sort_scratch, count, sizeof(sort_scratch[0]), cmp_u32);
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t v = sort_scratch[i];
+        uint32_t bucket = (v == 0) ? 0 : MIN(LOG2(v) + 1, LATENCY_HIST_BUCKETS - 1);
+
+        out->hist[bucket]++;
+        sum += v;
+    }
+
+    out->count = count;
+    out->min_us = sort_scratch[0];
+    out->max_us = sort_scratch[count - 1];
+    out->avg_us = (uint32_t)(sum / count);
+    out->p99_us = sort_scratch[((count * 99U) + 99U) / 100U - 1U];
+
+    k_mutex_unlock(&stats_mutex);
+    return 0;
+}
+
+#if CONFIG_APP_LATENCY_TRACE_SHELL
+static const char *const seg_names[LATENCY_SEG_COUNT] = {
+    [LATENCY_SEG_DEBOUNCE] = "edge->debounced",
+    [LATENCY_SEG_QUEUE] = "debounced->thread",
+    [LATENCY_SEG_HID] = "thread->report",
+    [LATENCY_SEG_RADIO] = "report->sent",
+    [LATENCY_SEG_TOTAL] = "total",
+};
+
+static int cmd_latency_stats(const struct shell *sh, size_t argc, char **argv)
+{
+    struct latency_stats st;
+
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    shell_print(sh, "%-18s %6s %8s %8s %8s %8s", "segment", "n",
+                "min_us", "avg_us", "p99_us", "max_us");
+
+    for (size_t seg = 0; seg < LATENCY_SEG_COUNT; seg++)
+    {
+        if (latency_trace_stats_get(seg, &st))
+        {
+            shell_print(sh, "%-18s %6u", seg_names[seg], 0U);
+            continue;
+        }
+        shell_print(sh, "%-18s %6u %8u %8u %8u %8u", seg_names[seg], st.count,
+                    st.min_us, st.avg_us, st.p99_us, st.max_us);
+    }
+    return 0;
+}
+
+static int cmd_latency_hist(const struct shell *sh, size_t argc, char **argv)
+{
+    struct latency_stats st;
+    size_t seg = LATENCY_SEG_TOTAL;
+
+    if (argc > 1)
+    {
+        seg = strtoul(argv[1], NULL, 0);
+    }
+
+    if (latency_trace_stats_get(seg, &st))
+    {
+        shell_print(sh, "no data");
+        return 0;
+    }
+
+    shell_print(sh, "%s (%u traces)", seg_names[seg], st.count);
+    for (size_t b = 0; b < LATENCY_HIST_BUCKETS; b++)
+    {
+        if (st.hist[b] == 0)
+        {
+            continue;
+        }
+        if (b == 0)
+        {
+            shell_print(sh, "  <1 us        : %u", st.hist[b]);
+        }
+        else if (b == LATENCY_HIST_BUCKETS - 1)
+        {
+            shell_print(sh, "  >=%-8u us : %u", (unsigned int)BIT(b - 1), st.hist[b]);
+        }
+        else
+        {
+            shell_print(sh, "  %8u us : %u", (unsigned int)BIT(b - 1), st.hist[b]);
+        }
+    }
+    return 0;
+}
+
+static int cmd_latency_reset(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    latency_trace_reset();
+    shell_print(sh, "latency traces cleared");
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_latency,
+                               SHELL_CMD(stats, NULL, "Per-segment min/avg/p99/max", cmd_latency_stats),
+                               SHELL_CMD(hist, NULL, "log2 histogram [segment 0-4]", cmd_latency_hist),
+                               SHELL_CMD(reset, NULL, "Clear collected traces", cmd_latency_reset),
+                               SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(latency, &sub_latency, "Key-event latency tracing", NULL);
+#endif
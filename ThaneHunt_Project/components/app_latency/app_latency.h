@@ -0,0 +1,66 @@
+/*
+Name : app_latency
+
+Description :
+    Key-event latency tracing for the BLE HID keyboard. Each keystroke is
+    stamped with the system cycle counter at every stage of its journey
+    (GPIO edge, debounce, button thread, HID report, notification sent) and
+    the completed traces are kept in a ring buffer. Per-stage min/avg/p99/max
+    statistics and a log2 histogram can be read back over the shell.
+
+Date : 2026-10-14
+
+Developer : Engineer Akbar Shah
+*/
+
+#ifndef APP_LATENCY_H
+#define APP_LATENCY_H
+
+#include <stdint.h>
+
+/* Stages stamped along the key event path, in order */
+enum latency_stage
+{
+    LATENCY_STAGE_EDGE = 0,  /* button_isr saw the GPIO edge           */
+    LATENCY_STAGE_DEBOUNCED, /* debounced level queued as a key_event  */
+    LATENCY_STAGE_DEQUEUED,  /* button thread took it off the ring     */
+    LATENCY_STAGE_REPORT,    /* hid_buttons_press/release ran          */
+    LATENCY_STAGE_SENT,      /* bt_hids notification completed         */
+    LATENCY_STAGE_COUNT
+};
+
+/* Segments reported by the statistics: one per stage hop plus end-to-end */
+enum latency_segment
+{
+    LATENCY_SEG_DEBOUNCE = 0, /* EDGE      -> DEBOUNCED */
+    LATENCY_SEG_QUEUE,        /* DEBOUNCED -> DEQUEUED  */
+    LATENCY_SEG_HID,          /* DEQUEUED  -> REPORT    */
+    LATENCY_SEG_RADIO,        /* REPORT    -> SENT      */
+    LATENCY_SEG_TOTAL,        /* EDGE      -> SENT      */
+    LATENCY_SEG_COUNT
+};
+
+#define LATENCY_HIST_BUCKETS 21 /* log2(us) buckets, last one is open ended */
+
+struct latency_stats
+{
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t avg_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+    uint32_t hist[LATENCY_HIST_BUCKETS];
+};
+
+#if CONFIG_APP_LATENCY_TRACE
+void latency_trace_stamp(enum latency_stage stage);
+void latency_trace_abort(void);
+void latency_trace_reset(void);
+int latency_trace_stats_get(enum latency_segment seg, struct latency_stats *out);
+#else
+static inline void latency_trace_stamp(enum latency_stage stage) { (void)stage; }
+static inline void latency_trace_abort(void) {}
+static inline void latency_trace_reset(void) {}
+#endif
+
+#endif // APP_LATENCY_H
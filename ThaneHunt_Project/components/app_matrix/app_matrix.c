@@ -0,0 +1,437 @@
+/*
+Name : app_matrix
+
+Description :
+    Keyboard matrix scanner for boards with more keys than GPIOs. Rows and
+    columns come from the "kbd_matrix" devicetree node. While every key is
+    released the matrix sleeps with all columns driven and the rows armed as
+    GPIO interrupts; a press starts periodic scanning, which stops again
+    once every key is released. Debounced key changes are pushed as
+    {key_id, state, timestamp} events through a lock-free SPSC ring to the
+    button consumer thread.
+
+Date : 2026-10-14
+
+Developer : Engineer Akbar Shah
+*/
+
+#include <zephyr/kernel.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/sys/spsc_lockfree.h>
+#include <zephyr/logging/log.h>
+
+#include "app_button.h"
+#include "app_latency.h"
+#include "app_matrix.h"
+
+LOG_MODULE_REGISTER(APP_MATRIX);
+
+#define MATRIX_POLL_MS DT_PROP_OR(KBD_MATRIX_NODE, poll_period_ms, 5)
+#define MATRIX_SETTLE_US DT_PROP_OR(KBD_MATRIX_NODE, settle_time_us, 5)
+#define MATRIX_DEBOUNCE_MS CONFIG_APP_BUTTON_DEBOUNCE_MS
+#define MATRIX_EVENT_RING_SIZE 32 /* must be a power of two */
+
+BUILD_ASSERT(KBD_MATRIX_KEY_COUNT <= 255, "Key IDs are 8 bit");
+
+#define MATRIX_GPIO_SPEC(node, prop, idx) GPIO_DT_SPEC_GET_BY_IDX(node, prop, idx),
+
+/* Rows are inputs (active = key closed), columns are driven one at a time */
+static const struct gpio_dt_spec rows[] = {
+    DT_FOREACH_PROP_ELEM(KBD_MATRIX_NODE, row_gpios, MATRIX_GPIO_SPEC)};
+static const struct gpio_dt_spec cols[] = {
+    DT_FOREACH_PROP_ELEM(KBD_MATRIX_NODE, col_gpios, MATRIX_GPIO_SPEC)};
+
+static struct gpio_callback row_cb[KBD_MATRIX_ROWS];
+
+struct matrix_key
+{
+    uint16_t changed_ms; /* uptime (ms, wrapping) of the last raw/stable change */
+    uint8_t raw : 1;     /* level seen on the last scan */
+    uint8_t stable : 1;  /* debounced level last reported */
+};
+
+static struct matrix_key keys[KBD_MATRIX_KEY_COUNT];
+static uint8_t matrix_key_id_base;
+static uint32_t events_dropped;
+
+/* Producer: matrix_scan_fn (system work queue). Consumer: button thread. */
+SPSC_DEFINE(matrix_events, struct key_event, MATRIX_EVENT_RING_SIZE);
+
+static void matrix_scan_fn(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(matrix_scan_work, matrix_scan_fn);
+
+/*
+Function : matrix_rows_irq_set
+
+Description :
+    Arms or disarms the edge interrupt on every row input.
+
+Parameter :
+    enable : true to arm on the active edge, false to disable
+
+Return :
+    void
+
+Example Call :
+    matrix_rows_irq_set(false);
+*/
+static void matrix_rows_irq_set(bool enable)
+{
+    for (size_t r = 0; r < KBD_MATRIX_ROWS; r++)
+    {
+        (void)gpio_pin_interrupt_configure_dt(&rows[r],
+                                              enable ? GPIO_INT_EDGE_TO_ACTIVE : GPIO_INT_DISABLE);
+    }
+}
+
+/*
+Function : matrix_cols_set
+
+Description :
+    Drives every column active (idle mode, so any key pulls its row) or
+    releases all of them before scanning.
+
+Parameter :
+    active : true to drive every column, false to release them
+
+Return :
+    void
+
+Example Call :
+    matrix_cols_set(true);
+*/
+static void matrix_cols_set(bool active)
+{
+    for (size_t c = 0; c < KBD_MATRIX_COLS; c++)
+    {
+        (void)gpio_pin_set_dt(&cols[c], active ? 1 : 0);
+    }
+}
+
+/*
+Function : matrix_rows_any_active
+
+Description :
+    Reads every row and reports whether at least one is active.
+
+Parameter :
+    None
+
+Return :
+    bool : true if any row is active
+
+Example Call :
+    if (matrix_rows_any_active()) { ... }
+*/
+static bool matrix_rows_any_active(void)
+{
+    for (size_t r = 0; r < KBD_MATRIX_ROWS; r++)
+    {
+        if (gpio_pin_get_dt(&rows[r]) > 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+Function : matrix_row_isr
+
+Description :
+    Row interrupt while the matrix is idle. Disarms the rows and kicks off
+    scanning immediately.
+
+Parameter :
+    dev  : GPIO device pointer (unused)
+    cb   : Callback structure pointer (unused)
+    pins : Bitmask of pins that triggered the interrupt (unused)
+
+Return :
+    void
+
+Example Call :
+    registered via gpio_init_callback(...)
+*/
+static void matrix_row_isr(const struct device *dev, struct gpio_callback *cb, uint32_t pins)
+{
+    ARG_UNUSED(dev);
+    ARG_UNUSED(cb);
+    ARG_UNUSED(pins);
+
+    latency_trace_stamp(LATENCY_STAGE_EDGE);
+    matrix_rows_irq_set(false);
+    k_work_reschedule(&matrix_scan_work, K_NO_WAIT);
+}
+
+/*
+Function : matrix_event_push
+
+Description :
+    Pushes a debounced key change into the SPSC ring and wakes the consumer.
+
+Parameter :
+    idx     : Matrix key index (row * cols + col)
+    pressed : New debounced state
+
+Return :
+    bool : true if queued, false if the ring was full
+
+Example Call :
+    matrix_event_push(idx, true);
+*/
+static bool matrix_event_push(size_t idx, bool pressed)
+{
+    struct key_event *evt = spsc_acquire(&matrix_events);
+
+    if (evt == NULL)
+    {
+        events_dropped++;
+        return false;
+    }
+
+    evt->key_id = matrix_key_id_base + idx;
+    evt->pressed = pressed;
+    evt->timestamp = k_cycle_get_32();
+    spsc_produce(&matrix_events);
+
+    latency_trace_stamp(LATENCY_STAGE_DEBOUNCED);
+    button_event_signal();
+    return true;
+}
+
+/*
+Function : matrix_key_update
+
+Description :
+    Runs the debounce rule for one key given the level seen on this scan.
+    Uses the same eager/deferred policy as the GPIO keys.
+
+Parameter :
+    idx    : Matrix key index
+    raw    : Level read on this scan
+    now_ms : Current uptime in ms (wrapping 16 bit)
+
+Return :
+    bool : true while the key is pressed or still settling
+
+Example Call :
+    busy |= matrix_key_update(idx, level, now);
+*/
+static bool matrix_key_update(size_t idx, bool raw, uint16_t now_ms)
+{
+    struct matrix_key *key = &keys[idx];
+    uint16_t elapsed = now_ms - key->changed_ms;
+
+#if CONFIG_APP_BUTTON_DEBOUNCE_EAGER
+    if (raw != key->stable && elapsed >= MATRIX_DEBOUNCE_MS)
+    {
+        if (matrix_event_push(idx, raw))
+        {
+            key->stable = raw;
+            key->changed_ms = now_ms;
+        }
+    }
+#else
+    if (raw != key->raw)
+    {
+        key->changed_ms = now_ms;
+    }
+    else if (raw != key->stable && elapsed >= MATRIX_DEBOUNCE_MS)
+    {
+        if (matrix_event_push(idx, raw))
+        {
+            key->stable = raw;
+        }
+    }
+#endif
+    key->raw = raw;
+
+    return raw || key->stable;
+}
+
+/*
+Function : matrix_scan_fn
+
+Description :
+    Scans every column, debounces each key and reschedules itself while any
+    key is held or settling. Once everything is released the columns are
+    driven again and the rows re-armed, returning to interrupt-driven wake.
+    A press that lands between the last scan and re-arming is caught by
+    re-reading the rows after arming.
+
+Parameter :
+    work : Pointer to the work item (unused)
+
+Return :
+    void
+
+Example Call :
+    scheduled by matrix_row_isr via k_work_reschedule(...)
+*/
+static void matrix_scan_fn(struct k_work *work)
+{
+    uint16_t now_ms = (uint16_t)k_uptime_get_32();
+    bool busy = false;
+
+    ARG_UNUSED(work);
+
+    matrix_cols_set(false);
+    for (size_t c = 0; c < KBD_MATRIX_COLS; c++)
+    {
+        (void)gpio_pin_set_dt(&cols[c], 1);
+        k_busy_wait(MATRIX_SETTLE_US);
+
+        for (size_t r = 0; r < KBD_MATRIX_ROWS; r++)
+        {
+            bool level = gpio_pin_get_dt(&rows[r]) > 0;
+
+            busy |= matrix_key_update((r * KBD_MATRIX_COLS) + c, level, now_ms);
+        }
+        (void)gpio_pin_set_dt(&cols[c], 0);
+    }
+
+    if (busy)
+    {
+        k_work_reschedule(&matrix_scan_work, K_MSEC(MATRIX_POLL_MS));
+        return;
+    }
+
+    /* Everything released: back to interrupt-driven idle */
+    matrix_cols_set(true);
+    k_busy_wait(MATRIX_SETTLE_US);
+    matrix_rows_irq_set(true);
+
+    if (matrix_rows_any_active())
+    {
+        matrix_rows_irq_set(false);
+        k_work_reschedule(&matrix_scan_work, K_NO_WAIT);
+    }
+}
+
+/*
+Function : kbd_matrix_event_get
+
+Description :
+    Consumer side of the matrix event ring. Copies out the oldest pending
+    event, if any.
+
+Parameter :
+    evt : Output event
+
+Return :
+    bool : true if an event was returned, false if the ring is empty
+
+Example Call :
+    struct key_event ev;
+    while (kbd_matrix_event_get(&ev)) { ... }
+*/
+bool kbd_matrix_event_get(struct key_event *evt)
+{
+    struct key_event *slot = spsc_consume(&matrix_events);
+
+    if (slot == NULL)
+    {
+        return false;
+    }
+
+    *evt = *slot;
+    spsc_release(&matrix_events);
+    return true;
+}
+
+/*
+Function : kbd_matrix_suspend
+
+Description :
+    Prepares the matrix for system-off: stops scanning, drives every column
+    and arms the rows as level interrupts so that the GPIO SENSE mechanism
+    wakes the SoC on any key.
+
+Parameter :
+    None
+
+Return :
+    void
+
+Example Call :
+    kbd_matrix_suspend();
+*/
+void kbd_matrix_suspend(void)
+{
+    (void)k_work_cancel_delayable(&matrix_scan_work);
+    matrix_cols_set(true);
+
+    for (size_t r = 0; r < KBD_MATRIX_ROWS; r++)
+    {
+        (void)gpio_pin_interrupt_configure_dt(&rows[r], GPIO_INT_LEVEL_ACTIVE);
+    }
+    LOG_DBG("Matrix suspended, %u events dropped", events_dropped);
+}
+
+/*
+Function : kbd_matrix_init
+
+Description :
+    Configures the row inputs and column outputs from devicetree, installs
+    the row interrupts and leaves the matrix in interrupt-driven idle.
+
+Parameter :
+    key_id_base : Key ID assigned to row 0 / column 0
+
+Return :
+    int : 0 on success, negative errno on failure
+
+Example Call :
+    int err = kbd_matrix_init(ARRAY_SIZE(button_keys));
+*/
+int kbd_matrix_init(uint8_t key_id_base)
+{
+    int err;
+
+    matrix_key_id_base = key_id_base;
+
+    for (size_t c = 0; c < KBD_MATRIX_COLS; c++)
+    {
+        if (!gpio_is_ready_dt(&cols[c]))
+        {
+            return -ENODEV;
+        }
+        err = gpio_pin_configure_dt(&cols[c], GPIO_OUTPUT_ACTIVE);
+        if (err)
+        {
+            LOG_ERR("Error %d: failed to configure matrix column %u", err, c);
+            return err;
+        }
+    }
+
+    for (size_t r = 0; r < KBD_MATRIX_ROWS; r++)
+    {
+        if (!gpio_is_ready_dt(&rows[r]))
+        {
+            return -ENODEV;
+        }
+        err = gpio_pin_configure_dt(&rows[r], GPIO_INPUT);
+        if (err)
+        {
+            LOG_ERR("Error %d: failed to configure matrix row %u", err, r);
+            return err;
+        }
+        gpio_init_callback(&row_cb[r], matrix_row_isr, BIT(rows[r].pin));
+        gpio_add_callback(rows[r].port, &row_cb[r]);
+    }
+
+    k_busy_wait(MATRIX_SETTLE_US);
+    matrix_rows_irq_set(true);
+
+    /* Keys already held at boot (e.g. the wake key) are picked up at once */
+    if (matrix_rows_any_active())
+    {
+        matrix_rows_irq_set(false);
+        k_work_reschedule(&matrix_scan_work, K_NO_WAIT);
+    }
+
+    LOG_INF("Key matrix %ux%u ready, key IDs %u..%u\n", KBD_MATRIX_ROWS, KBD_MATRIX_COLS,
+            key_id_base, key_id_base + KBD_MATRIX_KEY_COUNT - 1);
+    return 0;
+}
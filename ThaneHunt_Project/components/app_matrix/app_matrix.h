@@ -0,0 +1,36 @@
+/*
+Name : app_matrix
+
+Description :
+    Keyboard matrix scanner for boards with more keys than GPIOs. Rows and
+    columns come from the "kbd_matrix" devicetree node. While every key is
+    released the matrix sleeps with all columns driven and the rows armed as
+    GPIO interrupts; a press starts periodic scanning, which stops again
+    once every key is released. Debounced key changes are pushed as
+    {key_id, state, timestamp} events through a lock-free SPSC ring to the
+    button consumer thread.
+
+Date : 2026-10-14
+
+Developer : Engineer Akbar Shah
+*/
+
+#ifndef APP_MATRIX_H
+#define APP_MATRIX_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <zephyr/devicetree.h>
+
+#include "app_button.h"
+
+#define KBD_MATRIX_NODE DT_NODELABEL(kbd_matrix)
+#define KBD_MATRIX_ROWS DT_PROP_LEN(KBD_MATRIX_NODE, row_gpios)
+#define KBD_MATRIX_COLS DT_PROP_LEN(KBD_MATRIX_NODE, col_gpios)
+#define KBD_MATRIX_KEY_COUNT (KBD_MATRIX_ROWS * KBD_MATRIX_COLS)
+
+int kbd_matrix_init(uint8_t key_id_base);
+bool kbd_matrix_event_get(struct key_event *evt);
+void kbd_matrix_suspend(void);
+
+#endif // APP_MATRIX_H
@@ -3,9 +3,14 @@ Name : app_sleep
 
 Description :
     Power management helper module for the BLE HID application on Zephyr RTOS.
-    Provides an idle timer and work handler to disconnect BLE and transition
-    the system into deep sleep (system-off) after inactivity. Also exposes
-    utility functions to start and reset the idle timer.
+    Runs a tiered power manager: active, idle (relaxed connection
+    parameters), connected-sleep (maximum peripheral latency, peripherals
+    gated) and system-off. Every tier has its own timeout and steps one
+    tier down when it expires; any activity brings the device straight back
+    to active. Modules register entry/exit hooks to follow the tiers, so a
+    short pause no longer costs a full cold boot and reconnect. Activity
+    only stores a timestamp; one lazily re-armed work item compares it to
+    the tier deadlines.
 
 Date : 2025-09-14
 
@@ -16,8 +21,12 @@ Developer : Engineer Akbar Shah
 #include <zephyr/logging/log.h>
 #include <zephyr/sys/poweroff.h>
 
+#include "app_adv.h"
 #include "app_ble.h"
+#include "app_energy.h"
 #include "app_sleep.h"
+#include "app_store.h"
+#include "app_wake.h"
 
 #if CONFIG_IMU_LSM6DSO
 #include "app_imu.h"
@@ -25,19 +34,113 @@ Developer : Engineer Akbar Shah
 
 LOG_MODULE_REGISTER(APP_SLEEP);
 
-static void idle_work_fn(struct k_work *w);
-static void idle_timeout(struct k_timer *t);
-;
+static void tier_work_fn(struct k_work *w);
 
-K_WORK_DEFINE(idle_work, idle_work_fn);
-K_TIMER_DEFINE(idle_timer, idle_timeout, NULL);
+static K_WORK_DELAYABLE_DEFINE(tier_work, tier_work_fn);
+
+static sys_slist_t power_hooks = SYS_SLIST_STATIC_INIT(&power_hooks);
+static struct k_spinlock power_lock;              /* hook list */
+static atomic_t power_tier = ATOMIC_INIT(POWER_TIER_ACTIVE); /* written by tier_work only */
+static atomic_t last_activity;                    /* k_uptime_get_32() of the last activity */
+static uint32_t tier_entered;                     /* k_uptime_get_32() at tier entry, tier_work only */
+static uint32_t tier_accounted;                   /* k_uptime_get_32() of the last statistics update, tier_work only */
+
+static const char *const tier_name[] = {
+    [POWER_TIER_ACTIVE] = "active",
+    [POWER_TIER_IDLE] = "idle",
+    [POWER_TIER_CONN_SLEEP] = "connected-sleep",
+    [POWER_TIER_OFF] = "system-off",
+};
+
+/*
+Function : tier_timeout_ms
+
+Description :
+    Time a tier lasts without activity before the next one is entered.
+    Active counts from the last activity, the lower tiers from their
+    entry. Without a link, connected-sleep lasts as long as the
+    advertising schedule runs, so the slow stages get their time; app_adv
+    calls power_tier_update() when the schedule ends.
+
+Parameter :
+    tier : Current power tier
+
+Return :
+    uint32_t : Dwell time in ms, UINT32_MAX for system-off or until
+               power_tier_update()
+
+Example Call :
+    uint32_t dwell = tier_timeout_ms(POWER_TIER_ACTIVE);
+*/
+static uint32_t tier_timeout_ms(enum power_tier tier)
+{
+    switch (tier)
+    {
+    case POWER_TIER_ACTIVE:
+        return CONFIG_APP_POWER_IDLE_MS;
+    case POWER_TIER_IDLE:
+        return CONFIG_DEVICE_IDLE_TIMEOUT_SECONDS * MSEC_PER_SEC;
+    case POWER_TIER_CONN_SLEEP:
+        if (isBle_connected)
+        {
+            return CONFIG_APP_POWER_OFF_TIMEOUT_S * MSEC_PER_SEC;
+        }
+        /* No link: stay up while advertising, then go on to system-off */
+        return adv_schedule_running() ? UINT32_MAX : 0;
+    default:
+        return UINT32_MAX;
+    }
+}
+
+/*
+Function : power_stats_account
+
+Description :
+    Adds the time spent in the tier being left to the power statistics of
+    the wake context and counts the entry into the next one. tier_work
+    only; the statistics carry over system-off when the wake context is
+    retained.
+
+Parameter :
+    from : Tier being left
+    to   : Tier being entered
+    now  : k_uptime_get_32() of the transition
+
+Return :
+    void
+
+Example Call :
+    power_stats_account(POWER_TIER_IDLE, POWER_TIER_ACTIVE, now);
+*/
+static void power_stats_account(enum power_tier from, enum power_tier to, uint32_t now)
+{
+    struct power_stats *stats = &wake_ctx_get()->power;
+
+    energy_tier_set(to);
+    if (from < POWER_TIER_OFF)
+    {
+        stats->tier_ms[from] += now - tier_accounted;
+    }
+    tier_accounted = now;
+    if (to == POWER_TIER_OFF)
+    {
+        stats->off_count++;
+    }
+    else
+    {
+        stats->tier_entries[to]++;
+    }
+}
 
 /*
 Function : enter_device_sleep
 
 Description :
     Transitions the system to deep sleep (system off). Intended to be called
-    after higher-level teardown (e.g., stopping BLE/advertising).
+    after higher-level teardown (e.g., stopping BLE/advertising). With
+    wake-on-motion the IMU INT1 line is armed as a sense wake source last,
+    with interrupts locked, since its latched level would otherwise keep
+    interrupting.
 
 Parameter :
     None
@@ -48,76 +151,182 @@ Return :
 Example Call :
     enter_device_sleep();
 */
-void enter_device_sleep(void)
+static void enter_device_sleep(void)
 {
     LOG_INF("Entering deep sleep (system-off)");
-    /* Ensure your app stopped BLE/adv, completed DMA, etc. */
-    k_sleep(K_MSEC(5000)); /* grace period */
+    (void)irq_lock(); /* sys_poweroff() does not return */
+#if CONFIG_IMU_LSM6DSO
+    imu_wake_sense_arm();
+#endif
     sys_poweroff(); /* does not return */
 }
 
 /*
-Function : idle_work_fn
+Function : power_hooks_run
 
 Description :
-    Work item that runs on idle timeout: safely disconnects BLE, waits a
-    short grace period, then enters system-off.
+    Calls the enter or exit hook of every registered module for a tier.
 
 Parameter :
-    w : Pointer to the work item (unused)
+    tier  : Tier being entered or left
+    enter : true to run the enter hooks, false for the exit hooks
 
 Return :
     void
 
 Example Call :
-    k_work_submit(&idle_work);
+    power_hooks_run(POWER_TIER_IDLE, true);
 */
-static void idle_work_fn(struct k_work *w)
+static void power_hooks_run(enum power_tier tier, bool enter)
 {
-    k_msleep(100);
-#if CONFIG_IMU_LSM6DSO
-    int err = lsm6dso_accel_gyro_power_down();
-    if (err)
+    struct power_hook *hook;
+
+    SYS_SLIST_FOR_EACH_CONTAINER(&power_hooks, hook, node)
     {
-        LOG_ERR("Failed to power down LSM6DSO (err: %d)", err);
+        void (*fn)(enum power_tier) = enter ? hook->enter : hook->exit;
+
+        if (fn)
+        {
+            fn(tier);
+        }
     }
-    LOG_INF("LSM6DSO powered down");
-#endif
-    LOG_DBG("Idle work: disconnecting BLE and entering deep sleep");
-    (void)ble_disconnect_safe(); /* your helper */
+}
+
+/*
+Function : tier_work_fn
+
+Description :
+    Owns the tier transitions; the only place the tier deadline is
+    checked. Activity since the current lower tier was entered brings the
+    device back to active, leaving every tier deepest first. Otherwise, if
+    the tier's dwell time is used up the next tier is entered (on
+    system-off BLE is torn down, pending settings are written and
+    snapshotted, the wake context is saved and the SoC powered off), and
+    if not the work is re-armed for the remaining time. A tier step is
+    rolled back when activity raced it, before any hook ran. Every
+    transition is added to the power statistics.
+
+Parameter :
+    w : Pointer to the work item (unused)
+
+Return :
+    void
+
+Example Call :
+    scheduled by start_idle_timer() / reset_idle_timer()
+*/
+static void tier_work_fn(struct k_work *w)
+{
+    ARG_UNUSED(w);
 
-    LOG_WRN("No activity -> disconnect + deep sleep");
-    enter_device_sleep(); /* calls sys_poweroff() */
+    for (;;)
+    {
+        enum power_tier from = (enum power_tier)atomic_get(&power_tier);
+        uint32_t last = (uint32_t)atomic_get(&last_activity);
+        uint32_t now = k_uptime_get_32();
+        uint32_t since = (from == POWER_TIER_ACTIVE) ? last : tier_entered;
+        uint32_t dwell = tier_timeout_ms(from);
+        uint32_t elapsed = now - since;
+        enum power_tier to;
+
+        if (from != POWER_TIER_ACTIVE && (int32_t)(last - tier_entered) >= 0)
+        {
+            atomic_set(&power_tier, POWER_TIER_ACTIVE);
+            power_stats_account(from, POWER_TIER_ACTIVE, now);
+            for (int t = from; t > POWER_TIER_ACTIVE; t--)
+            {
+                power_hooks_run((enum power_tier)t, false);
+            }
+            LOG_INF("Power tier %s -> %s\n", tier_name[from], tier_name[POWER_TIER_ACTIVE]);
+            continue;
+        }
+
+        if (from == POWER_TIER_OFF)
+        {
+            return;
+        }
+
+        if (elapsed < dwell)
+        {
+            (void)k_work_reschedule(&tier_work, K_MSEC(dwell - elapsed));
+            return;
+        }
+
+        to = from + 1;
+        atomic_set(&power_tier, to);
+        if ((uint32_t)atomic_get(&last_activity) != last)
+        {
+            /* Activity landed while switching and may have seen the old tier */
+            atomic_set(&power_tier, from);
+            continue;
+        }
+        tier_entered = now;
+        power_stats_account(from, to, now);
+
+        power_hooks_run(to, true);
+        LOG_INF("Power tier %s -> %s\n", tier_name[from], tier_name[to]);
+
+        if (to == POWER_TIER_OFF)
+        {
+            LOG_WRN("No activity -> disconnect + deep sleep");
+            (void)ble_disconnect_safe();
+            store_sync();
+            wake_ctx_save();
+            enter_device_sleep(); /* calls sys_poweroff() */
+        }
+    }
 }
 
 /*
-Function : idle_timeout
+Function : power_hook_register
 
 Description :
-    Timer callback fired when no activity is observed for the configured
-    window. Schedules idle_work to disconnect and power down.
+    Registers a module's tier hooks. Call once at init with a statically
+    allocated hook.
 
 Parameter :
-    t : Pointer to the Zephyr timer that expired
+    hook : Hook with enter/exit callbacks
 
 Return :
     void
 
 Example Call :
-    invoked by k_timer after start
+    power_hook_register(&imu_power_hook);
+*/
+void power_hook_register(struct power_hook *hook)
+{
+    k_spinlock_key_t key = k_spin_lock(&power_lock);
+
+    sys_slist_append(&power_hooks, &hook->node);
+    k_spin_unlock(&power_lock, key);
+}
+
+/*
+Function : power_tier_get
+
+Description :
+    Returns the current power tier.
+
+Parameter :
+    None
+
+Return :
+    enum power_tier : Current tier
+
+Example Call :
+    if (power_tier_get() == POWER_TIER_ACTIVE) { ... }
 */
-static void idle_timeout(struct k_timer *t)
+enum power_tier power_tier_get(void)
 {
-    k_work_submit(&idle_work); /* defer to thread context */
+    return (enum power_tier)atomic_get(&power_tier);
 }
 
 /*
 Function : start_idle_timer
 
 Description :
-    Starts the idle timer with a 30-second timeout. When it expires without
-    reset, the system will disconnect BLE and enter deep sleep via the
-    idle_work_fn.
+    Starts the power manager in the active tier. The idle tier follows
+    after CONFIG_APP_POWER_IDLE_MS without activity.
 
 Parameter :
     None
@@ -130,16 +339,20 @@ Example Call :
 */
 void start_idle_timer(void)
 {
-    k_timer_start(&idle_timer, K_SECONDS(CONFIG_DEVICE_IDLE_TIMEOUT_SECONDS), K_NO_WAIT);
+    atomic_set(&last_activity, (atomic_val_t)k_uptime_get_32());
+    (void)k_work_reschedule(&tier_work, K_MSEC(tier_timeout_ms(POWER_TIER_ACTIVE)));
     LOG_DBG("Idle timer started");
 }
 
 /*
-Function : stop_idle_timer
+Function : reset_idle_timer
 
 Description :
-    Stops the idle timer if running. This prevents the system from entering
-    deep sleep due to inactivity.
+    Records user activity. On the hot path (active tier) this only stores
+    the uptime; the idle deadline is checked lazily when the tier work
+    fires. In a lower tier the tier work is kicked to bring the device
+    back to active right away. Safe to call from interrupt context and
+    from any number of input sources.
 
 Parameter :
     None
@@ -148,21 +361,25 @@ Return :
     void
 
 Example Call :
-    stop_idle_timer();
+    reset_idle_timer();
 */
-void stop_idle_timer(void)
+void reset_idle_timer(void)
 {
-    k_timer_stop(&idle_timer);
-    LOG_DBG("Idle timer stopped");
+    atomic_set(&last_activity, (atomic_val_t)k_uptime_get_32());
+
+    if (unlikely(atomic_get(&power_tier) != POWER_TIER_ACTIVE))
+    {
+        (void)k_work_reschedule(&tier_work, K_NO_WAIT);
+    }
 }
 
 /*
-Function : reset_idle_timer
+Function : power_tier_update
 
 Description :
-    Stops the current idle timer and restarts it with a fresh 30-second
-    timeout. Intended to be called whenever user activity is detected to
-    prevent premature sleep.
+    Re-evaluates the dwell time of the current tier right away, for a
+    condition of tier_timeout_ms() that changed without user activity,
+    such as the end of the advertising schedule.
 
 Parameter :
     None
@@ -171,11 +388,9 @@ Return :
     void
 
 Example Call :
-    reset_idle_timer();
+    power_tier_update();
 */
-void reset_idle_timer(void)
+void power_tier_update(void)
 {
-    stop_idle_timer();
-    start_idle_timer();
-    LOG_DBG("Idle timer reset");
-}
\ No newline at end of file
+    (void)k_work_reschedule(&tier_work, K_NO_WAIT);
+}
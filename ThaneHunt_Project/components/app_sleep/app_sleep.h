@@ -3,9 +3,11 @@ Name : app_sleep
 
 Description :
     Power management helper module for the BLE HID application on Zephyr RTOS.
-    Provides an idle timer and work handler to disconnect BLE and transition
-    the system into deep sleep (system-off) after inactivity. Also exposes
-    utility functions to start and reset the idle timer.
+    Runs a tiered power manager: active, idle (relaxed connection
+    parameters), connected-sleep (maximum peripheral latency, peripherals
+    gated) and system-off. Each tier has its own timeout; activity brings
+    the device straight back to active. Modules register entry/exit hooks
+    to follow the tiers.
 
 Date : 2025-09-14
 
@@ -15,7 +17,43 @@ Developer : Engineer Akbar Shah
 #ifndef APP_SLEEP_H
 #define APP_SLEEP_H
 
+#include <stdint.h>
+#include <zephyr/sys/slist.h>
+
+/* Power tiers, from fully on to system-off. Each tier includes the ones above it. */
+enum power_tier
+{
+    POWER_TIER_ACTIVE = 0,
+    POWER_TIER_IDLE,       /* relaxed connection parameters */
+    POWER_TIER_CONN_SLEEP, /* max peripheral latency, peripherals gated */
+    POWER_TIER_OFF,        /* system-off, wake by GPIO sense */
+};
+
+/*
+ * Tier hook. enter() runs when the device steps down into a tier, exit()
+ * when it leaves that tier on the way back to active (deepest tier
+ * first). Both run on the system workqueue and may block; either may be
+ * NULL.
+ */
+struct power_hook
+{
+    sys_snode_t node;
+    void (*enter)(enum power_tier tier);
+    void (*exit)(enum power_tier tier);
+};
+
+/* Tier statistics, accumulated across system-off in the wake context */
+struct power_stats
+{
+    uint32_t off_count;                    /* system-off entries */
+    uint32_t tier_entries[POWER_TIER_OFF]; /* entries into each tier above system-off */
+    uint32_t tier_ms[POWER_TIER_OFF];      /* time spent in each tier above system-off */
+};
+
+void power_hook_register(struct power_hook *hook);
+enum power_tier power_tier_get(void);
 void start_idle_timer(void);
 void reset_idle_timer(void);
+void power_tier_update(void);
 
 #endif // APP_SLEEP_H
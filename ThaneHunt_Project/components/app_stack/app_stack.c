@@ -0,0 +1,167 @@
+/*
+Name : app_stack
+
+Description :
+    Stack high-water mark check for the BLE HID keyboard. Stacks are
+    filled with a pattern at thread creation (CONFIG_INIT_STACKS); the
+    untouched part left at the bottom is the space the thread never used.
+    The check walks every thread after each burst of activity (idle tier
+    entry) and before system-off, logs the figures once and again when a
+    thread gets close, so a stack trimmed too far (lean.conf) shows up on
+    the first session that reaches it, not as a random fault later.
+
+Date : 2026-10-14
+
+Developer : Engineer Akbar Shah
+*/
+
+#include <zephyr/init.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/logging/log_ctrl.h>
+
+#include "app_sleep.h"
+#include "app_stack.h"
+
+LOG_MODULE_REGISTER(APP_STACK);
+
+#define STACK_MIN_FREE CONFIG_APP_STACK_WATERMARK_MIN_FREE
+
+static void stack_tier_enter(enum power_tier tier);
+
+static struct power_hook stack_power_hook = {
+    .enter = stack_tier_enter,
+};
+
+static bool stack_reported; /* figures of every thread logged once */
+
+/*
+Function : stack_thread_check
+
+Description :
+    k_thread_foreach_unlocked() callback measuring one thread. Logs its
+    usage at info level on the first check, debug level afterwards, and
+    as an error when less than STACK_MIN_FREE bytes were never used.
+
+Parameter :
+    thread    : Thread to measure
+    user_data : Pointer to the result, cleared when the thread is short
+
+Return :
+    void
+
+Example Call :
+    k_thread_foreach_unlocked(stack_thread_check, &ok);
+*/
+static void stack_thread_check(const struct k_thread *thread, void *user_data)
+{
+    bool *ok = user_data;
+    const char *name = k_thread_name_get((k_tid_t)thread);
+    size_t size = thread->stack_info.size;
+    size_t unused;
+
+    if (k_thread_stack_space_get(thread, &unused))
+    {
+        return;
+    }
+    if (!name || !name[0])
+    {
+        name = "?";
+    }
+
+    if (unused < STACK_MIN_FREE)
+    {
+        *ok = false;
+        LOG_ERR("Stack %s (%p): %zu of %zu bytes used, %zu free < %u", name, (void *)thread,
+                size - unused, size, unused, STACK_MIN_FREE);
+    }
+    else if (!stack_reported)
+    {
+        LOG_INF("Stack %s: %zu of %zu bytes used", name, size - unused, size);
+    }
+    else
+    {
+        LOG_DBG("Stack %s: %zu of %zu bytes used", name, size - unused, size);
+    }
+}
+
+/*
+Function : stack_watermark_check
+
+Description :
+    Measures the stack high-water mark of every thread. The walk does not
+    lock the scheduler, so it may run while the device is busy; threads
+    are not created or aborted at runtime here.
+
+Parameter :
+    None
+
+Return :
+    bool : true if every thread kept CONFIG_APP_STACK_WATERMARK_MIN_FREE
+           bytes unused
+
+Example Call :
+    (void)stack_watermark_check();
+*/
+bool stack_watermark_check(void)
+{
+    bool ok = true;
+
+    k_thread_foreach_unlocked(stack_thread_check, &ok);
+    stack_reported = true;
+    __ASSERT(ok, "Thread stack below %u bytes free", STACK_MIN_FREE);
+    return ok;
+}
+
+/*
+Function : stack_tier_enter
+
+Description :
+    Power tier entry hook. Stepping down into idle ends a burst of
+    activity, system-off ends the session; both are checked. A failure
+    before system-off flushes the log first, as deferred messages would
+    otherwise be lost with the power-off.
+
+Parameter :
+    tier : Tier being entered
+
+Return :
+    void
+
+Example Call :
+    registered with power_hook_register()
+*/
+static void stack_tier_enter(enum power_tier tier)
+{
+    if (tier == POWER_TIER_IDLE)
+    {
+        (void)stack_watermark_check();
+    }
+    else if ((tier == POWER_TIER_OFF) && !stack_watermark_check())
+    {
+        log_panic();
+    }
+}
+
+/*
+Function : stack_watermark_init
+
+Description :
+    Registers the check with the power manager.
+
+Parameter :
+    None
+
+Return :
+    int : 0 always
+
+Example Call :
+    run by SYS_INIT at APPLICATION level
+*/
+static int stack_watermark_init(void)
+{
+    power_hook_register(&stack_power_hook);
+    return 0;
+}
+
+SYS_INIT(stack_watermark_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
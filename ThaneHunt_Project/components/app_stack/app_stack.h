@@ -0,0 +1,28 @@
+/*
+Name : app_stack
+
+Description :
+    Stack high-water mark check for the BLE HID keyboard. With
+    CONFIG_APP_STACK_WATERMARK the unused stack of every thread is
+    measured after each burst of activity (idle tier entry) and before
+    system-off, and a thread below CONFIG_APP_STACK_WATERMARK_MIN_FREE
+    bytes is reported and asserted on. Guards the trimmed stacks of
+    lean.conf.
+
+Date : 2026-10-14
+
+Developer : Engineer Akbar Shah
+*/
+
+#ifndef APP_STACK_H
+#define APP_STACK_H
+
+#include <stdbool.h>
+
+#if CONFIG_APP_STACK_WATERMARK
+bool stack_watermark_check(void);
+#else
+static inline bool stack_watermark_check(void) { return true; }
+#endif
+
+#endif // APP_STACK_H
@@ -0,0 +1,607 @@
+/*
+Name : app_store
+
+Description :
+    Settings layer for the BLE HID keyboard. Application keys are written
+    through a small cache: a value equal to the one last stored or loaded
+    is not written again, and changes are batched and written
+    CONFIG_APP_STORE_BATCH_MS after the first one, or right before
+    system-off. With CONFIG_APP_FAST_BOOT_CACHE the whole settings storage
+    (Bluetooth bonds and CCCs, host slots, ...) is snapshotted into a
+    retained RAM region just before system-off. The wake that follows
+    replays the snapshot through the settings handlers instead of scanning
+    ZMS/NVS; any other reset, or a snapshot that fails its checksum, falls
+    back to settings_load(). The snapshot is used once and then cleared.
+
+Date : 2026-10-14
+
+Developer : Engineer Akbar Shah
+*/
+
+#include <string.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/hwinfo.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/retention/retention.h>
+#include <zephyr/settings/settings.h>
+#include <zephyr/sys/printk.h>
+
+#include "app_store.h"
+
+LOG_MODULE_REGISTER(APP_STORE);
+
+#define STORE_ROOT "app" /* Subtree of the application keys */
+#define STORE_ENTRIES 8
+#define STORE_KEY_MAX 24   /* Including the terminating NUL */
+#define STORE_VALUE_MAX 16 /* Larger values are written through */
+
+/* Application key and the value last stored, loaded or waiting in the batch */
+struct store_entry
+{
+    char key[STORE_KEY_MAX];
+    uint8_t value[STORE_VALUE_MAX];
+    uint8_t len;
+    bool known; /* value is the stored one, or the one waiting to be written */
+    bool dirty; /* value not written yet */
+};
+
+static struct store_entry entries[STORE_ENTRIES];
+static K_MUTEX_DEFINE(store_lock);
+
+static void store_flush_fn(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(store_flush_work, store_flush_fn);
+
+#if CONFIG_APP_FAST_BOOT_CACHE
+/*
+ * Snapshot layout in the retention area: a header, then one record per
+ * settings key, each a record header, the key name (no NUL) and the value.
+ * The retention subsystem adds the prefix and checksum around it.
+ */
+#define CACHE_NODE DT_NODELABEL(fast_boot_cache)
+
+struct cache_hdr
+{
+    uint16_t count; /* Records */
+    uint16_t len;   /* Bytes used, header included */
+};
+
+struct cache_rec
+{
+    uint8_t name_len;
+    uint8_t reserved;
+    uint16_t value_len;
+};
+
+struct cache_build
+{
+    size_t used;
+    uint16_t count;
+    int err;
+};
+
+static const struct device *const cache_dev = DEVICE_DT_GET(CACHE_NODE);
+static uint8_t cache_buf[DT_REG_SIZE(CACHE_NODE)]; /* Snapshot staging, reused on restore */
+#endif
+
+/*
+Function : entry_find
+
+Description :
+    Looks up the cache entry of an application key, optionally taking a
+    free entry for it. Caller must hold store_lock.
+
+Parameter :
+    key    : Settings key
+    create : true to take a free entry when the key has none
+
+Return :
+    struct store_entry * : Entry, or NULL if not found and none is free
+
+Example Call :
+    struct store_entry *e = entry_find("app/host/active", true);
+*/
+static struct store_entry *entry_find(const char *key, bool create)
+{
+    struct store_entry *free_entry = NULL;
+
+    for (size_t i = 0; i < STORE_ENTRIES; i++)
+    {
+        if (entries[i].key[0] == '\0')
+        {
+            free_entry = free_entry ? free_entry : &entries[i];
+        }
+        else if (strcmp(entries[i].key, key) == 0)
+        {
+            return &entries[i];
+        }
+    }
+
+    if (!create || !free_entry)
+    {
+        return NULL;
+    }
+    strcpy(free_entry->key, key);
+    free_entry->len = 0;
+    free_entry->known = false;
+    free_entry->dirty = false;
+    return free_entry;
+}
+
+/*
+Function : entry_seed
+
+Description :
+    Records a value known to be in storage, so saving it again is a
+    no-op. Keys and values too large for the cache are ignored.
+
+Parameter :
+    key   : Settings key
+    value : Stored value
+    len   : Value length
+
+Return :
+    void
+
+Example Call :
+    entry_seed(name, value, len);
+*/
+static void entry_seed(const char *key, const void *value, size_t len)
+{
+    struct store_entry *e;
+
+    if ((strlen(key) >= STORE_KEY_MAX) || (len > STORE_VALUE_MAX))
+    {
+        return;
+    }
+
+    k_mutex_lock(&store_lock, K_FOREVER);
+    e = entry_find(key, true);
+    if (e && !e->dirty)
+    {
+        memcpy(e->value, value, len);
+        e->len = (uint8_t)len;
+        e->known = true;
+    }
+    k_mutex_unlock(&store_lock);
+}
+
+/*
+Function : entry_seed_load
+
+Description :
+    settings_load_subtree_direct() callback seeding the cache with one
+    stored application key, after settings_load() on a cold boot.
+
+Parameter :
+    key     : Key below STORE_ROOT
+    len     : Size of the stored value
+    read_cb : Settings read callback
+    cb_arg  : Argument of read_cb
+    param   : Unused
+
+Return :
+    int : Always 0, so the walk goes on
+
+Example Call :
+    settings_load_subtree_direct(STORE_ROOT, entry_seed_load, NULL);
+*/
+static int entry_seed_load(const char *key, size_t len, settings_read_cb read_cb,
+                           void *cb_arg, void *param)
+{
+    char name[STORE_KEY_MAX];
+    uint8_t value[STORE_VALUE_MAX];
+    ssize_t rc;
+
+    ARG_UNUSED(param);
+
+    if (!key || (len > sizeof(value)) ||
+        (snprintk(name, sizeof(name), STORE_ROOT "/%s", key) >= (int)sizeof(name)))
+    {
+        return 0; /* not cached, written through */
+    }
+    rc = read_cb(cb_arg, value, len);
+    if (rc == (ssize_t)len)
+    {
+        entry_seed(name, value, len);
+    }
+    return 0;
+}
+
+/*
+Function : store_flush
+
+Description :
+    Writes every batched application key to settings. A key that fails
+    stays dirty and is retried with the next batch.
+
+Parameter :
+    None
+
+Return :
+    void
+
+Example Call :
+    store_flush();
+*/
+static void store_flush(void)
+{
+    k_mutex_lock(&store_lock, K_FOREVER);
+    for (size_t i = 0; i < STORE_ENTRIES; i++)
+    {
+        struct store_entry *e = &entries[i];
+        int err;
+
+        if (!e->dirty)
+        {
+            continue;
+        }
+        err = settings_save_one(e->key, e->value, e->len);
+        if (err)
+        {
+            LOG_ERR("Failed to store %s (err %d)", e->key, err);
+            continue;
+        }
+        e->dirty = false;
+    }
+    k_mutex_unlock(&store_lock);
+}
+
+/*
+Function : store_flush_fn
+
+Description :
+    Work handler writing the batched application keys.
+
+Parameter :
+    work : Pointer to the work item (unused)
+
+Return :
+    void
+
+Example Call :
+    scheduled by store_save()
+*/
+static void store_flush_fn(struct k_work *work)
+{
+    ARG_UNUSED(work);
+
+    store_flush();
+}
+
+#if CONFIG_APP_FAST_BOOT_CACHE
+/*
+Function : cache_add
+
+Description :
+    settings_load_subtree_direct() callback appending one stored key to
+    the snapshot. Deleted keys (no value) are skipped; a snapshot that
+    outgrows the retention area is abandoned.
+
+Parameter :
+    key     : Full settings key
+    len     : Size of the stored value
+    read_cb : Settings read callback
+    cb_arg  : Argument of read_cb
+    param   : Snapshot under construction (struct cache_build)
+
+Return :
+    int : Always 0, errors are kept in the build state
+
+Example Call :
+    settings_load_subtree_direct(NULL, cache_add, &build);
+*/
+static int cache_add(const char *key, size_t len, settings_read_cb read_cb,
+                     void *cb_arg, void *param)
+{
+    struct cache_build *build = param;
+    struct cache_rec rec = {0};
+    size_t name_len = strlen(key);
+    ssize_t rc;
+
+    if (build->err || (len == 0))
+    {
+        return 0;
+    }
+    if ((name_len > SETTINGS_MAX_NAME_LEN) || (len > UINT16_MAX) ||
+        (build->used + sizeof(rec) + name_len + len > sizeof(cache_buf)))
+    {
+        build->err = -ENOSPC;
+        return 0;
+    }
+
+    rc = read_cb(cb_arg, &cache_buf[build->used + sizeof(rec) + name_len], len);
+    if (rc <= 0)
+    {
+        build->err = (rc < 0) ? (int)rc : -EIO;
+        return 0;
+    }
+
+    rec.name_len = (uint8_t)name_len;
+    rec.value_len = (uint16_t)rc;
+    memcpy(&cache_buf[build->used], &rec, sizeof(rec));
+    memcpy(&cache_buf[build->used + sizeof(rec)], key, name_len);
+    build->used += sizeof(rec) + name_len + rc;
+    build->count++;
+    return 0;
+}
+
+/*
+Function : cache_snapshot
+
+Description :
+    Copies the whole settings storage into the retention area. Called
+    right before system-off, once nothing writes settings any more. If
+    the snapshot does not fit, the area is cleared and the next wake
+    loads settings from storage.
+
+Parameter :
+    None
+
+Return :
+    void
+
+Example Call :
+    cache_snapshot();
+*/
+static void cache_snapshot(void)
+{
+    struct cache_build build = {.used = sizeof(struct cache_hdr)};
+    struct cache_hdr hdr;
+    ssize_t size;
+    int err;
+
+    if (!device_is_ready(cache_dev))
+    {
+        return;
+    }
+
+    (void)settings_load_subtree_direct(NULL, cache_add, &build);
+    size = retention_size(cache_dev);
+    if (!build.err && ((size < 0) || (build.used > (size_t)size)))
+    {
+        build.err = -ENOSPC;
+    }
+    if (build.err)
+    {
+        LOG_WRN("Settings snapshot skipped (err %d)", build.err);
+        (void)retention_clear(cache_dev);
+        return;
+    }
+
+    hdr.count = build.count;
+    hdr.len = (uint16_t)build.used;
+    memcpy(cache_buf, &hdr, sizeof(hdr));
+    err = retention_write(cache_dev, 0, cache_buf, build.used);
+    if (err)
+    {
+        LOG_WRN("Settings snapshot write failed (err %d)", err);
+        (void)retention_clear(cache_dev);
+        return;
+    }
+    LOG_INF("Settings snapshot: %u keys, %u bytes\n", hdr.count, hdr.len);
+}
+
+/*
+Function : cache_restore
+
+Description :
+    On a wake from system-off, replays a valid snapshot through the
+    settings handlers and commits them, exactly as settings_load() would
+    after scanning storage. The snapshot is checked completely before the
+    first key is applied and cleared once read.
+
+Parameter :
+    None
+
+Return :
+    int : Number of keys restored, -ENOENT if there is no usable snapshot,
+          other negative error code on failure
+
+Example Call :
+    int keys = cache_restore();
+*/
+static int cache_restore(void)
+{
+    char name[SETTINGS_MAX_NAME_LEN + 1];
+    struct cache_hdr hdr;
+    uint32_t cause = 0;
+    size_t off;
+    int err;
+
+    if (!device_is_ready(cache_dev))
+    {
+        return -ENOENT;
+    }
+    if ((hwinfo_get_reset_cause(&cause) != 0) || !(cause & RESET_LOW_POWER_WAKE) ||
+        (retention_is_valid(cache_dev) != 1))
+    {
+        (void)retention_clear(cache_dev);
+        return -ENOENT;
+    }
+
+    err = retention_read(cache_dev, 0, cache_buf, sizeof(hdr));
+    memcpy(&hdr, cache_buf, sizeof(hdr));
+    if (!err && ((hdr.len < sizeof(hdr)) || (hdr.len > sizeof(cache_buf))))
+    {
+        err = -EBADMSG;
+    }
+    if (!err)
+    {
+        err = retention_read(cache_dev, 0, cache_buf, hdr.len);
+    }
+    (void)retention_clear(cache_dev); /* one wake per snapshot */
+    if (err)
+    {
+        return err;
+    }
+
+    /* Check every record before applying any */
+    off = sizeof(hdr);
+    for (uint16_t i = 0; i < hdr.count; i++)
+    {
+        struct cache_rec rec;
+
+        if (off + sizeof(rec) > hdr.len)
+        {
+            return -EBADMSG;
+        }
+        memcpy(&rec, &cache_buf[off], sizeof(rec));
+        off += sizeof(rec) + rec.name_len + rec.value_len;
+        if ((rec.name_len == 0) || (rec.name_len > SETTINGS_MAX_NAME_LEN) || (off > hdr.len))
+        {
+            return -EBADMSG;
+        }
+    }
+
+    off = sizeof(hdr);
+    for (uint16_t i = 0; i < hdr.count; i++)
+    {
+        struct cache_rec rec;
+        const uint8_t *value;
+
+        memcpy(&rec, &cache_buf[off], sizeof(rec));
+        memcpy(name, &cache_buf[off + sizeof(rec)], rec.name_len);
+        name[rec.name_len] = '\0';
+        value = &cache_buf[off + sizeof(rec) + rec.name_len];
+        off += sizeof(rec) + rec.name_len + rec.value_len;
+
+        err = settings_runtime_set(name, value, rec.value_len);
+        if (err)
+        {
+            LOG_DBG("No handler took %s (err %d)", name, err);
+        }
+        entry_seed(name, value, rec.value_len);
+    }
+
+    err = settings_commit();
+    return err ? err : hdr.count;
+}
+#endif
+
+/*
+Function : store_load
+
+Description :
+    Loads settings at boot, called once the Bluetooth stack is enabled.
+    After a wake from system-off the retained snapshot is replayed when
+    valid; otherwise, or if that fails, settings_load() scans storage and
+    the stored application keys are seeded into the write cache, so
+    saving an unchanged value after a cold boot writes nothing either.
+    Logs which path was taken and how long it took.
+
+Parameter :
+    None
+
+Return :
+    int : 0 on success, negative error code on failure
+
+Example Call :
+    store_load();
+*/
+int store_load(void)
+{
+    uint32_t start = k_uptime_get_32();
+    int err = -ENOENT;
+
+#if CONFIG_APP_FAST_BOOT_CACHE
+    err = cache_restore();
+    if (err >= 0)
+    {
+        LOG_INF("Settings restored from retained RAM: %d keys in %u ms\n",
+                err, k_uptime_get_32() - start);
+        return 0;
+    }
+    if (err != -ENOENT)
+    {
+        LOG_WRN("Settings snapshot unusable (err %d), loading storage", err);
+    }
+#endif
+
+    err = settings_load();
+    if (!err)
+    {
+        (void)settings_load_subtree_direct(STORE_ROOT, entry_seed_load, NULL);
+    }
+    LOG_INF("Settings loaded from storage in %u ms\n", k_uptime_get_32() - start);
+    return err;
+}
+
+/*
+Function : store_save
+
+Description :
+    Saves an application settings key. A value equal to the one last
+    stored or loaded is not written; otherwise the value is cached and
+    written with the next batch, CONFIG_APP_STORE_BATCH_MS after the
+    first change of the batch or at store_sync(). Keys or values too large
+    for the cache, or a full cache, are written straight away.
+
+Parameter :
+    key   : Settings key, e.g. "app/host/active"
+    value : Value to store
+    len   : Value length
+
+Return :
+    int : 0 on success, negative error code if a direct write failed
+
+Example Call :
+    store_save("app/host/active", &active_slot, sizeof(active_slot));
+*/
+int store_save(const char *key, const void *value, size_t len)
+{
+    struct store_entry *e = NULL;
+
+    if ((strlen(key) < STORE_KEY_MAX) && (len <= STORE_VALUE_MAX))
+    {
+        k_mutex_lock(&store_lock, K_FOREVER);
+        e = entry_find(key, true);
+        if (e && e->known && (e->len == len) && (memcmp(e->value, value, len) == 0))
+        {
+            k_mutex_unlock(&store_lock);
+            return 0; /* unchanged */
+        }
+        if (e)
+        {
+            memcpy(e->value, value, len);
+            e->len = (uint8_t)len;
+            e->known = true;
+            e->dirty = true;
+        }
+        k_mutex_unlock(&store_lock);
+    }
+
+    if (!e)
+    {
+        return settings_save_one(key, value, len);
+    }
+
+    (void)k_work_schedule(&store_flush_work, K_MSEC(CONFIG_APP_STORE_BATCH_MS));
+    return 0;
+}
+
+/*
+Function : store_sync
+
+Description :
+    Writes the pending batch now and, with CONFIG_APP_FAST_BOOT_CACHE,
+    snapshots the settings storage into retained RAM. Called right before
+    system-off, after the links are down.
+
+Parameter :
+    None
+
+Return :
+    void
+
+Example Call :
+    store_sync();
+*/
+void store_sync(void)
+{
+    (void)k_work_cancel_delayable(&store_flush_work);
+    store_flush();
+#if CONFIG_APP_FAST_BOOT_CACHE
+    cache_snapshot();
+#endif
+}
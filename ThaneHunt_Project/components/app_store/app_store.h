@@ -0,0 +1,31 @@
+/*
+Name : app_store
+
+Description :
+    Settings layer for the BLE HID keyboard. Application keys are written
+    through a batching cache that only stores values that changed. With
+    CONFIG_APP_FAST_BOOT_CACHE a snapshot of the whole settings storage
+    (bonds, host slots, CCCs, ...) is kept in retained RAM across
+    system-off, so a wake restores it without scanning ZMS/NVS.
+
+Date : 2026-10-14
+
+Developer : Engineer Akbar Shah
+*/
+
+#ifndef APP_STORE_H
+#define APP_STORE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#if CONFIG_SETTINGS
+int store_load(void);
+int store_save(const char *key, const void *value, size_t len);
+void store_sync(void);
+#else
+static inline int store_load(void) { return 0; }
+static inline void store_sync(void) {}
+#endif
+
+#endif // APP_STORE_H
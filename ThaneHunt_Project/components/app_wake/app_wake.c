@@ -0,0 +1,170 @@
+/*
+Name : app_wake
+
+Description :
+    Wake context for the BLE HID keyboard. The owning modules keep their
+    resume state in one structure: app_ble the host of the last secured
+    link, app_conn_param the active parameters the central granted, app_imu
+    the sensor state, app_sleep the power tier statistics and app_energy
+    the energy totals. With CONFIG_APP_WAKE_CONTEXT, wake_ctx_save()
+    writes the structure to the wake_context retention area right before
+    system-off. On the wake that follows it is read back at APPLICATION
+    init, before main(), and the area cleared; any other reset, or a
+    context that fails its checksum, starts from zeroes.
+
+Date : 2026-10-14
+
+Developer : Engineer Akbar Shah
+*/
+
+#include <string.h>
+#include <zephyr/device.h>
+#include <zephyr/init.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#if CONFIG_APP_WAKE_CONTEXT
+#include <zephyr/drivers/hwinfo.h>
+#include <zephyr/retention/retention.h>
+#endif
+
+#include "app_wake.h"
+
+LOG_MODULE_REGISTER(APP_WAKE);
+
+static struct wake_ctx wake_ctx; /* all zeroes: host is BT_ADDR_LE_ANY */
+static bool wake_resumed;
+
+#if CONFIG_APP_WAKE_CONTEXT
+#define WAKE_CTX_NODE DT_NODELABEL(wake_context)
+
+BUILD_ASSERT(sizeof(struct wake_ctx) <= (DT_REG_SIZE(WAKE_CTX_NODE) -
+                                          DT_PROP_LEN(WAKE_CTX_NODE, prefix) -
+                                          DT_PROP(WAKE_CTX_NODE, checksum)),
+             "wake_context retention area too small");
+
+static const struct device *const wake_ctx_dev = DEVICE_DT_GET(WAKE_CTX_NODE);
+#endif
+
+/*
+Function : wake_ctx_get
+
+Description :
+    Returns the wake context. Each field is written by its owning module
+    only (see struct wake_ctx); the others may read it at any time.
+
+Parameter :
+    None
+
+Return :
+    struct wake_ctx * : Wake context, never NULL
+
+Example Call :
+    wake_ctx_get()->imu_flags |= WAKE_IMU_ARMED;
+*/
+struct wake_ctx *wake_ctx_get(void)
+{
+    return &wake_ctx;
+}
+
+/*
+Function : wake_ctx_resumed
+
+Description :
+    Tells whether this boot is a wake from system-off that restored the
+    context saved before it, i.e. whether the fast-resume path applies.
+
+Parameter :
+    None
+
+Return :
+    bool : true if the context was restored from retained RAM
+
+Example Call :
+    if (wake_ctx_resumed()) { ... }
+*/
+bool wake_ctx_resumed(void)
+{
+    return wake_resumed;
+}
+
+/*
+Function : wake_ctx_save
+
+Description :
+    Writes the wake context to retained RAM. Called by app_sleep right
+    before sys_poweroff(), once the link is down. Does nothing without
+    CONFIG_APP_WAKE_CONTEXT.
+
+Parameter :
+    None
+
+Return :
+    void
+
+Example Call :
+    wake_ctx_save();
+*/
+void wake_ctx_save(void)
+{
+#if CONFIG_APP_WAKE_CONTEXT
+    int err;
+
+    if (!device_is_ready(wake_ctx_dev))
+    {
+        return;
+    }
+
+    err = retention_write(wake_ctx_dev, 0, (const uint8_t *)&wake_ctx, sizeof(wake_ctx));
+    if (err)
+    {
+        LOG_WRN("Wake context not saved (err %d)", err);
+        (void)retention_clear(wake_ctx_dev);
+    }
+#endif
+}
+
+#if CONFIG_APP_WAKE_CONTEXT
+/*
+Function : wake_ctx_init
+
+Description :
+    Restores the wake context on a wake from system-off if the retention
+    area holds a valid one, then clears the area so that the context is
+    used once. Runs before main(), after the retention driver.
+
+Parameter :
+    None
+
+Return :
+    int : 0 always
+
+Example Call :
+    run by SYS_INIT at APPLICATION level
+*/
+static int wake_ctx_init(void)
+{
+    uint32_t cause = 0;
+
+    if (!device_is_ready(wake_ctx_dev))
+    {
+        LOG_WRN("Wake context area not ready");
+        return 0;
+    }
+
+    if ((hwinfo_get_reset_cause(&cause) == 0) && (cause & RESET_LOW_POWER_WAKE) &&
+        (retention_is_valid(wake_ctx_dev) == 1) &&
+        (retention_read(wake_ctx_dev, 0, (uint8_t *)&wake_ctx, sizeof(wake_ctx)) == 0))
+    {
+        wake_resumed = true;
+    }
+    else
+    {
+        memset(&wake_ctx, 0, sizeof(wake_ctx));
+    }
+    (void)retention_clear(wake_ctx_dev); /* one wake per context */
+    return 0;
+}
+
+SYS_INIT(wake_ctx_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
+#endif
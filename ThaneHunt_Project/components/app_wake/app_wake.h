@@ -0,0 +1,54 @@
+/*
+Name : app_wake
+
+Description :
+    Wake context for the BLE HID keyboard. A few pieces of resume state
+    (host of the last link, connection parameters the central granted,
+    IMU state, power tier and energy statistics) are kept in one structure that each
+    owning module keeps up to date. With CONFIG_APP_WAKE_CONTEXT it is
+    written to retained RAM right before system-off and read back once on
+    the wake that follows, so the modules take a fast-resume path instead
+    of starting from scratch.
+
+Date : 2026-10-14
+
+Developer : Engineer Akbar Shah
+*/
+
+#ifndef APP_WAKE_H
+#define APP_WAKE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <zephyr/bluetooth/addr.h>
+#include <zephyr/sys/util.h>
+
+#include "app_energy.h"
+#include "app_sleep.h"
+
+/* IMU state bits (wake_ctx.imu_flags) */
+#define WAKE_IMU_PRESENT BIT(0) /* WHO_AM_I probe passed */
+#define WAKE_IMU_ARMED BIT(1)   /* wake-on-motion set up, undone by the next init */
+
+/*
+ * Resume state. Every field has a single writer, named below; the
+ * structure is all zeroes on a cold boot. Bump the last prefix byte of
+ * the wake_context retention node when the layout changes.
+ */
+struct wake_ctx
+{
+    bt_addr_le_t host;          /* app_ble: peer of the last secured link, BT_ADDR_LE_ANY if none */
+    bool host_rpa;              /* app_ble: that peer uses a resolvable private address */
+    uint16_t conn_interval;     /* app_conn_param: last active profile parameters applied, */
+    uint16_t conn_latency;      /* 0 interval if none */
+    uint16_t conn_timeout;
+    uint8_t imu_flags;          /* app_imu: WAKE_IMU_* */
+    struct power_stats power;   /* app_sleep: since the last cold boot */
+    struct energy_stats energy; /* app_energy: since the last cold boot */
+};
+
+struct wake_ctx *wake_ctx_get(void);
+bool wake_ctx_resumed(void);
+void wake_ctx_save(void);
+
+#endif // APP_WAKE_H
@@ -0,0 +1,50 @@
+/*
+Name : keymap
+
+Description :
+    Action encodings for the "thanehunt,keymap" devicetree node, shared by
+    the board overlays and app_keymap. Every key action is one 32-bit cell:
+    type in bits [31:24], arguments in the low bits. HID usages come from
+    app_keycodes.h.
+
+Date : 2026-10-14
+
+Developer : Engineer Akbar Shah
+*/
+
+#ifndef DT_BINDINGS_THANEHUNT_KEYMAP_H
+#define DT_BINDINGS_THANEHUNT_KEYMAP_H
+
+#define KM_TYPE_NONE 0
+#define KM_TYPE_KEY 1       /* arg: HID usage */
+#define KM_TYPE_TAP_HOLD 2  /* tap usage [7:0], hold usage [15:8] */
+#define KM_TYPE_LAYER_TAP 3 /* tap usage [7:0], hold layer [15:8] */
+#define KM_TYPE_MO 4        /* momentary layer [7:0] */
+#define KM_TYPE_MACRO 5     /* macro index [7:0] */
+#define KM_TYPE_TRANS 6     /* look through to the next active layer down */
+#define KM_TYPE_CONSUMER 7  /* consumer usage [15:0] */
+#define KM_TYPE_SYSTEM 8    /* system control usage [7:0] */
+
+/* Layer bindings */
+#define KM_NONE 0
+#define KM_KEY(usage) ((KM_TYPE_KEY << 24) | (usage))
+#define KM_TAP_HOLD(hold_usage, tap_usage) ((KM_TYPE_TAP_HOLD << 24) | ((hold_usage) << 8) | (tap_usage))
+#define KM_LAYER_TAP(layer, tap_usage) ((KM_TYPE_LAYER_TAP << 24) | ((layer) << 8) | (tap_usage))
+#define KM_MO(layer) ((KM_TYPE_MO << 24) | (layer))
+#define KM_MACRO(idx) ((KM_TYPE_MACRO << 24) | (idx))
+#define KM_TRANS (KM_TYPE_TRANS << 24)
+#define KM_CONSUMER(usage) ((KM_TYPE_CONSUMER << 24) | (usage))
+#define KM_SYSTEM(usage) ((KM_TYPE_SYSTEM << 24) | (usage))
+
+/* Macro steps */
+#define KM_STEP_PRESS_T 1
+#define KM_STEP_RELEASE_T 2
+#define KM_STEP_TAP_T 3
+#define KM_STEP_WAIT_T 4
+
+#define KM_STEP_PRESS(usage) ((KM_STEP_PRESS_T << 24) | (usage))
+#define KM_STEP_RELEASE(usage) ((KM_STEP_RELEASE_T << 24) | (usage))
+#define KM_STEP_TAP(usage) ((KM_STEP_TAP_T << 24) | (usage))
+#define KM_STEP_WAIT(ms) ((KM_STEP_WAIT_T << 24) | (ms))
+
+#endif /* DT_BINDINGS_THANEHUNT_KEYMAP_H */
@@ -0,0 +1,319 @@
+#!/usr/bin/env python3
+#
+# Host side of the HID benchmark (firmware built with bench.conf).
+#
+#   scripts/hid_bench.py --port /dev/ttyACM0 tap 50 1000
+#   scripts/hid_bench.py --port /dev/ttyACM0 chord 20 500 --width 6
+#   scripts/hid_bench.py --port /dev/ttyACM0 burst 10 200 --width 8
+#
+# Runs on a Linux host paired with the keyboard. It grabs the keyboard's
+# evdev node (so the injected keys do not reach the desktop), starts the
+# run over the shell UART with "bench start", records every key event and
+# HID report with its kernel timestamp, and reports:
+#
+#   * keystroke latency: min/p50/p90/p99/max and a histogram. Host and
+#     device clocks are not synchronised, so latency is measured against
+#     the run's schedule, relative to the fastest keystrokes of the run
+#     (a lower-envelope fit that also removes clock drift). The device's
+#     own injection-to-notification figures ("latency stats") are printed
+#     after the run for the absolute part;
+#   * dropped, unexpected and stuck keys;
+#   * reports per second and keys per report (coalescing).
+#
+# Without --port the run has to be started by hand on the device shell
+# with the same arguments; capture ends after --idle seconds without input.
+#
+# Needs python3-evdev; pyserial for --port. No ordering assumption is
+# made beyond the schedule, so runs can be compared across connection
+# parameter, PHY and coalescing changes.
+
+import argparse
+import select
+import sys
+import time
+
+try:
+    import evdev
+    from evdev import ecodes
+except ImportError:
+    sys.exit("python3-evdev is required (pip install evdev)")
+
+PATTERNS = ("tap", "chord", "burst")
+DEFAULT_KEYS = ",".join("KEY_" + chr(c) for c in range(ord("A"), ord("Z") + 1))
+
+
+def parse_args():
+    p = argparse.ArgumentParser(description="BLE HID keyboard latency/throughput benchmark")
+    p.add_argument("pattern", choices=PATTERNS)
+    p.add_argument("rate", type=int, help="steps per second (1..500)")
+    p.add_argument("count", type=int, help="number of steps")
+    p.add_argument("--width", type=int, default=None,
+                   help="keys per chord / taps per burst (default 6, tap is always 1)")
+    p.add_argument("--hold", type=int, default=20, help="hold time of taps and chords, ms")
+    p.add_argument("--keys", default=DEFAULT_KEYS,
+                   help="evdev key names for key IDs CONFIG_APP_BENCH_KEY_FIRST.. (default A..Z)")
+    p.add_argument("--name", default="ThaneHunt", help="input device name to look for")
+    p.add_argument("--device", help="evdev node, e.g. /dev/input/event7 (overrides --name)")
+    p.add_argument("--port", help="shell UART of the device, e.g. /dev/ttyACM0")
+    p.add_argument("--baud", type=int, default=115200)
+    p.add_argument("--idle", type=float, default=2.0,
+                   help="seconds without input that end the capture")
+    p.add_argument("--csv", help="write per-event latencies to this file")
+    args = p.parse_args()
+    if args.pattern == "tap":
+        args.width = 1
+    elif args.width is None:
+        args.width = 6
+    return args
+
+
+def find_device(args, first_code):
+    if args.device:
+        return evdev.InputDevice(args.device)
+    for path in evdev.list_devices():
+        dev = evdev.InputDevice(path)
+        keys = dev.capabilities().get(ecodes.EV_KEY, [])
+        if args.name.lower() in dev.name.lower() and first_code in keys:
+            return dev
+        dev.close()
+    sys.exit(f"no keyboard input device named like '{args.name}' (connected? try --device)")
+
+
+class Shell:
+    """Minimal line I/O on the Zephyr shell UART."""
+
+    def __init__(self, port, baud):
+        try:
+            import serial
+        except ImportError:
+            sys.exit("pyserial is required for --port (pip install pyserial)")
+        self.ser = serial.Serial(port, baud, timeout=0.1)
+
+    def send(self, line):
+        self.ser.write((line + "\r\n").encode())
+
+    def lines(self, seconds, until=None):
+        """Returns the lines received within the time, stopping early at 'until'."""
+        out = []
+        end = time.monotonic() + seconds
+        buf = b""
+        while time.monotonic() < end:
+            buf += self.ser.read(256)
+            while b"\n" in buf:
+                raw, buf = buf.split(b"\n", 1)
+                line = raw.decode(errors="replace").strip()
+                # Drop the VT100 colour codes of the shell
+                while "\x1b[" in line:
+                    i = line.index("\x1b[")
+                    j = i + 2
+                    while j < len(line) and not line[j].isalpha():
+                        j += 1
+                    line = line[:i] + line[j + 1:]
+                if line:
+                    out.append(line)
+                    if until and until in line:
+                        return out
+        return out
+
+
+def schedule(args, codes):
+    """Expected (time_s, code, value) of the run, time relative to step 0."""
+    period = 1.0 / args.rate
+    hold = args.hold / 1000.0
+    exp = []
+    key = 0
+    for step in range(args.count):
+        base = step * period
+        for _ in range(args.width):
+            code = codes[key % len(codes)]
+            key += 1
+            exp.append((base, code, 1))
+            exp.append((base if args.pattern == "burst" else base + hold, code, 0))
+    return exp
+
+
+def capture(dev, args):
+    """Key events (t, code, value) and the timestamps of reports carrying keys."""
+    events, reports = [], []
+    pending = False
+    last = None
+    # Run length plus time to start it by hand
+    deadline = time.monotonic() + args.count / args.rate + 30.0
+    while time.monotonic() < deadline:
+        r, _, _ = select.select([dev.fd], [], [], 0.1)
+        if not r:
+            if last is not None and time.monotonic() - last > args.idle:
+                break
+            continue
+        for ev in dev.read():
+            if ev.type == ecodes.EV_KEY and ev.value in (0, 1):  # 2 is autorepeat
+                events.append((ev.timestamp(), ev.code, ev.value))
+                pending = True
+                last = time.monotonic()
+            elif ev.type == ecodes.EV_SYN and ev.code == ecodes.SYN_REPORT and pending:
+                reports.append(ev.timestamp())
+                pending = False
+    return events, reports
+
+
+def match(expected, events, cycle_s):
+    """Pairs every observed event with its scheduled one. Returns (pairs, unmatched, unexpected)."""
+    by_kind = {}
+    for i, (t, code, value) in enumerate(expected):
+        by_kind.setdefault((code, value), []).append(i)
+    used = set()
+    pairs, unexpected = [], []
+
+    first_down = next((e for e in events if e[2] == 1), None)
+    if first_down is None:
+        return [], list(range(len(expected))), events
+    cands = by_kind.get((first_down[1], 1), [])
+    if not cands:
+        return [], list(range(len(expected))), events
+    offset = first_down[0] - expected[cands[0]][0]
+
+    for t, code, value in events:
+        best = None
+        for i in by_kind.get((code, value), []):
+            if i in used:
+                continue
+            d = abs(t - offset - expected[i][0])
+            if best is None or d < best[0]:
+                best = (d, i)
+            elif expected[i][0] > t - offset + cycle_s:
+                break
+        if best is None or best[0] > cycle_s / 2:
+            unexpected.append((t, code, value))
+            continue
+        used.add(best[1])
+        pairs.append((best[1], t))
+    unmatched = [i for i in range(len(expected)) if i not in used]
+    return pairs, unmatched, unexpected
+
+
+def baseline(points):
+    """Lower envelope of (sched, delay): least-squares line through the per-second minima."""
+    windows = {}
+    for s, d in points:
+        w = int(s)
+        windows[w] = min(d, windows.get(w, d))
+    if len(windows) < 2:
+        m = min(d for _, d in points)
+        return lambda s: m
+    xs = [w + 0.5 for w in windows]
+    ys = list(windows.values())
+    n = len(xs)
+    mx, my = sum(xs) / n, sum(ys) / n
+    sxx = sum((x - mx) ** 2 for x in xs)
+    b = sum((x - mx) * (y - my) for x, y in zip(xs, ys)) / sxx
+    a = my - b * mx
+    return lambda s: a + b * s
+
+
+def percentile(sorted_vals, pct):
+    """Nearest-rank percentile."""
+    rank = -(-pct * len(sorted_vals) // 100)
+    return sorted_vals[max(0, min(len(sorted_vals), int(rank)) - 1)]
+
+
+def report(args, expected, events, reports, codes):
+    name = {c: ecodes.KEY[c] if isinstance(ecodes.KEY[c], str) else ecodes.KEY[c][0]
+            for c in codes}
+    cycle_s = (len(codes) / args.width) / args.rate
+    pairs, unmatched, unexpected = match(expected, events, cycle_s)
+
+    print(f"\n{args.pattern} x{args.count} at {args.rate} Hz, width {args.width}, "
+          f"hold {args.hold} ms: {len(expected)} events expected, {len(events)} seen")
+    if not pairs:
+        print("no keystrokes matched the schedule")
+        return
+
+    fit = baseline([(expected[i][0], t - expected[i][0]) for i, t in pairs])
+    lat = sorted(((t - expected[i][0]) - fit(expected[i][0])) * 1000.0 for i, t in pairs)
+    lat = [max(0.0, v) for v in lat]
+    print(f"latency above best case, ms: min {lat[0]:.2f}  p50 {percentile(lat, 50):.2f}  "
+          f"p90 {percentile(lat, 90):.2f}  p99 {percentile(lat, 99):.2f}  max {lat[-1]:.2f}")
+
+    edges = [1, 2, 4, 8, 16, 32, 64, 128]
+    counts = [0] * (len(edges) + 1)
+    for v in lat:
+        counts[next((k for k, e in enumerate(edges) if v < e), len(edges))] += 1
+    top = max(counts)
+    for k, c in enumerate(counts):
+        lo = edges[k - 1] if k else 0
+        label = f"{lo:>4}-{edges[k]:<4}" if k < len(edges) else f"{lo:>4}+    "
+        if c:
+            print(f"  {label} ms {c:7d} {'#' * max(1, int(40 * c / top))}")
+
+    downs = sum(1 for i in unmatched if expected[i][2] == 1)
+    print(f"dropped: {downs} presses, {len(unmatched) - downs} releases; "
+          f"unexpected events: {len(unexpected)}")
+
+    state = {}
+    for t, code, value in events:
+        state[code] = value
+    stuck = [name.get(c, str(c)) for c, v in state.items() if v == 1]
+    print(f"stuck keys: {', '.join(stuck) if stuck else 'none'}")
+
+    if len(reports) > 1:
+        span = reports[-1] - reports[0]
+        peak = 0
+        j = 0
+        for i in range(len(reports)):
+            while reports[i] - reports[j] >= 1.0:
+                j += 1
+            peak = max(peak, i - j + 1)
+        print(f"reports: {len(reports)}, {len(reports) / span:.1f}/s (peak {peak}/s), "
+              f"{len(events) / len(reports):.2f} key events per report")
+
+    if args.csv:
+        with open(args.csv, "w") as f:
+            f.write("sched_s,arrival_s,key,value,latency_ms\n")
+            for i, t in pairs:
+                s, code, value = expected[i]
+                f.write(f"{s:.6f},{t:.6f},{name.get(code, code)},{value},"
+                        f"{max(0.0, (t - s - fit(s)) * 1000.0):.3f}\n")
+        print(f"per-event latencies written to {args.csv}")
+
+
+def main():
+    args = parse_args()
+    try:
+        codes = [ecodes.ecodes[k.strip()] for k in args.keys.split(",")]
+    except KeyError as e:
+        sys.exit(f"unknown key name {e}")
+    if args.width > len(codes):
+        sys.exit("width is larger than the key set")
+
+    dev = find_device(args, codes[0])
+    print(f"capturing {dev.path} ({dev.name})")
+    dev.grab()
+
+    shell = None
+    if args.port:
+        shell = Shell(args.port, args.baud)
+        shell.send("bench stop")
+        shell.lines(0.3)
+        shell.send(f"bench start {args.pattern} {args.rate} {args.count} {args.width} {args.hold}")
+    else:
+        print(f"start the run on the device: bench start {args.pattern} {args.rate} "
+              f"{args.count} {args.width} {args.hold}")
+
+    try:
+        events, reports = capture(dev, args)
+    finally:
+        dev.ungrab()
+
+    report(args, schedule(args, codes), events, reports, codes)
+
+    if shell:
+        shell.send("bench stats")
+        shell.send("latency stats")
+        print("\ndevice:")
+        for line in shell.lines(1.0):
+            if not line.startswith(("uart:", "bench ", "latency ")):
+                print("  " + line)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,38 @@
+#!/bin/sh
+#
+# Decodes the dictionary (binary) log output of a log_dictionary.conf build.
+#
+#   scripts/log_decode.sh <build dir> <serial port> [baud rate]   live, from the UART
+#   scripts/log_decode.sh <build dir> -f <captured log file>      offline, raw binary capture
+#
+# The dictionary (log_dictionary.json) is generated by the build and must
+# come from the same build as the firmware on the device.
+
+set -e
+
+if [ -z "$ZEPHYR_BASE" ]; then
+    echo "ZEPHYR_BASE is not set (source zephyr/zephyr-env.sh)" >&2
+    exit 1
+fi
+if [ $# -lt 2 ]; then
+    sed -n '4,5p' "$0" >&2
+    exit 1
+fi
+
+BUILD_DIR=$1
+PARSER_DIR=$ZEPHYR_BASE/scripts/logging/dictionary
+
+# Sysbuild puts the application in a sub-directory named after the project
+DICT=$BUILD_DIR/ThaneHunt_Project/zephyr/log_dictionary.json
+if [ ! -f "$DICT" ]; then
+    DICT=$BUILD_DIR/zephyr/log_dictionary.json
+fi
+if [ ! -f "$DICT" ]; then
+    echo "No log_dictionary.json under $BUILD_DIR (built with log_dictionary.conf?)" >&2
+    exit 1
+fi
+
+if [ "$2" = "-f" ]; then
+    exec python3 "$PARSER_DIR/log_parser.py" "$DICT" "$3"
+fi
+exec python3 "$PARSER_DIR/log_parser_uart.py" "$DICT" "$2" "${3:-115200}"
@@ -5,10 +5,14 @@ Description :
 	Main entry point for the BLE HID keyboard application on Zephyr RTOS.
 	This file coordinates initialization of GPIO buttons/LEDs, the HID
 	service, and the Bluetooth stack. It optionally registers passkey
-	authentication callbacks, starts the button handling thread, and
-	manages system status indicators. The main loop provides LED activity
-	feedback during advertising and simulates periodic battery service
-	updates.
+	authentication callbacks and starts the button handling thread. After
+	init the main thread sleeps on the application event set and only
+	wakes to switch the LED pattern when advertising starts or stops. The
+	IMU has its own acquisition thread and battery measurement runs on its
+	own work item in app_battery. After a wake from system-off the wake
+	context restored before main() puts the modules on their fast-resume
+	path: the wake key is queued, advertising is directed at the last
+	host right away and the IMU skips its probe.
 
 Date : 2025-09-14
 
@@ -18,9 +22,12 @@ Developer : Engineer Akbar Shah
 #include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
 
+#include "app_battery.h"
 #include "app_ble.h"
 #include "app_button.h"
+#include "app_events.h"
 #include "app_hid.h"
+#include "app_wake.h"
 
 #if CONFIG_IMU_LSM6DSO
 #include "app_imu.h"
@@ -34,59 +41,50 @@ int main(void)
 
 	LOG_INF("Starting BLE HIDS keyboard VERSION: [%s]\n\r", CONFIG_PROJECT_VERSION);
 
+	if (wake_ctx_resumed())
+	{
+		const struct power_stats *ps = &wake_ctx_get()->power;
+
+		LOG_INF("Fast resume after system-off #%u: active %u s, idle %u s, connected-sleep %u s\n",
+				ps->off_count, ps->tier_ms[POWER_TIER_ACTIVE] / MSEC_PER_SEC,
+				ps->tier_ms[POWER_TIER_IDLE] / MSEC_PER_SEC,
+				ps->tier_ms[POWER_TIER_CONN_SLEEP] / MSEC_PER_SEC);
+	}
+
+	/* Buttons, LED and the button thread; the thread waits for a secured link */
 	init_user_buttons();
-	k_msleep(100); // Allow time for button GPIOs to stabilize
 
 #if (CONFIG_ENABLE_PASS_KEY_AUTH)
 	err = bt_register_auth_callbacks();
 	if (err)
 		return 0;
 #endif
-	k_msleep(100);
 	hid_init();
-	k_msleep(100);
 	err = enable_bt();
 	if (err)
 		return 0;
 
-	k_msleep(100);
-	button_thread_start();
-
-	k_msleep(100); 
+	err = battery_init();
+	if (err)
+	{
+		LOG_ERR("Battery init failed (err: %d)\n", err);
+	}
 
 #if CONFIG_IMU_LSM6DSO
 	err = imu_lsm6dso_init();
 	if (err != 0)
-		return 0;
+	{
+		LOG_ERR("IMU init failed (err: %d), continuing without IMU\n", err);
+	}
 #endif
-	bool is_led_off = false;
 
 	for (;;)
 	{
-		if (is_adv)
-		{
-			is_led_off = false;
-			user_led_toggle();
-		}
-		else
-		{
-			if (!is_led_off)
-			{
-				is_led_off = true;
-				user_led_turn_off();
-			}
-		}
-#if CONFIG_IMU_LSM6DSO
-		if (imu_power_down)
+		uint32_t events = app_event_wait(APP_EVT_ALL, K_FOREVER);
+
+		if (events & APP_EVT_ADV_STATE)
 		{
-			k_msleep(1000);
-			continue;
+			user_led_pattern_set(is_adv ? LED_PATTERN_BLINK : LED_PATTERN_OFF);
 		}
-		imu_readDisplay_raw_data();
-#endif
-		// 		/* Battery level simulation */
-		bas_notify();
-
-		k_msleep(1000);
 	}
 }